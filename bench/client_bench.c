@@ -0,0 +1,408 @@
+/**
+ * client_bench - round trips through the public API, end to end
+ *
+ * Drives every mss_window_*, mss_space_* and mss_display_* call in
+ * include/mss.h against a running payload or the stand-in daemon (mssd).
+ * Each call is run with one-shot connections, with a persistent session
+ * and pipelined on that session (PIPELINE_DEPTH requests in flight), from
+ * one client thread and from several (one context each). Reports ops/sec,
+ * p50/p99/p999 latency and the socket syscalls the client library issues
+ * per call, as JSON on stdout and as a table on stderr. Pipelined latency
+ * is the time to queue a call; its ops/sec includes waiting for the last
+ * response.
+ *
+ * Space calls reshape the desktop, so they only run with -x (which
+ * make bench passes, since it targets mssd).
+ *
+ * Build & run:
+ *   make bench             (against a private mssd instance)
+ *   make bench-payload     (against the loaded payload)
+ *
+ * Usage:
+ *   client_bench [-s <socket>] [-n <iterations>] [-t <threads>] [-w <wid>] [-x]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "mss.h"
+
+// ============================================================================
+// Syscall accounting
+// ============================================================================
+
+//
+// NOTE: The client library is linked statically into this binary, so these
+// definitions take precedence over libc for every socket call it makes. Each
+// one counts the call on the calling thread and forwards to the real symbol.
+//
+
+static __thread uint64_t syscall_count;
+
+#define interpose(ret, name, params, args) \
+    ret name params \
+    { \
+        static ret (*real) params; \
+        if (!real) real = (ret (*) params) dlsym(RTLD_NEXT, #name); \
+        ++syscall_count; \
+        return real args; \
+    }
+
+interpose(int, socket, (int domain, int type, int protocol), (domain, type, protocol))
+interpose(int, connect, (int fd, const struct sockaddr *addr, socklen_t len), (fd, addr, len))
+interpose(int, setsockopt, (int fd, int level, int name, const void *value, socklen_t len), (fd, level, name, value, len))
+interpose(ssize_t, send, (int fd, const void *buf, size_t len, int flags), (fd, buf, len, flags))
+interpose(ssize_t, recv, (int fd, void *buf, size_t len, int flags), (fd, buf, len, flags))
+interpose(int, shutdown, (int fd, int how), (fd, how))
+interpose(int, close, (int fd), (fd))
+
+// ============================================================================
+// Calls under test
+// ============================================================================
+
+//
+// NOTE: Query outputs live in thread-local storage rather than on the stack,
+// because a pipelined call fills them in after it has returned.
+//
+
+static uint32_t bench_wid = 1;
+
+static bool call_window_move(mss_context *ctx, int i)          { return mss_window_move(ctx, bench_wid, i & 255, 100); }
+static bool call_window_set_opacity(mss_context *ctx, int i)   { return mss_window_set_opacity(ctx, bench_wid, (i & 1) ? 0.9f : 1.0f); }
+static bool call_window_fade_opacity(mss_context *ctx, int i)  { return mss_window_fade_opacity(ctx, bench_wid, (i & 1) ? 0.9f : 1.0f, 0.05f); }
+static bool call_window_set_layer(mss_context *ctx, int i)     { (void) i; return mss_window_set_layer(ctx, bench_wid, MSS_LAYER_NORMAL); }
+static bool call_window_set_sticky(mss_context *ctx, int i)    { (void) i; return mss_window_set_sticky(ctx, bench_wid, false); }
+static bool call_window_set_shadow(mss_context *ctx, int i)    { (void) i; return mss_window_set_shadow(ctx, bench_wid, true); }
+static bool call_window_focus(mss_context *ctx, int i)         { (void) i; return mss_window_focus(ctx, bench_wid); }
+static bool call_window_order(mss_context *ctx, int i)         { (void) i; return mss_window_order(ctx, bench_wid, MSS_ORDER_ABOVE, 0); }
+static bool call_window_resize(mss_context *ctx, int i)        { (void) i; return mss_window_resize(ctx, bench_wid, 800, 600); }
+static bool call_window_set_frame(mss_context *ctx, int i)     { return mss_window_set_frame(ctx, bench_wid, i & 255, 100, 800, 600); }
+static bool call_window_unminimize(mss_context *ctx, int i)    { (void) i; return mss_window_unminimize(ctx, bench_wid); }
+
+static bool call_window_order_in(mss_context *ctx, int i)
+{
+    (void) i;
+    uint32_t window_list[] = { bench_wid };
+    return mss_window_order_in(ctx, window_list, 1);
+}
+
+static bool call_window_swap_proxy_in(mss_context *ctx, int i)
+{
+    (void) i;
+    struct mss_window_animation animation = { bench_wid, 0 };
+    return mss_window_swap_proxy_in(ctx, &animation, 1);
+}
+
+static bool call_window_swap_proxy_out(mss_context *ctx, int i)
+{
+    (void) i;
+    struct mss_window_animation animation = { bench_wid, 0 };
+    return mss_window_swap_proxy_out(ctx, &animation, 1);
+}
+
+static bool call_window_is_minimized(mss_context *ctx, int i)
+{
+    (void) i;
+    static __thread bool result;
+    return mss_window_is_minimized(ctx, bench_wid, &result);
+}
+
+static bool call_window_get_opacity(mss_context *ctx, int i)
+{
+    (void) i;
+    static __thread float opacity;
+    return mss_window_get_opacity(ctx, bench_wid, &opacity);
+}
+
+static bool call_window_get_frame(mss_context *ctx, int i)
+{
+    (void) i;
+    static __thread int x, y, w, h;
+    return mss_window_get_frame(ctx, bench_wid, &x, &y, &w, &h);
+}
+
+static bool call_window_is_sticky(mss_context *ctx, int i)
+{
+    (void) i;
+    static __thread bool sticky;
+    return mss_window_is_sticky(ctx, bench_wid, &sticky);
+}
+
+static bool call_window_get_layer(mss_context *ctx, int i)
+{
+    (void) i;
+    static __thread enum mss_window_layer layer;
+    return mss_window_get_layer(ctx, bench_wid, &layer);
+}
+
+static bool call_window_snapshot(mss_context *ctx, int i)
+{
+    (void) i;
+    uint32_t wids[64];
+    static __thread struct mss_window_state states[64];
+    for (int w = 0; w < 64; ++w) wids[w] = bench_wid + w;
+    return mss_window_snapshot(ctx, wids, 64, states) == MSS_SUCCESS;
+}
+
+static bool call_display_get_count(mss_context *ctx, int i)
+{
+    (void) i;
+    static __thread uint32_t count;
+    return mss_display_get_count(ctx, &count) == MSS_SUCCESS;
+}
+
+static bool call_display_get_list(mss_context *ctx, int i)
+{
+    (void) i;
+    static __thread uint32_t displays[32];
+    return mss_display_get_list(ctx, displays, 32) == MSS_SUCCESS;
+}
+
+static bool call_get_stats(mss_context *ctx, int i)
+{
+    (void) i;
+    static __thread struct mss_stats stats;
+    return mss_get_stats(ctx, &stats) == MSS_SUCCESS;
+}
+
+// Space ids as laid out by mssd: 1..n on the first display
+static bool call_space_focus(mss_context *ctx, int i)          { return mss_space_focus(ctx, 1 + (i & 1)); }
+static bool call_space_create(mss_context *ctx, int i)         { (void) i; return mss_space_create(ctx, 1); }
+static bool call_space_destroy(mss_context *ctx, int i)        { (void) i; return mss_space_destroy(ctx, 0xffff); }
+static bool call_space_move(mss_context *ctx, int i)           { (void) i; return mss_space_move(ctx, 0xffff, 1, 0, false); }
+static bool call_window_move_to_space(mss_context *ctx, int i) { return mss_window_move_to_space(ctx, bench_wid, 1 + (i & 1)); }
+
+static bool call_window_list_move_to_space(mss_context *ctx, int i)
+{
+    uint32_t window_list[] = { bench_wid };
+    return mss_window_list_move_to_space(ctx, window_list, 1, 1 + (i & 1));
+}
+
+struct bench_call
+{
+    const char *name;
+    bool (*run)(mss_context *ctx, int i);
+    bool reshapes;
+};
+
+#define bench_call(name, reshapes) { "mss_" #name, call_##name, reshapes }
+
+static const struct bench_call calls[] = {
+    bench_call(window_move, false),
+    bench_call(window_set_opacity, false),
+    bench_call(window_fade_opacity, false),
+    bench_call(window_set_layer, false),
+    bench_call(window_set_sticky, false),
+    bench_call(window_set_shadow, false),
+    bench_call(window_focus, false),
+    bench_call(window_order, false),
+    bench_call(window_order_in, false),
+    bench_call(window_resize, false),
+    bench_call(window_set_frame, false),
+    bench_call(window_unminimize, false),
+    bench_call(window_swap_proxy_in, false),
+    bench_call(window_swap_proxy_out, false),
+    bench_call(window_is_minimized, false),
+    bench_call(window_get_opacity, false),
+    bench_call(window_get_frame, false),
+    bench_call(window_is_sticky, false),
+    bench_call(window_get_layer, false),
+    bench_call(window_snapshot, false),
+    bench_call(display_get_count, false),
+    bench_call(display_get_list, false),
+    bench_call(get_stats, false),
+    bench_call(window_move_to_space, true),
+    bench_call(window_list_move_to_space, true),
+    bench_call(space_focus, true),
+    bench_call(space_create, true),
+    bench_call(space_destroy, true),
+    bench_call(space_move, true),
+};
+
+// ============================================================================
+// Runner
+// ============================================================================
+
+#define PIPELINE_DEPTH 64
+
+enum bench_mode
+{
+    MODE_ONESHOT,
+    MODE_SESSION,
+    MODE_PIPELINE,
+};
+
+static const char *mode_names[] = { "oneshot", "session", "pipeline" };
+
+static const char *socket_path;
+static int iterations = 5000;
+
+struct worker
+{
+    pthread_t thread;
+    const struct bench_call *call;
+    enum bench_mode mode;
+    double *latency;
+    uint64_t syscalls;
+    int failures;
+};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *worker_proc(void *data)
+{
+    struct worker *worker = data;
+
+    mss_context *ctx = mss_create(socket_path);
+    if (!ctx) {
+        worker->failures = iterations;
+        return NULL;
+    }
+
+    if (worker->mode != MODE_ONESHOT) mss_set_persistent(ctx, true);
+    if (worker->mode == MODE_PIPELINE && mss_pipeline_begin(ctx, PIPELINE_DEPTH) != MSS_SUCCESS) ++worker->failures;
+
+    syscall_count = 0;
+    for (int i = 0; i < iterations; ++i) {
+        double start = now_ns();
+        if (!worker->call->run(ctx, i)) ++worker->failures;
+        worker->latency[i] = now_ns() - start;
+    }
+    if (worker->mode == MODE_PIPELINE && mss_pipeline_end(ctx) != MSS_SUCCESS) ++worker->failures;
+    worker->syscalls = syscall_count;
+
+    mss_destroy(ctx);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double p)
+{
+    int index = (int)(p * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+static bool run_case(const struct bench_call *call, enum bench_mode mode, int threads, bool first)
+{
+    int total = iterations * threads;
+    struct worker workers[threads];
+    double *latency = malloc(sizeof(double) * total);
+
+    double start = now_ns();
+    for (int t = 0; t < threads; ++t) {
+        workers[t] = (struct worker) { .call = call, .mode = mode, .latency = latency + (size_t) t * iterations };
+        pthread_create(&workers[t].thread, NULL, &worker_proc, &workers[t]);
+    }
+
+    uint64_t syscalls = 0;
+    int failures = 0;
+    for (int t = 0; t < threads; ++t) {
+        pthread_join(workers[t].thread, NULL);
+        syscalls += workers[t].syscalls;
+        failures += workers[t].failures;
+    }
+    double elapsed = now_ns() - start;
+
+    qsort(latency, total, sizeof(double), compare_double);
+
+    double ops_per_sec = total / (elapsed / 1e9);
+    double p50 = percentile(latency, total, 0.50) / 1e3;
+    double p99 = percentile(latency, total, 0.99) / 1e3;
+    double p999 = percentile(latency, total, 0.999) / 1e3;
+    double syscalls_per_op = (double) syscalls / total;
+    printf("%s    {\"call\": \"%s\", \"mode\": \"%s\", \"threads\": %d, \"ops\": %d, \"failures\": %d, "
+           "\"ops_per_sec\": %.0f, \"p50_us\": %.2f, \"p99_us\": %.2f, \"p999_us\": %.2f, \"syscalls_per_op\": %.2f}",
+           first ? "" : ",\n", call->name, mode_names[mode], threads, total, failures, ops_per_sec, p50, p99, p999, syscalls_per_op);
+
+    fprintf(stderr, "%-34s %-8s %2d %10.0f %9.1f %9.1f %9.1f %8.2f%s\n",
+            call->name, mode_names[mode], threads, ops_per_sec, p50, p99, p999, syscalls_per_op, failures ? "  FAILED" : "");
+
+    free(latency);
+    return failures == 0;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-s <socket>] [-n <iterations>] [-t <threads>] [-w <wid>] [-x]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 4;
+    bool reshape = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            bench_wid = (uint32_t) strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-x") == 0) {
+            reshape = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (iterations < 1 || threads < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    mss_context *ctx = mss_create(socket_path);
+    uint32_t capabilities = 0;
+    const char *version = NULL;
+    if (!ctx || mss_handshake(ctx, &capabilities, &version) != MSS_SUCCESS) {
+        fprintf(stderr, "could not reach payload at %s\n", ctx ? mss_get_socket_path(ctx) : "(default socket)");
+        return 1;
+    }
+
+    printf("{\n  \"client_version\": \"%s\",\n  \"payload_version\": \"%s\",\n  \"socket\": \"%s\",\n"
+           "  \"iterations\": %d,\n  \"threads\": %d,\n  \"results\": [\n",
+           MSS_VERSION, version, mss_get_socket_path(ctx), iterations, threads);
+    mss_destroy(ctx);
+
+    fprintf(stderr, "%-34s %-8s %2s %10s %9s %9s %9s %8s\n", "call", "mode", "t", "ops/s", "p50 us", "p99 us", "p999 us", "sys/op");
+
+    bool ok = true;
+    bool first = true;
+    int thread_counts[] = { 1, threads };
+    int variants = threads > 1 ? 2 : 1;
+
+    for (int c = 0; c < (int)(sizeof(calls) / sizeof(*calls)); ++c) {
+        if (calls[c].reshapes && !reshape) continue;
+
+        for (int v = 0; v < variants; ++v) {
+            for (int mode = MODE_ONESHOT; mode <= MODE_PIPELINE; ++mode) {
+                ok &= run_case(&calls[c], mode, thread_counts[v], first);
+                first = false;
+            }
+        }
+    }
+
+    printf("\n  ]\n}\n");
+    return ok ? 0 : 1;
+}
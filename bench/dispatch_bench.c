@@ -0,0 +1,309 @@
+/**
+ * dispatch_bench - daemon dispatch and fades against the fake compositor
+ *
+ * Runs the payload's message handlers (src/daemon.c) on Linux with the
+ * in-memory backend from src/fake_backend.c. Every opcode is first checked
+ * for its effect on the fake compositor and its response frame, then timed
+ * through dispatch_message.
+ * A last pass starts a fade on a set of windows and reports how many frames
+ * (backend commits) the animation thread needed to finish them.
+ *
+ * Build & run:
+ *   make bench-dispatch
+ */
+
+#include "daemon.c"
+#include "fake_backend.c"
+
+#define WINDOWS     512
+#define DISPLAYS    2
+#define SPACES      4
+#define ITERATIONS  200000
+
+struct message
+{
+    char bytes[256];
+    int length;
+};
+
+static int query_fd;
+static int peer_fd;
+static int failures;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void message_begin(struct message *message, enum sa_opcode op)
+{
+    message->bytes[0] = op;
+    message->length = 1;
+}
+
+static void message_put(struct message *message, const void *data, int length)
+{
+    memcpy(message->bytes + message->length, data, length);
+    message->length += length;
+}
+
+#define put(message, v) do { __typeof__(v) _v = (v); message_put(message, &_v, sizeof(_v)); } while (0)
+
+static struct sa_response_header response;
+static char response_payload[0x20000];
+
+// Dispatches a message and reads its response back off the socket pair
+static int run(struct message *message)
+{
+    struct client_connection conn = { .sockfd = query_fd };
+    dispatch_message(&conn, message->bytes, message->length);
+
+    socket_recv_all(peer_fd, &response, sizeof(response));
+    socket_recv_all(peer_fd, response_payload, response.length);
+    return response.status;
+}
+
+// Runs a query and returns the length of its payload, copied into result
+static int query(struct message *message, void *result, int length)
+{
+    if (run(message) != SA_STATUS_OK) return -1;
+    if ((int) response.length < length) length = response.length;
+    memcpy(result, response_payload, length);
+    return response.length;
+}
+
+static void check(bool condition, const char *what)
+{
+    if (!condition) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+static void verify(void)
+{
+    struct message m;
+    struct fake_window w;
+
+    message_begin(&m, SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 7); put(&m, (int) 120); put(&m, (int) 45);
+    run(&m);
+    check(fake_window_state(7, &w) && w.frame.x == 120 && w.frame.y == 45, "window move");
+
+    message_begin(&m, SA_OPCODE_WINDOW_OPACITY); put(&m, (uint32_t) 7); put(&m, 0.25f);
+    run(&m);
+    check(fake_window_state(7, &w) && w.alpha == 0.25f, "window opacity");
+
+    message_begin(&m, SA_OPCODE_WINDOW_LAYER); put(&m, (uint32_t) 7); put(&m, (int) 5);
+    run(&m);
+    check(fake_window_state(7, &w) && w.level == 3, "window layer (floating)");
+
+    message_begin(&m, SA_OPCODE_WINDOW_STICKY); put(&m, (uint32_t) 7); put(&m, (bool) true);
+    run(&m);
+    uint8_t sticky = 0;
+    message_begin(&m, SA_OPCODE_WINDOW_IS_STICKY); put(&m, (uint32_t) 7);
+    check(query(&m, &sticky, sizeof(sticky)) == 1 && sticky == 1, "window sticky");
+
+    message_begin(&m, SA_OPCODE_WINDOW_SHADOW); put(&m, (uint32_t) 7); put(&m, (bool) false);
+    run(&m);
+    check(fake_window_state(7, &w) && (w.tags & (1 << 3)), "window shadow off");
+
+    message_begin(&m, SA_OPCODE_WINDOW_MINIMIZE); put(&m, (uint32_t) 7);
+    run(&m);
+    uint8_t minimized = 0;
+    message_begin(&m, SA_OPCODE_WINDOW_IS_MINIMIZED); put(&m, (uint32_t) 7);
+    check(query(&m, &minimized, sizeof(minimized)) == 1 && minimized == 1, "window minimize");
+
+    message_begin(&m, SA_OPCODE_WINDOW_UNMINIMIZE); put(&m, (uint32_t) 7);
+    run(&m);
+    check(fake_window_state(7, &w) && w.ordered_in, "window unminimize");
+
+    message_begin(&m, SA_OPCODE_WINDOW_ORDER); put(&m, (uint32_t) 3); put(&m, (int) 1); put(&m, (uint32_t) 9);
+    run(&m);
+    struct fake_window above, below;
+    check(fake_window_state(3, &above) && fake_window_state(9, &below) && above.z > below.z, "window order above");
+
+    int frame[4] = {};
+    message_begin(&m, SA_OPCODE_WINDOW_GET_FRAME); put(&m, (uint32_t) 7);
+    check(query(&m, frame, sizeof(frame)) == sizeof(frame) && frame[0] == 120 && frame[1] == 45 && frame[2] == 800, "window get frame");
+
+    char snapshot[sizeof(uint32_t) + 3 * sizeof(struct sa_window_record)];
+    struct sa_window_record record;
+    message_begin(&m, SA_OPCODE_WINDOW_SNAPSHOT); put(&m, (uint32_t) 3); put(&m, (uint32_t) 7); put(&m, (uint32_t) 99999); put(&m, (uint32_t) 9);
+    check(query(&m, snapshot, sizeof(snapshot)) == sizeof(snapshot), "window snapshot size");
+    memcpy(&record, snapshot + sizeof(uint32_t), sizeof(record));
+    check(record.wid == 7 && record.x == 120 && record.alpha == 0.25f && record.level == 3 && (record.tags & 0x800) && record.ordered_in, "window snapshot record");
+    memcpy(&record, snapshot + sizeof(uint32_t) + sizeof(record), sizeof(record));
+    check(record.wid == 0, "window snapshot unknown wid");
+
+    uint32_t displays[33] = {};
+    message_begin(&m, SA_OPCODE_DISPLAY_GET_LIST); put(&m, (uint32_t) 32);
+    check(query(&m, displays, sizeof(displays)) == (int) sizeof(uint32_t) * (1 + DISPLAYS) && displays[0] == DISPLAYS, "display list");
+
+    uint64_t space = 0;
+    message_begin(&m, SA_OPCODE_DISPLAY_GET_SPACE); put(&m, (uint32_t) 0x1001);
+    check(query(&m, &space, sizeof(space)) == sizeof(space) && space == fake_display_current_space(1), "display current space");
+
+    uint64_t generation = 0, moved = 0;
+    message_begin(&m, SA_OPCODE_WINDOW_GENERATION);
+    query(&m, &generation, sizeof(generation));
+    struct message move;
+    message_begin(&move, SA_OPCODE_WINDOW_MOVE); put(&move, (uint32_t) 7); put(&move, (int) 120); put(&move, (int) 45);
+    run(&move);
+    check(query(&m, &moved, sizeof(moved)) == sizeof(moved) && generation == 0 && moved == 0, "window generation unknown without a state page");
+
+    struct sa_stats stats;
+    message_begin(&m, SA_OPCODE_STATS);
+    check(query(&m, &stats, sizeof(stats)) == sizeof(stats) && stats.lane_count == 0, "stats (no lanes without a listener)");
+
+    message_begin(&m, SA_OPCODE_WINDOW_TO_SPACE); put(&m, (uint64_t) 3); put(&m, (uint32_t) 7);
+    run(&m);
+    check(fake_window_state(7, &w) && w.sid == 3, "window to space");
+
+    message_begin(&m, SA_OPCODE_SPACE_FOCUS); put(&m, (uint64_t) 3);
+    run(&m);
+    check(fake_display_current_space(0) == 3, "space focus");
+
+    message_begin(&m, SA_OPCODE_SPACE_DESTROY); put(&m, (uint64_t) 3);
+    run(&m);
+    check(fake_display_current_space(0) != 3 && fake_window_state(7, &w) && w.sid != 3, "space destroy");
+
+    message_begin(&m, SA_OPCODE_SPACE_MOVE); put(&m, (uint64_t) 2); put(&m, (uint64_t) 5); put(&m, (uint64_t) 0); put(&m, (bool) true);
+    run(&m);
+    check(fake_display_current_space(1) == 2, "space move to other display");
+
+    // One transaction: both moves land in a single commit
+    uint64_t commits = fake_commits();
+    message_begin(&m, SA_OPCODE_WINDOW_TRANSACTION); put(&m, (int) 2);
+    put(&m, (int16_t) 13); put(&m, (char) SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 10); put(&m, (int) 1); put(&m, (int) 2);
+    put(&m, (int16_t) 13); put(&m, (char) SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 11); put(&m, (int) 3); put(&m, (int) 4);
+    run(&m);
+    struct fake_window a, b;
+    check(fake_window_state(10, &a) && fake_window_state(11, &b) && a.frame.x == 1 && b.frame.y == 4 && fake_commits() == commits + 1, "window transaction");
+
+    // Every response is framed, and malformed requests are rejected unapplied
+    message_begin(&m, SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 7); put(&m, (int) 1); put(&m, (int) 1);
+    check(run(&m) == SA_STATUS_OK && response.version == SA_PROTOCOL_VERSION && response.length == 0, "mutation acknowledged");
+
+    message_begin(&m, SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 7); put(&m, (int) 500);
+    check(run(&m) == SA_STATUS_BAD_REQUEST && fake_window_state(7, &w) && w.frame.x == 1, "truncated request rejected");
+
+    message_begin(&m, (enum sa_opcode) 0x7F);
+    check(run(&m) == SA_STATUS_UNKNOWN_OPCODE, "unknown opcode rejected");
+
+    message_begin(&m, SA_OPCODE_WINDOW_SNAPSHOT); put(&m, (uint32_t) SA_SNAPSHOT_MAX + 1);
+    check(run(&m) == SA_STATUS_BAD_REQUEST, "oversized snapshot rejected");
+
+    message_begin(&m, SA_OPCODE_SUBSCRIBE); put(&m, (uint32_t) SA_EVENT_ALL); put(&m, (uint32_t) 2); put(&m, (uint32_t) 7);
+    check(run(&m) == SA_STATUS_BAD_REQUEST, "truncated subscribe rejected");
+
+    message_begin(&m, SA_OPCODE_WINDOW_TRANSACTION); put(&m, (int) 2);
+    put(&m, (int16_t) 13); put(&m, (char) SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 10); put(&m, (int) 5); put(&m, (int) 5);
+    put(&m, (int16_t) 9); put(&m, (char) SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 11); put(&m, (int) 5);
+    check(run(&m) == SA_STATUS_BAD_REQUEST && fake_window_state(10, &a) && a.frame.x == 1, "malformed transaction rejected whole");
+
+    message_begin(&m, SA_OPCODE_WINDOW_TRANSACTION); put(&m, (int) 2);
+    put(&m, (int16_t) 13); put(&m, (char) SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 10); put(&m, (int) 5); put(&m, (int) 5);
+    put(&m, (int16_t) 1); put(&m, (char) SA_OPCODE_HANDSHAKE);
+    check(run(&m) == SA_STATUS_BAD_REQUEST && fake_window_state(10, &a) && a.frame.x == 1, "transaction with a non-window operation rejected");
+}
+
+static void bench_op(const char *name, struct message *message)
+{
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        run(message);
+    }
+    double ns = now_ns() - start;
+
+    printf("  %-22s %8.1f ns/op\n", name, ns / ITERATIONS);
+}
+
+static void bench_dispatch(void)
+{
+    struct message m;
+
+    printf("\ndispatch_message, %d windows\n", WINDOWS);
+
+    message_begin(&m, SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t) 42); put(&m, (int) 10); put(&m, (int) 20);
+    bench_op("window move", &m);
+
+    message_begin(&m, SA_OPCODE_WINDOW_OPACITY); put(&m, (uint32_t) 42); put(&m, 0.5f);
+    bench_op("window opacity", &m);
+
+    message_begin(&m, SA_OPCODE_WINDOW_LAYER); put(&m, (uint32_t) 42); put(&m, (int) 4);
+    bench_op("window layer", &m);
+
+    message_begin(&m, SA_OPCODE_WINDOW_ORDER); put(&m, (uint32_t) 42); put(&m, (int) 1); put(&m, (uint32_t) 0);
+    bench_op("window order", &m);
+
+    message_begin(&m, SA_OPCODE_WINDOW_GET_FRAME); put(&m, (uint32_t) 42);
+    bench_op("window get frame", &m);
+
+    message_begin(&m, SA_OPCODE_WINDOW_TRANSACTION); put(&m, (int) 8);
+    for (int i = 0; i < 8; ++i) {
+        put(&m, (int16_t) 13); put(&m, (char) SA_OPCODE_WINDOW_MOVE); put(&m, (uint32_t)(100 + i)); put(&m, (int) i); put(&m, (int) i);
+    }
+    bench_op("transaction (8 moves)", &m);
+}
+
+static void bench_fade(int count, float duration)
+{
+    struct message m;
+    uint64_t commits = fake_commits();
+
+    double start = now_ns();
+    for (int i = 0; i < count; ++i) {
+        message_begin(&m, SA_OPCODE_WINDOW_OPACITY_FADE); put(&m, (uint32_t)(i + 1)); put(&m, 0.0f); put(&m, duration);
+        run(&m);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&window_fade_lock);
+        int active = window_fade_count;
+        pthread_mutex_unlock(&window_fade_lock);
+        if (!active) break;
+        usleep(1000);
+    }
+    double ns = now_ns() - start;
+
+    bool done = true;
+    for (int i = 0; i < count; ++i) {
+        struct fake_window w;
+        if (!fake_window_state(i + 1, &w) || w.alpha != 0.0f) done = false;
+    }
+    check(done, "fade reaches target alpha");
+
+    printf("  %4d windows, %3.0f ms fade  %7.1f ms  %4llu frames\n", count, duration * 1000.0f, ns / 1e6, (unsigned long long)(fake_commits() - commits));
+}
+
+int main(void)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+        perror("socketpair");
+        return 1;
+    }
+    query_fd = fds[0];
+    peer_fd = fds[1];
+
+    fake_backend_init(WINDOWS, DISPLAYS, SPACES);
+    daemon_start(&fake_backend, false);
+
+    verify();
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("backend '%s': all checks passed\n", fake_backend.name);
+
+    bench_dispatch();
+
+    printf("\nfades (one animation thread, one commit per frame)\n");
+    bench_fade(1, 0.2f);
+    bench_fade(64, 0.2f);
+    bench_fade(WINDOWS, 0.2f);
+
+    return failures ? 1 : 0;
+}
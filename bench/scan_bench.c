@@ -0,0 +1,319 @@
+/**
+ * scan_bench - byte-at-a-time hex_find_seq vs sigscan.h
+ *
+ * Scans a synthetic code-like buffer the size of the payload's search
+ * window (0x1286a0 bytes) for real x86_64 and arm64 Dock signatures,
+ * planted near the end, and for a signature that is absent. Every variant
+ * must agree with the reference loop before it is timed. A second pass
+ * resolves the whole set over overlapping windows (as init_instances does)
+ * one signature at a time and with sig_scan_all, first warm and then cold:
+ * from a fresh file mapping per round, so every page touched is faulted
+ * in as it would be in a Dock that has not run that code yet. Times are
+ * reported against both the byte loop and the memchr scalar path. Runs on
+ * Linux.
+ *
+ * Build & run:
+ *   make bench-scan
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#define SIGSCAN_IMPLEMENTATION
+#include "sigscan.h"
+#undef SIGSCAN_IMPLEMENTATION
+
+#define WINDOW 0x1286a0
+
+static const char *patterns[] = {
+    "?? ?? ?? 00 48 8B 38 48 8B 35 ?? ?? ?? 00 89 DA 41 FF D5 48 89 C7 E8 ?? ?? ?? 00 49 89 C7 48 8B 35 ?? ?? ?? 00 48 89",
+    "?? ?? ?? 00 49 8B 3E 48 8B 35 A0 DD 2B 00 44 89 A5 78 FE FF FF 44 89 E2 49 89 DC FF D3 48 89 C7 E8 C5 66 1E 00 48 89 85 F8 FD FF FF",
+    "?8 ?? ?? ?? 08 ?? ?? 91 00 01 40 F9 E2 03 13 AA ?? ?? ?? 94 ?? ?? ?? ?? 08",
+    "?? 12 00 ?? ?? ?? ?? 91 ?? 02 40 F9 ?? ?? 00 B4 ?? ?? ?? ??",
+    "36 16 00 ?? D6 ?? ?? 91 ?? 02 40 F9 ?? ?? 00 B4 ?? 03 14 AA",
+};
+
+// The original payload loop, bounded the same way
+static const uint8_t *reference_find(const uint8_t *base, const char *c_pattern)
+{
+    uint64_t pattern_length = (strlen(c_pattern) + 1) / 3;
+    char buffer_a[pattern_length];
+    char buffer_b[pattern_length];
+    memset(buffer_a, 0, sizeof(buffer_a));
+    memset(buffer_b, 0, sizeof(buffer_b));
+
+    char *pattern = (char *) c_pattern + 1;
+    for (uint64_t i = 0; i < pattern_length; ++i) {
+        char c = pattern[-1];
+        if (c == '?') {
+            buffer_b[i] = 1;
+        } else {
+            int temp = c <= '9' ? 0 : 9;
+            temp = (temp + c) << 0x4;
+            c = pattern[0];
+            int temp2 = c <= '9' ? 0xd0 : 0xc9;
+            buffer_a[i] = temp2 + c + temp;
+        }
+        pattern += 3;
+    }
+
+    const uint8_t *addr = base;
+loop:
+    for (uint64_t counter = 0; counter < pattern_length; ++counter) {
+        if ((buffer_b[counter] == 0) && (((char *)addr)[counter] != buffer_a[counter])) {
+            addr = addr + 1;
+            if ((uint64_t)(addr - base) < WINDOW) {
+                goto loop;
+            } else {
+                return NULL;
+            }
+        }
+    }
+
+    return addr;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rng_state = 0x9E3779B9;
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Roughly code-shaped: half the bytes come from a small set of common opcodes
+static void fill_code(uint8_t *buffer, size_t size)
+{
+    static const uint8_t common[] = { 0x00, 0xFF, 0x48, 0x89, 0x8B, 0x0F, 0xE8, 0x4C, 0xF9, 0x91, 0xAA, 0x94, 0x40, 0x03 };
+    for (size_t i = 0; i < size; ++i) {
+        uint32_t r = rng();
+        buffer[i] = (r & 1) ? common[(r >> 8) % sizeof(common)] : (uint8_t)(r >> 16);
+    }
+}
+
+static void plant(uint8_t *at, const struct sig_pattern *sig)
+{
+    for (int i = 0; i < sig->length; ++i) {
+        at[i] = (at[i] & ~sig->mask[i]) | sig->bytes[i];
+    }
+}
+
+typedef const uint8_t *(*scan_func)(const struct sig_pattern *sig, const char *pattern, const uint8_t *data, size_t size);
+
+static const uint8_t *run_reference(const struct sig_pattern *sig, const char *pattern, const uint8_t *data, size_t size)
+{
+    (void) sig; (void) size;
+    return reference_find(data, pattern);
+}
+
+static const uint8_t *run_scalar(const struct sig_pattern *sig, const char *pattern, const uint8_t *data, size_t size)
+{
+    (void) pattern;
+    return sig_scan_scalar(sig, data, 0, size - sig->length + 1);
+}
+
+static const uint8_t *run_dispatch(const struct sig_pattern *sig, const char *pattern, const uint8_t *data, size_t size)
+{
+    (void) pattern;
+    return sig_scan(sig, data, size);
+}
+
+#if defined(__aarch64__)
+static const uint8_t *run_neon(const struct sig_pattern *sig, const char *pattern, const uint8_t *data, size_t size)
+{
+    (void) pattern;
+    return sig_scan_neon(sig, data, size - sig->length + 1);
+}
+#endif
+
+static long minor_faults(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+//
+// Resolves the set from a new private mapping of fd each round, either one
+// signature at a time or with sig_scan_all. Returns ns per round and stores
+// minor faults per round.
+//
+static double cold_set(int fd, size_t size, struct sig_target *targets, int count, bool together, int rounds, long *faults)
+{
+    double elapsed = 0;
+    long faulted = 0;
+
+    for (int r = 0; r < rounds; ++r) {
+        const uint8_t *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
+
+        long before = minor_faults();
+        double start = now_ns();
+        if (together) {
+            sig_scan_all(targets, count, base);
+        } else {
+            for (int i = 0; i < count; ++i) {
+                sig_scan(&targets[i].sig, base + targets[i].offset, targets[i].window + targets[i].sig.length - 1);
+            }
+        }
+        elapsed += now_ns() - start;
+        faulted += minor_faults() - before;
+
+        munmap((void *) base, size);
+    }
+
+    *faults = faulted / rounds;
+    return elapsed / rounds;
+}
+
+struct variant
+{
+    const char *name;
+    scan_func func;
+};
+
+static void bench_set(void)
+{
+    // Window offsets shaped like the arm64 Sequoia table: mostly overlapping
+    static const uint64_t offsets[] = { 0x1f0000, 0x250000, 0x250000, 0x1c0000, 0x250000 };
+    int count = sizeof(patterns) / sizeof(*patterns);
+    size_t size = 0x250000 + WINDOW + SIG_PATTERN_MAX;
+    uint8_t *buffer = malloc(size);
+    struct sig_target targets[sizeof(patterns) / sizeof(*patterns)];
+    int rounds = 20;
+
+    fill_code(buffer, size);
+    for (int i = 0; i < count; ++i) {
+        targets[i] = (struct sig_target) { .name = patterns[i], .offset = offsets[i], .window = WINDOW };
+        sig_parse(&targets[i].sig, patterns[i]);
+        plant(buffer + offsets[i] + WINDOW - 0x2000 * (i + 1), &targets[i].sig);
+    }
+
+    int64_t expected[sizeof(patterns) / sizeof(*patterns)];
+    double start = now_ns();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < count; ++i) {
+            const uint8_t *match = sig_scan(&targets[i].sig, buffer + offsets[i], WINDOW + targets[i].sig.length - 1);
+            expected[i] = match ? match - buffer : -1;
+        }
+    }
+    double separate = (now_ns() - start) / rounds;
+
+    uint64_t swept = 0;
+    start = now_ns();
+    for (int r = 0; r < rounds; ++r) {
+        swept = sig_scan_all(targets, count, buffer);
+    }
+    double together = (now_ns() - start) / rounds;
+
+    for (int i = 0; i < count; ++i) {
+        if (targets[i].hit != expected[i]) {
+            fprintf(stderr, "sig_scan_all disagrees on pattern %d (%lld vs %lld)\n", i, (long long) targets[i].hit, (long long) expected[i]);
+            exit(1);
+        }
+    }
+
+    printf("\n%d signatures, overlapping windows\n", count);
+    printf("  one at a time  %9.1f us  (%d x 0x%x bytes)\n", separate / 1e3, count, WINDOW);
+    printf("  sig_scan_all   %9.1f us  (0x%llx bytes swept) %5.1fx\n", together / 1e3, (unsigned long long) swept, separate / together);
+
+    char path[] = "/tmp/scan_bench.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1 || write(fd, buffer, size) != (ssize_t) size) {
+        perror("scan_bench temp file");
+        exit(1);
+    }
+    unlink(path);
+
+    long separate_faults, together_faults;
+    separate = cold_set(fd, size, targets, count, false, rounds, &separate_faults);
+    together = cold_set(fd, size, targets, count, true, rounds, &together_faults);
+    close(fd);
+
+    printf("\n%d signatures, overlapping windows, fresh mapping per round\n", count);
+    printf("  one at a time  %9.1f us  (%ld page faults)\n", separate / 1e3, separate_faults);
+    printf("  sig_scan_all   %9.1f us  (%ld page faults) %5.1fx\n", together / 1e3, together_faults, separate / together);
+
+    free(buffer);
+}
+
+int main(void)
+{
+    struct variant variants[8];
+    int variant_count = 0;
+
+    variants[variant_count++] = (struct variant) { "reference", run_reference };
+    variants[variant_count++] = (struct variant) { "scalar", run_scalar };
+#if defined(__aarch64__)
+    variants[variant_count++] = (struct variant) { "neon", run_neon };
+#endif
+    variants[variant_count++] = (struct variant) { "sig_scan", run_dispatch };
+
+    int pattern_count = sizeof(patterns) / sizeof(*patterns);
+    size_t size = WINDOW + SIG_PATTERN_MAX;
+    uint8_t *buffer = malloc(size);
+    int rounds = 20;
+
+    printf("%-8s %-6s %-10s %12s %10s %10s\n", "pattern", "case", "variant", "time", "vs loop", "vs memchr");
+    for (int p = 0; p < pattern_count; ++p) {
+        struct sig_pattern sig;
+        if (!sig_parse(&sig, patterns[p])) {
+            fprintf(stderr, "failed to parse pattern %d\n", p);
+            return 1;
+        }
+
+        size_t scan_size = WINDOW + sig.length - 1;
+
+        for (int planted = 1; planted >= 0; --planted) {
+            fill_code(buffer, size);
+            if (planted) plant(buffer + WINDOW - 0x1000 - p, &sig);
+
+            const uint8_t *expected = reference_find(buffer, patterns[p]);
+            double baseline = 0;
+            double scalar = 0;
+
+            for (int v = 0; v < variant_count; ++v) {
+                const uint8_t *result = variants[v].func(&sig, patterns[p], buffer, scan_size);
+                if (result != expected) {
+                    fprintf(stderr, "%s disagrees with reference on pattern %d (%td vs %td)\n",
+                            variants[v].name, p, result ? result - buffer : -1, expected ? expected - buffer : -1);
+                    return 1;
+                }
+
+                double start = now_ns();
+                for (int r = 0; r < rounds; ++r) {
+                    if (!variants[v].func(&sig, patterns[p], buffer, scan_size) != !expected) return 1;
+                }
+                double ns = (now_ns() - start) / rounds;
+                if (v == 0) baseline = ns;
+                if (v == 1) scalar = ns;
+
+                printf("%-8d %-6s %-10s %9.1f us %9.1fx", p, planted ? "hit" : "miss", variants[v].name, ns / 1e3, baseline / ns);
+                if (v) printf(" %9.2fx", scalar / ns);
+                printf("\n");
+            }
+        }
+    }
+
+    free(buffer);
+    bench_set();
+    return 0;
+}
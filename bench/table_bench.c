@@ -0,0 +1,215 @@
+/**
+ * table_bench - chained hashtable.h vs flat wid_table.h
+ *
+ * Measures insert, hit lookup, miss lookup and insert/remove churn for
+ * window-id keyed tables of several sizes. Portable; runs on Linux.
+ *
+ * Build & run:
+ *   make bench-table
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#define HASHTABLE_IMPLEMENTATION
+#include "hashtable.h"
+#undef HASHTABLE_IMPLEMENTATION
+
+#define WID_TABLE_IMPLEMENTATION
+#include "wid_table.h"
+#undef WID_TABLE_IMPLEMENTATION
+
+static TABLE_HASH_FUNC(hash_wid)
+{
+    return *(uint32_t *) key;
+}
+
+static TABLE_COMPARE_FUNC(compare_wid)
+{
+    return *(uint32_t *) key_a == *(uint32_t *) key_b;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rng_state = 0x12345678;
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Window ids are small, mostly increasing integers
+static void make_wids(uint32_t *wids, int count, uint32_t base)
+{
+    uint32_t wid = base;
+    for (int i = 0; i < count; ++i) {
+        wid += 1 + (rng() % 7);
+        wids[i] = wid;
+    }
+    for (int i = count - 1; i > 0; --i) {
+        int j = rng() % (i + 1);
+        uint32_t tmp = wids[i]; wids[i] = wids[j]; wids[j] = tmp;
+    }
+}
+
+static volatile uintptr_t sink;
+
+static void report(const char *table, int size, const char *op, double ns, long ops)
+{
+    printf("%-10s %6d  %-8s %8.2f ns/op\n", table, size, op, ns / ops);
+}
+
+static void bench_chained(uint32_t *wids, uint32_t *misses, int count, int rounds)
+{
+    struct table table;
+    double start, ns;
+
+    start = now_ns();
+    for (int r = 0; r < rounds; ++r) {
+        table_init(&table, 150, hash_wid, compare_wid);
+        for (int i = 0; i < count; ++i) table_add(&table, &wids[i], &wids[i]);
+        if (r != rounds - 1) table_free(&table);
+    }
+    ns = now_ns() - start;
+    report("chained", count, "insert", ns, (long) rounds * count);
+
+    start = now_ns();
+    for (int r = 0; r < rounds * 4; ++r) {
+        for (int i = 0; i < count; ++i) sink += (uintptr_t) table_find(&table, &wids[i]);
+    }
+    ns = now_ns() - start;
+    report("chained", count, "hit", ns, (long) rounds * 4 * count);
+
+    start = now_ns();
+    for (int r = 0; r < rounds * 4; ++r) {
+        for (int i = 0; i < count; ++i) sink += (uintptr_t) table_find(&table, &misses[i]);
+    }
+    ns = now_ns() - start;
+    report("chained", count, "miss", ns, (long) rounds * 4 * count);
+
+    start = now_ns();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < count; ++i) {
+            table_remove(&table, &wids[i]);
+            table_add(&table, &misses[i], &misses[i]);
+        }
+        for (int i = 0; i < count; ++i) {
+            table_remove(&table, &misses[i]);
+            table_add(&table, &wids[i], &wids[i]);
+        }
+    }
+    ns = now_ns() - start;
+    report("chained", count, "churn", ns, (long) rounds * 4 * count);
+
+    table_free(&table);
+}
+
+static void bench_flat(uint32_t *wids, uint32_t *misses, int count, int rounds)
+{
+    struct wid_table table;
+    double start, ns;
+
+    start = now_ns();
+    for (int r = 0; r < rounds; ++r) {
+        wid_table_init(&table, 150, sizeof(void *));
+        for (int i = 0; i < count; ++i) {
+            void *value = &wids[i];
+            wid_table_add(&table, wids[i], &value);
+        }
+        if (r != rounds - 1) wid_table_free(&table);
+    }
+    ns = now_ns() - start;
+    report("flat", count, "insert", ns, (long) rounds * count);
+
+    start = now_ns();
+    for (int r = 0; r < rounds * 4; ++r) {
+        for (int i = 0; i < count; ++i) sink += (uintptr_t) wid_table_find(&table, wids[i]);
+    }
+    ns = now_ns() - start;
+    report("flat", count, "hit", ns, (long) rounds * 4 * count);
+
+    start = now_ns();
+    for (int r = 0; r < rounds * 4; ++r) {
+        for (int i = 0; i < count; ++i) sink += (uintptr_t) wid_table_find(&table, misses[i]);
+    }
+    ns = now_ns() - start;
+    report("flat", count, "miss", ns, (long) rounds * 4 * count);
+
+    start = now_ns();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < count; ++i) {
+            void *value = &misses[i];
+            wid_table_remove(&table, wids[i]);
+            wid_table_add(&table, misses[i], &value);
+        }
+        for (int i = 0; i < count; ++i) {
+            void *value = &wids[i];
+            wid_table_remove(&table, misses[i]);
+            wid_table_add(&table, wids[i], &value);
+        }
+    }
+    ns = now_ns() - start;
+    report("flat", count, "churn", ns, (long) rounds * 4 * count);
+
+    wid_table_free(&table);
+}
+
+static bool verify(uint32_t *wids, uint32_t *misses, int count)
+{
+    struct wid_table table;
+    wid_table_init(&table, 8, sizeof(uint32_t));
+
+    for (int i = 0; i < count; ++i) wid_table_add(&table, wids[i], &wids[i]);
+    for (int i = 0; i < count; i += 2) wid_table_remove(&table, wids[i]);
+
+    bool ok = table.count == count / 2;
+    for (int i = 0; i < count && ok; ++i) {
+        uint32_t *value = wid_table_find(&table, wids[i]);
+        ok = (i % 2) ? (value && *value == wids[i]) : !value;
+        ok = ok && !wid_table_find(&table, misses[i]);
+    }
+
+    wid_table_free(&table);
+    return ok;
+}
+
+int main(void)
+{
+    int sizes[] = { 16, 64, 256, 1024, 4096 };
+
+    printf("%-10s %6s  %-8s %14s\n", "table", "size", "op", "time");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s) {
+        int count = sizes[s];
+        int rounds = 2000000 / count;
+
+        uint32_t *wids = malloc(sizeof(uint32_t) * count);
+        uint32_t *misses = malloc(sizeof(uint32_t) * count);
+        make_wids(wids, count, 100);
+        make_wids(misses, count, 0x1000000);
+
+        if (!verify(wids, misses, count)) {
+            fprintf(stderr, "wid_table verification failed for size %d\n", count);
+            return 1;
+        }
+
+        bench_chained(wids, misses, count, rounds);
+        bench_flat(wids, misses, count, rounds);
+        printf("\n");
+
+        free(wids);
+        free(misses);
+    }
+
+    return 0;
+}
@@ -54,13 +54,104 @@ void mss_destroy(mss_context *ctx);
  */
 const char *mss_get_socket_path(mss_context *ctx);
 
+/**
+ * Enable or disable persistent connection mode.
+ *
+ * By default every call opens, uses and closes its own socket. In persistent
+ * mode the context keeps a single session with the payload open and sends all
+ * calls over it, reconnecting transparently if Dock.app restarts.
+ *
+ * @param ctx Context
+ * @param persistent true to keep a long-lived connection, false to close it
+ * @return MSS_SUCCESS, or MSS_ERROR_CONNECTION if the session could not be
+ *         opened yet (it will be retried on the next call)
+ */
+int mss_set_persistent(mss_context *ctx, bool persistent);
+
+/**
+ * Answer queries from the payload's shared state page when it can.
+ *
+ * The payload publishes the frame, opacity, level, tags and ordering it
+ * last set or read for each window, and the displays with their current
+ * spaces, in a page clients map read-only. With local reads on,
+ * mss_window_get_frame(), mss_window_get_opacity(), mss_window_get_layer(),
+ * mss_window_is_sticky(), mss_window_is_minimized() and the display queries
+ * return a published value without a round trip if it is at most max_age_ms
+ * old, and ask the payload otherwise. The page only changes when the payload
+ * learns something, so the bound also limits how long a change made outside
+ * mss (e.g. the user dragging a window) can go unseen.
+ *
+ * @param ctx Context
+ * @param max_age_ms Oldest value to accept, in milliseconds; 0 turns local
+ *        reads off (the default)
+ * @return MSS_SUCCESS or error code
+ */
+int mss_set_local_reads(mss_context *ctx, uint32_t max_age_ms);
+
+/**
+ * Cache the answers to window queries in the context.
+ *
+ * With the read cache on, mss_window_get_frame(), mss_window_get_opacity(),
+ * mss_window_get_layer() and mss_window_is_sticky() answer from the cache
+ * when they can. The first of them in each layout pass (see
+ * mss_read_cache_begin()) makes one round trip to check that no window has
+ * changed since the cache was filled, and empties it if one has; the rest
+ * of the pass trusts it. Frames carry over between passes in which nothing
+ * changed, other attributes are read again each pass. The context's own
+ * mutations drop the windows they touch.
+ *
+ * @param ctx Context
+ * @param enabled true to turn the cache on; false turns it off and frees it
+ * @return MSS_SUCCESS or error code
+ */
+int mss_set_read_cache(mss_context *ctx, bool enabled);
+
+/**
+ * Start a layout pass: the next cached query checks the cache against the
+ * payload again. Call it before every pass, or cached answers are trusted
+ * indefinitely.
+ *
+ * @param ctx Context
+ */
+void mss_read_cache_begin(mss_context *ctx);
+
+/**
+ * Start pipelining calls on a persistent context.
+ *
+ * Until mss_pipeline_end(), every call returns as soon as its request is
+ * sent, with up to depth requests in flight on the session. Their responses
+ * are matched up as they arrive, in any order. A true or MSS_SUCCESS result
+ * only means the request was sent. Query outputs (and snapshot states) are
+ * written when their response arrives, so they must stay valid, and must not
+ * be read, until mss_pipeline_end() returns.
+ *
+ * @param ctx Context, in persistent mode
+ * @param depth Most requests in flight at once (1-1024)
+ * @return MSS_SUCCESS, or MSS_ERROR_INVALID_ARG if ctx is not persistent,
+ *         depth is out of range or a pipeline is already open
+ */
+int mss_pipeline_begin(mss_context *ctx, int depth);
+
+/**
+ * Wait for every pipelined request and leave pipelining mode.
+ *
+ * Requests lost with the session are not retried, since they may or may not
+ * have been applied.
+ *
+ * @param ctx Context
+ * @return MSS_SUCCESS if every request since mss_pipeline_begin() succeeded,
+ *         otherwise the first error
+ */
+int mss_pipeline_end(mss_context *ctx);
+
 /**
  * Get SA capabilities from handshake.
  *
  * @param ctx Context
  * @param capabilities Output for capability flags (MSS_CAP_*)
  * @param version Output for SA version string (do not free)
- * @return MSS_SUCCESS or error code
+ * @return MSS_SUCCESS or error code; MSS_ERROR_PROTOCOL means the running
+ *         payload predates this library and has to be reloaded
  */
 int mss_handshake(mss_context *ctx, uint32_t *capabilities, const char **version);
 
@@ -387,6 +478,21 @@ bool mss_window_is_sticky(mss_context *ctx, uint32_t wid, bool *sticky);
 bool mss_window_get_layer(mss_context *ctx, uint32_t wid,
                                  enum mss_window_layer *layer);
 
+/**
+ * Get frame, opacity, level, tags and ordering for many windows at once.
+ *
+ * Replaces one get_frame/get_opacity/get_layer/is_sticky/is_minimized
+ * round trip per window with a single request (one per 4096 windows).
+ *
+ * @param ctx Context
+ * @param wids Window IDs
+ * @param count Number of window IDs
+ * @param states Output array of count entries, in the order of wids
+ * @return MSS_SUCCESS or error code
+ */
+int mss_window_snapshot(mss_context *ctx, const uint32_t *wids, int count,
+                        struct mss_window_state *states);
+
 
 // ============================================================================
 // Window Animation (Advanced)
@@ -419,6 +525,139 @@ bool mss_window_swap_proxy_out(mss_context *ctx,
                                      int count);
 
 
+// ============================================================================
+// Batch Operations
+// ============================================================================
+
+/**
+ * Create a batch builder.
+ *
+ * Operations added to a batch are recorded locally and sent together by
+ * mss_batch_commit(), where the payload executes them in order within a
+ * single request. N operations cost one connection and one acknowledgement
+ * instead of N round trips.
+ *
+ * @param ctx Context the batch is sent through
+ * @return New batch or NULL on failure
+ */
+mss_batch *mss_batch_create(mss_context *ctx);
+
+/**
+ * Destroy a batch builder. Operations that were not committed are dropped.
+ *
+ * @param batch Batch to destroy
+ */
+void mss_batch_destroy(mss_batch *batch);
+
+/**
+ * Get the number of operations waiting to be committed.
+ *
+ * @param batch Batch
+ * @return Pending operation count
+ */
+int mss_batch_count(mss_batch *batch);
+
+/**
+ * Send all pending operations and reset the batch for reuse.
+ * Very large batches are split transparently at the message size limit.
+ *
+ * @param batch Batch
+ * @return true if every operation was delivered, false otherwise
+ */
+bool mss_batch_commit(mss_batch *batch);
+
+/**
+ * Drop all pending operations without sending them.
+ *
+ * @param batch Batch
+ */
+void mss_batch_clear(mss_batch *batch);
+
+/**
+ * Batched equivalents of the window and space operations above.
+ * Each records the operation and returns true; nothing is sent until
+ * mss_batch_commit() is called.
+ */
+bool mss_batch_window_move(mss_batch *batch, uint32_t wid, int x, int y);
+bool mss_batch_window_set_opacity(mss_batch *batch, uint32_t wid, float opacity);
+bool mss_batch_window_fade_opacity(mss_batch *batch, uint32_t wid,
+                                   float opacity, float duration);
+bool mss_batch_window_set_layer(mss_batch *batch, uint32_t wid,
+                                enum mss_window_layer layer);
+bool mss_batch_window_set_sticky(mss_batch *batch, uint32_t wid, bool sticky);
+bool mss_batch_window_set_shadow(mss_batch *batch, uint32_t wid, bool shadow);
+bool mss_batch_window_order(mss_batch *batch, uint32_t wid,
+                            enum mss_window_order order, uint32_t relative_wid);
+bool mss_batch_window_move_to_space(mss_batch *batch, uint32_t wid, uint64_t sid);
+bool mss_batch_window_resize(mss_batch *batch, uint32_t wid, int width, int height);
+bool mss_batch_window_set_frame(mss_batch *batch, uint32_t wid,
+                                int x, int y, int width, int height);
+bool mss_batch_window_minimize(mss_batch *batch, uint32_t wid);
+bool mss_batch_window_unminimize(mss_batch *batch, uint32_t wid);
+bool mss_batch_space_focus(mss_batch *batch, uint64_t sid);
+
+// ============================================================================
+// Window Transactions
+// ============================================================================
+
+/**
+ * Begin an atomic window transaction.
+ *
+ * Moves, opacity, ordering and layer changes recorded on a transaction are
+ * applied by the payload as one SkyLight transaction when committed, so a
+ * whole layout change lands in a single compositor frame instead of being
+ * torn across several.
+ *
+ * @param ctx Context the transaction is sent through
+ * @return New transaction or NULL on failure
+ */
+mss_txn *mss_txn_begin(mss_context *ctx);
+
+/**
+ * Record a window move. See mss_window_move().
+ *
+ * @return true if recorded, false if the transaction is full
+ */
+bool mss_txn_move(mss_txn *txn, uint32_t wid, int x, int y);
+
+/**
+ * Record an instant opacity change. See mss_window_set_opacity().
+ *
+ * @return true if recorded, false if the transaction is full
+ */
+bool mss_txn_set_opacity(mss_txn *txn, uint32_t wid, float opacity);
+
+/**
+ * Record a window ordering change. See mss_window_order().
+ *
+ * @return true if recorded, false if the transaction is full
+ */
+bool mss_txn_order(mss_txn *txn, uint32_t wid,
+                   enum mss_window_order order, uint32_t relative_wid);
+
+/**
+ * Record a window layer change. See mss_window_set_layer().
+ *
+ * @return true if recorded, false if the transaction is full
+ */
+bool mss_txn_set_layer(mss_txn *txn, uint32_t wid, enum mss_window_layer layer);
+
+/**
+ * Apply all recorded changes atomically and free the transaction.
+ * A transaction that overflowed the message size limit is not applied.
+ *
+ * @param txn Transaction (invalid after this call)
+ * @return true on success, false on failure
+ */
+bool mss_txn_commit(mss_txn *txn);
+
+/**
+ * Discard a transaction without applying it.
+ *
+ * @param txn Transaction (invalid after this call)
+ */
+void mss_txn_abort(mss_txn *txn);
+
 // ============================================================================
 // Display Operations
 // ============================================================================
@@ -442,6 +681,226 @@ int mss_display_get_count(mss_context *ctx, uint32_t *count);
  */
 int mss_display_get_list(mss_context *ctx, uint32_t *displays, size_t max_count);
 
+/**
+ * Get the space currently shown on a display.
+ *
+ * @param ctx Context
+ * @param did Display ID
+ * @param sid Output for the space ID, 0 if the display is unknown
+ * @return MSS_SUCCESS or error code
+ */
+int mss_display_get_current_space(mss_context *ctx, uint32_t did, uint64_t *sid);
+
+// ============================================================================
+// Diagnostics
+// ============================================================================
+
+/**
+ * Get the payload's request execution counters.
+ *
+ * The payload runs requests for different windows on parallel lanes and
+ * keeps requests for the same window in order on one lane. Deep or
+ * contended lanes point at hot windows; many barrier waits point at
+ * batches, transactions or snapshots stalling every lane. Cache misses
+ * count window queries that had to reach SkyLight.
+ *
+ * @param ctx Context
+ * @param stats Output for the counters
+ * @return MSS_SUCCESS or error code
+ */
+int mss_get_stats(mss_context *ctx, struct mss_stats *stats);
+
+// ============================================================================
+// Asynchronous Operations
+// ============================================================================
+
+/**
+ * Completion callback for asynchronous calls.
+ *
+ * @param ctx Context the call was made on
+ * @param result MSS_SUCCESS or error code; query outputs are valid only on
+ *        MSS_SUCCESS
+ * @param userdata Value passed with the call
+ */
+typedef void (*mss_completion_callback)(mss_context *ctx, int result, void *userdata);
+
+/**
+ * Get a descriptor to watch for asynchronous completions.
+ *
+ * Asynchronous calls need a persistent context. Add this descriptor to the
+ * run loop (kqueue, CFFileDescriptor, dispatch source, ...) and call
+ * mss_async_dispatch() whenever it becomes readable. The descriptor changes
+ * when the session is re-established, which a callback sees as
+ * MSS_ERROR_CONNECTION; fetch it again then.
+ *
+ * @param ctx Context, in persistent mode
+ * @return Descriptor, or -1 if there is no session
+ */
+int mss_async_fd(mss_context *ctx);
+
+/**
+ * Read the responses that have arrived, without blocking, and run the
+ * callbacks of the calls they complete.
+ *
+ * Callbacks only run on the thread driving the context: here, in
+ * mss_async_wait(), or before any other call on the context returns if that
+ * call had to read responses. They may issue further calls on the context.
+ *
+ * @param ctx Context
+ * @return Number of callbacks run, or a negative error code
+ */
+int mss_async_dispatch(mss_context *ctx);
+
+/**
+ * Block until every asynchronous call has completed and run their callbacks.
+ *
+ * @param ctx Context
+ * @return Number of callbacks run, or a negative error code
+ */
+int mss_async_wait(mss_context *ctx);
+
+/**
+ * Asynchronous equivalents of the calls above.
+ *
+ * Each sends its request and returns without waiting for the payload. If
+ * it returns true, callback runs exactly once, unless the context is
+ * destroyed first; if it returns false, callback never runs. Query outputs
+ * are written before the callback runs and must stay valid until then. Up to
+ * 64 calls can be in flight (or the pipeline depth, if higher); beyond that
+ * a call waits for the oldest to complete.
+ */
+bool mss_space_create_async(mss_context *ctx, uint64_t sid,
+                            mss_completion_callback callback, void *userdata);
+bool mss_space_destroy_async(mss_context *ctx, uint64_t sid,
+                             mss_completion_callback callback, void *userdata);
+bool mss_space_focus_async(mss_context *ctx, uint64_t sid,
+                           mss_completion_callback callback, void *userdata);
+bool mss_space_move_async(mss_context *ctx, uint64_t src_sid, uint64_t dst_sid,
+                          uint64_t src_prev_sid, bool focus,
+                          mss_completion_callback callback, void *userdata);
+bool mss_window_move_async(mss_context *ctx, uint32_t wid, int x, int y,
+                           mss_completion_callback callback, void *userdata);
+bool mss_window_set_opacity_async(mss_context *ctx, uint32_t wid, float opacity,
+                                  mss_completion_callback callback, void *userdata);
+bool mss_window_fade_opacity_async(mss_context *ctx, uint32_t wid, float opacity, float duration,
+                                   mss_completion_callback callback, void *userdata);
+bool mss_window_set_layer_async(mss_context *ctx, uint32_t wid, enum mss_window_layer layer,
+                                mss_completion_callback callback, void *userdata);
+bool mss_window_set_sticky_async(mss_context *ctx, uint32_t wid, bool sticky,
+                                 mss_completion_callback callback, void *userdata);
+bool mss_window_set_shadow_async(mss_context *ctx, uint32_t wid, bool shadow,
+                                 mss_completion_callback callback, void *userdata);
+bool mss_window_focus_async(mss_context *ctx, uint32_t wid,
+                            mss_completion_callback callback, void *userdata);
+bool mss_window_scale_async(mss_context *ctx, uint32_t wid, float x, float y, float w, float h,
+                            mss_completion_callback callback, void *userdata);
+bool mss_window_order_async(mss_context *ctx, uint32_t wid,
+                            enum mss_window_order order, uint32_t relative_wid,
+                            mss_completion_callback callback, void *userdata);
+bool mss_window_order_in_async(mss_context *ctx, uint32_t *window_list, int count,
+                               mss_completion_callback callback, void *userdata);
+bool mss_window_move_to_space_async(mss_context *ctx, uint32_t wid, uint64_t sid,
+                                    mss_completion_callback callback, void *userdata);
+bool mss_window_list_move_to_space_async(mss_context *ctx, uint32_t *window_list, int count, uint64_t sid,
+                                         mss_completion_callback callback, void *userdata);
+bool mss_window_resize_async(mss_context *ctx, uint32_t wid, int width, int height,
+                             mss_completion_callback callback, void *userdata);
+bool mss_window_set_frame_async(mss_context *ctx, uint32_t wid, int x, int y, int width, int height,
+                                mss_completion_callback callback, void *userdata);
+bool mss_window_minimize_async(mss_context *ctx, uint32_t wid,
+                               mss_completion_callback callback, void *userdata);
+bool mss_window_unminimize_async(mss_context *ctx, uint32_t wid,
+                                 mss_completion_callback callback, void *userdata);
+bool mss_window_swap_proxy_in_async(mss_context *ctx, struct mss_window_animation *animations, int count,
+                                    mss_completion_callback callback, void *userdata);
+bool mss_window_swap_proxy_out_async(mss_context *ctx, struct mss_window_animation *animations, int count,
+                                     mss_completion_callback callback, void *userdata);
+bool mss_window_is_minimized_async(mss_context *ctx, uint32_t wid, bool *result,
+                                   mss_completion_callback callback, void *userdata);
+bool mss_window_get_opacity_async(mss_context *ctx, uint32_t wid, float *opacity,
+                                  mss_completion_callback callback, void *userdata);
+bool mss_window_get_frame_async(mss_context *ctx, uint32_t wid, int *x, int *y, int *width, int *height,
+                                mss_completion_callback callback, void *userdata);
+bool mss_window_is_sticky_async(mss_context *ctx, uint32_t wid, bool *sticky,
+                                mss_completion_callback callback, void *userdata);
+bool mss_window_get_layer_async(mss_context *ctx, uint32_t wid, enum mss_window_layer *layer,
+                                mss_completion_callback callback, void *userdata);
+bool mss_window_snapshot_async(mss_context *ctx, const uint32_t *wids, int count,   // count <= 4096
+                               struct mss_window_state *states,
+                               mss_completion_callback callback, void *userdata);
+bool mss_display_get_count_async(mss_context *ctx, uint32_t *count,
+                                 mss_completion_callback callback, void *userdata);
+bool mss_display_get_list_async(mss_context *ctx, uint32_t *displays, size_t max_count,
+                                mss_completion_callback callback, void *userdata);
+bool mss_batch_commit_async(mss_batch *batch, mss_completion_callback callback, void *userdata);
+bool mss_txn_commit_async(mss_txn *txn, mss_completion_callback callback, void *userdata);
+
+// ============================================================================
+// Change Notifications
+// ============================================================================
+
+/**
+ * Callback for changes delivered by a subscription.
+ *
+ * @param ctx Context the subscription belongs to
+ * @param event What changed; valid for the duration of the call
+ * @param userdata Value passed to mss_subscribe()
+ */
+typedef void (*mss_event_callback)(mss_context *ctx, const struct mss_event *event, void *userdata);
+
+/**
+ * Subscribe to window, space and display changes instead of polling.
+ *
+ * Opens a connection on which the payload pushes an event whenever a
+ * listed window moves, resizes, is ordered in or out or changes opacity,
+ * whenever a display switches space and whenever displays or their spaces
+ * are rearranged. Changes are merged per window and per display and sent at
+ * most once per frame, so a burst costs one event per window; query the
+ * window afterwards (local reads, see mss_set_local_reads(), are refreshed
+ * by the same changes). Opacity changes are only seen when made through
+ * mss. A context has one subscription; subscribing again replaces it.
+ *
+ * Works on one-shot and persistent contexts alike. Watch
+ * mss_subscription_fd() and call mss_subscription_dispatch() when it
+ * becomes readable.
+ *
+ * @param ctx Context
+ * @param events MSS_EVENT_* bits wanted
+ * @param wids Windows whose window events are wanted (may be NULL if count is 0)
+ * @param count Number of windows, up to about 8000
+ * @param callback Called for each event
+ * @param userdata Passed to callback
+ * @return MSS_SUCCESS or error code
+ */
+int mss_subscribe(mss_context *ctx, uint32_t events, const uint32_t *wids, int count,
+                  mss_event_callback callback, void *userdata);
+
+/**
+ * Get the descriptor to watch for events.
+ *
+ * @param ctx Context
+ * @return Descriptor, or -1 if there is no subscription
+ */
+int mss_subscription_fd(mss_context *ctx);
+
+/**
+ * Read the events that have arrived, without blocking, and run the callback
+ * for each.
+ *
+ * @param ctx Context
+ * @return Number of events delivered, or a negative error code; on
+ *         MSS_ERROR_CONNECTION the subscription is gone (e.g. Dock.app
+ *         restarted) and must be made again
+ */
+int mss_subscription_dispatch(mss_context *ctx);
+
+/**
+ * End the subscription, if any.
+ *
+ * @param ctx Context
+ */
+void mss_unsubscribe(mss_context *ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,6 +13,58 @@ struct mss_window_animation {
     uint32_t proxy_wid;
 };
 
+// Window state returned by mss_window_snapshot()
+struct mss_window_state {
+    uint32_t wid;       // 0 if the window does not exist
+    int x, y;
+    int width, height;
+    float opacity;
+    int level;          // Window level, as reported by mss_window_get_layer()
+    uint64_t tags;      // Window tags (0x800 = sticky)
+    bool ordered_in;    // false when minimized / ordered out
+};
+
+// Most execution lanes reported by mss_get_stats()
+#define MSS_LANE_MAX 8
+
+// Counters for one payload execution lane
+struct mss_lane_stats {
+    uint64_t executed;      // Requests run on the lane
+    uint64_t contended;     // Times the lane lock was already held
+    uint32_t depth;         // Requests queued or running right now
+    uint32_t max_depth;     // Most requests ever queued at once
+};
+
+// Payload execution counters returned by mss_get_stats()
+struct mss_stats {
+    uint32_t lane_count;
+    uint64_t barriers;      // Multi-window requests, run across every lane
+    uint64_t barrier_waits; // Times a lane stalled on one of them
+    struct mss_lane_stats lanes[MSS_LANE_MAX];
+    uint64_t coalesced_moves;   // Moves superseded before they were applied
+    uint64_t coalesced_frames;  // Set_frames superseded before they were applied
+    uint64_t event_reports;     // Changes reported while anyone was subscribed
+    uint64_t events_sent;       // Events sent to subscribers, at most one per window per frame
+    uint64_t cache_hits;        // Window queries the payload answered from its attribute cache
+    uint64_t cache_misses;      // Window queries the payload read from SkyLight
+};
+
+// Change kinds delivered by mss_subscribe(); one event may carry several
+#define MSS_EVENT_WINDOW_MOVED      0x01
+#define MSS_EVENT_WINDOW_RESIZED    0x02
+#define MSS_EVENT_WINDOW_ORDERED    0x04    // Ordered in or out, minimized, closed
+#define MSS_EVENT_WINDOW_ALPHA      0x08
+#define MSS_EVENT_SPACE_CHANGED     0x10    // A display shows another space
+#define MSS_EVENT_DISPLAY_CHANGED   0x20    // Displays or their spaces were rearranged
+#define MSS_EVENT_ALL               0x3F
+
+// A change delivered by mss_subscribe()
+struct mss_event {
+    uint32_t events;    // MSS_EVENT_* bits
+    uint32_t id;        // Window id, or display id for space and display events
+    uint64_t sid;       // MSS_EVENT_SPACE_CHANGED: the space the display shows now
+};
+
 // Window layer levels
 enum mss_window_layer {
     MSS_LAYER_BELOW  = 3,   // kCGBackstopMenuLevel
@@ -37,7 +89,8 @@ enum mss_error {
     MSS_ERROR_LOAD        = -5,   // Loading failed
     MSS_ERROR_NOT_LOADED  = -6,   // SA not loaded
     MSS_ERROR_OPERATION   = -7,   // Operation failed
-    MSS_ERROR_INVALID_ARG = -8    // Invalid argument
+    MSS_ERROR_INVALID_ARG = -8,   // Invalid argument
+    MSS_ERROR_PROTOCOL    = -9    // Payload speaks another protocol version
 };
 
 // Capability flags (from handshake)
@@ -53,4 +106,10 @@ enum mss_error {
 // Opaque context structure (defined in client.m)
 typedef struct mss_context mss_context;
 
+// Opaque batch builder (defined in client.m)
+typedef struct mss_batch mss_batch;
+
+// Opaque window transaction (defined in client.m)
+typedef struct mss_txn mss_txn;
+
 #endif
@@ -0,0 +1,88 @@
+#ifndef SA_BACKEND_H
+#define SA_BACKEND_H
+
+//
+// Compositor backend used by the daemon (src/daemon.c).
+//
+// Every window, space and display operation the message handlers perform
+// goes through one of these function tables. The payload installs the
+// SkyLight backend (payload.m); src/fake_backend.c provides an in-memory
+// compositor so the daemon, dispatch and animation code can run off a Mac.
+//
+// Requires common.h. All entries must be set. Functions may be called from the message
+// threads and from the animation thread concurrently.
+//
+
+// Receives SA_EVENT_* reports (see struct backend.watch)
+typedef void (*backend_notify_fn)(uint32_t events, uint32_t id, uint64_t sid);
+
+// Added to a window's SA_EVENT_WINDOW_ORDERED report when it was closed
+#define BACKEND_WINDOW_CLOSED 0x80000000u
+
+struct backend_rect
+{
+    double x, y;
+    double width, height;
+};
+
+struct backend
+{
+    const char *name;
+
+    // OSAX_ATTRIB_* bits reported by the handshake
+    uint32_t (*capabilities)(void);
+
+    // Windows
+    void (*window_get_bounds)(uint32_t wid, struct backend_rect *frame);
+    void (*window_move)(uint32_t wid, int x, int y);
+    void (*window_reassociate)(const uint32_t *wids, int count);
+    void (*window_scale)(uint32_t wid, float dx, float dy, float dw, float dh);
+    void (*window_get_alpha)(uint32_t wid, float *alpha);
+    void (*window_set_alpha)(uint32_t wid, float alpha);
+    void (*window_set_layer)(uint32_t wid, int layer);
+    void (*window_get_level)(uint32_t wid, int *level);
+    void (*window_set_tags)(uint32_t wid, uint64_t tags);
+    void (*window_clear_tags)(uint32_t wid, uint64_t tags);
+    uint64_t (*window_get_tags)(uint32_t wid);
+    void (*window_order)(uint32_t wid, int order, uint32_t rel_wid);
+    bool (*window_is_ordered_in)(uint32_t wid);
+    void (*window_focus)(uint32_t wid);
+    void (*window_move_to_space)(const uint32_t *wids, int count, uint64_t sid);
+
+    // Fills one record per wid (wid 0 for windows that do not exist)
+    void (*window_snapshot)(const uint32_t *wids, int count, struct sa_window_record *records);
+
+    // Changes recorded on a transaction are applied together on commit,
+    // which also releases it
+    void *(*transaction_create)(void);
+    void (*transaction_move)(void *transaction, uint32_t wid, int x, int y);
+    void (*transaction_set_alpha)(void *transaction, uint32_t wid, float alpha);
+    void (*transaction_set_layer)(void *transaction, uint32_t wid, int layer);
+    void (*transaction_order)(void *transaction, uint32_t wid, int order, uint32_t rel_wid);
+    void (*transaction_order_group)(void *transaction, uint32_t wid, int order, uint32_t rel_wid);
+    void (*transaction_commit)(void *transaction);
+
+    // Spaces
+    void (*space_focus)(uint64_t sid);
+    void (*space_create)(uint64_t sid);
+    void (*space_destroy)(uint64_t sid);
+    void (*space_move)(uint64_t sid, uint64_t dest_sid, uint64_t prev_sid, bool focus);
+
+    // Displays: writes up to max ids (ids may be NULL) and returns the count
+    uint32_t (*display_list)(uint32_t *ids, uint32_t max);
+
+    // Current space of a display, 0 if unknown
+    uint64_t (*display_space)(uint32_t did);
+
+    // Change reports: after watch(), notify is called, from any thread, when
+    // a watched window moves, resizes or is ordered in or out (id is the
+    // wid), when a display switches to another space (id is the display, sid
+    // the space) and when displays or their spaces are rearranged (id is the
+    // display). A window that closes is reported ordered out with
+    // BACKEND_WINDOW_CLOSED. watch_windows() adds windows to the watch list.
+    // Alpha changes are not reported; the daemon reports the ones it makes.
+    void (*watch)(backend_notify_fn notify);
+    void (*watch_windows)(const uint32_t *wids, int count);
+};
+
+#endif
@@ -0,0 +1,2243 @@
+//
+// Portable half of the client library: context, socket transport, sessions,
+// handshake, every operation and query, batches and transactions.
+//
+// client.m includes this file and adds installation and loading, which need
+// Cocoa. On its own it builds anywhere, against the payload or the stand-in
+// daemon (tools/mssd.c).
+//
+
+#include "../include/mss.h"
+#include "../include/mss_types.h"
+#include "common.h"
+#include "state.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <pwd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __APPLE__
+// External SkyLight functions
+extern int SLSMainConnectionID(void);
+extern int SLSWindowIsOrderedIn(int cid, uint32_t wid, uint8_t *ordered_in);
+#else
+// No window server to ask off macOS; every window counts as ordered out
+static inline int SLSMainConnectionID(void) { return 0; }
+static inline int SLSWindowIsOrderedIn(int cid, uint32_t wid, uint8_t *ordered_in) { (void) cid; (void) wid; *ordered_in = 0; return 0; }
+#endif
+
+// Maximum path length
+#define MAXLEN 4096
+
+// Global logging callback
+static mss_log_callback g_log_callback = NULL;
+
+// Helper to log messages
+static void sa_log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+static void sa_log(const char *format, ...)
+{
+    if (g_log_callback) {
+        char buffer[4096];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        g_log_callback(buffer);
+    }
+}
+
+// Most requests a pipeline may keep in flight
+#define SA_PIPELINE_MAX 1024
+
+// Most asynchronous requests in flight outside a pipeline
+#define SA_ASYNC_DEPTH  64
+
+// Unpacks a response payload into the output pointers of the call that sent it
+typedef int (*sa_decode_fn)(const char *payload, uint32_t length, void **out);
+
+// A request sent on the session whose response has not been completed yet
+struct sa_pending {
+    bool in_use;
+    bool done;          // Result is set; a synchronous caller releases the slot
+    bool deferred;      // Nobody waits for it; released as soon as it is done
+    uint16_t id;
+    int result;
+    sa_decode_fn decode;
+    void *out[4];
+    mss_completion_callback callback;   // Set for asynchronous calls
+    void *userdata;
+};
+
+// A finished asynchronous call whose callback has not run yet
+struct sa_completion {
+    mss_completion_callback callback;
+    void *userdata;
+    int result;
+};
+
+// A window's attributes in the read cache; fields are SA_STATE_* bits
+struct sa_cache_entry {
+    uint32_t wid;               // 0 while the slot is empty
+    uint32_t fields;
+    struct sa_window_record record;
+};
+
+// Context structure
+struct mss_context {
+    char socket_path[MAXLEN];
+    int connection_id;  // SkyLight connection ID
+    bool persistent;    // Reuse one session socket for every call
+    int session_fd;     // Open session socket, or -1
+
+    bool pipelining;            // Between mss_pipeline_begin() and mss_pipeline_end()
+    int pipeline_result;        // First error in the current pipeline
+    int depth;                  // Most requests in flight at once
+    int in_flight;              // Requests sent and not yet answered
+    uint16_t next_id;           // Id of the next request on the session
+    int pending_mask;           // pending has pending_mask + 1 slots, a power of two
+    struct sa_pending *pending; // In-flight requests, indexed by id & pending_mask
+
+    mss_completion_callback async_callback; // Claimed by the next request sent
+    void *async_userdata;
+    struct sa_completion *completions;      // Callbacks waiting to run, in order
+    int completion_head;
+    int completion_count;
+    int completion_capacity;
+
+    int event_fd;                       // Subscription socket, or -1
+    mss_event_callback event_callback;
+    void *event_userdata;
+
+    uint64_t local_max_age;     // Oldest state page value queries accept (ns); 0 = always ask
+    struct sa_state *state;     // Payload's state page, or NULL while unmapped
+    ino_t state_inode;          // File the page was mapped from
+    uint64_t state_checked;     // When the mapping was last checked against the file
+
+    struct sa_cache_entry *cache;   // SA_CACHE_SIZE slots, or NULL while the read cache is off
+    bool cache_checked;             // Validated against the payload since the pass began
+    uint64_t cache_generation;      // Payload window generation the cache was filled at
+
+    char *recv_buf;             // Payload of the last response read
+    uint32_t recv_capacity;
+    char send_buf[sizeof(uint16_t) + SA_MESSAGE_MAX];
+};
+
+
+// ============================================================================
+// Transport
+// ============================================================================
+
+static int sa_status_error(uint8_t status)
+{
+    switch (status) {
+    case SA_STATUS_OK:              return MSS_SUCCESS;
+    case SA_STATUS_BAD_REQUEST:     return MSS_ERROR_INVALID_ARG;
+    case SA_STATUS_UNKNOWN_OPCODE:  return MSS_ERROR_PROTOCOL;
+    default:                        return MSS_ERROR_OPERATION;
+    }
+}
+
+// Sends a message prefixed with its request id
+static bool sa_send_request(mss_context *ctx, int sockfd, uint16_t id, const char *bytes, int length)
+{
+    if (length > SA_MESSAGE_MAX) return false;
+
+    memcpy(ctx->send_buf, &id, sizeof(id));
+    memcpy(ctx->send_buf + sizeof(id), bytes, length);
+    return socket_send_all(sockfd, ctx->send_buf, sizeof(id) + length);
+}
+
+//
+// NOTE: Reads one whole response (see struct sa_response_header), leaving
+// its payload in ctx->recv_buf. Any result other than MSS_SUCCESS means the
+// socket is out of step with the payload and must not be read again.
+//
+
+static int sa_read_response(mss_context *ctx, int sockfd, struct sa_response_header *header)
+{
+    if (!socket_recv_all(sockfd, header, sizeof(*header))) return MSS_ERROR_CONNECTION;
+
+    if (header->version != SA_PROTOCOL_VERSION) {
+        sa_log("ERROR: Payload speaks protocol %d, expected %d; reload it", header->version, SA_PROTOCOL_VERSION);
+        return MSS_ERROR_PROTOCOL;
+    }
+
+    if (header->length > SA_RESPONSE_MAX) {
+        sa_log("ERROR: Response of %u bytes exceeds the protocol limit", header->length);
+        return MSS_ERROR_PROTOCOL;
+    }
+
+    if (header->length > ctx->recv_capacity) {
+        char *recv_buf = realloc(ctx->recv_buf, header->length);
+        if (!recv_buf) return MSS_ERROR_CONNECTION;
+
+        ctx->recv_buf = recv_buf;
+        ctx->recv_capacity = header->length;
+    }
+
+    return socket_recv_all(sockfd, ctx->recv_buf, header->length) ? MSS_SUCCESS : MSS_ERROR_CONNECTION;
+}
+
+// Turns a response that has been read into the result of its call
+static int sa_decode_response(mss_context *ctx, const struct sa_response_header *header, sa_decode_fn decode, void **out)
+{
+    if (header->status != SA_STATUS_OK) {
+        sa_log("ERROR: Payload rejected request %u (status %u)", header->id, header->status);
+        return sa_status_error(header->status);
+    }
+
+    return decode ? decode(ctx->recv_buf, header->length, out) : MSS_SUCCESS;
+}
+
+//
+// NOTE: Callbacks never run while a response is being read. A finished
+// asynchronous call is queued here instead and its callback runs from
+// sa_deliver_completions(), once the context is consistent again, so that
+// callbacks are free to issue further calls.
+//
+
+static void sa_completion_push(mss_context *ctx, mss_completion_callback callback, void *userdata, int result)
+{
+    if (ctx->completion_head + ctx->completion_count == ctx->completion_capacity) {
+        if (ctx->completion_head) {
+            memmove(ctx->completions, ctx->completions + ctx->completion_head, sizeof(struct sa_completion) * ctx->completion_count);
+            ctx->completion_head = 0;
+        } else {
+            int capacity = ctx->completion_capacity ? 2 * ctx->completion_capacity : SA_ASYNC_DEPTH;
+            struct sa_completion *completions = realloc(ctx->completions, sizeof(struct sa_completion) * capacity);
+            if (!completions) {
+                sa_log("ERROR: Out of memory, dropping a completion");
+                return;
+            }
+
+            ctx->completions = completions;
+            ctx->completion_capacity = capacity;
+        }
+    }
+
+    ctx->completions[ctx->completion_head + ctx->completion_count++] = (struct sa_completion) { callback, userdata, result };
+}
+
+static int sa_deliver_completions(mss_context *ctx)
+{
+    int delivered = 0;
+    while (ctx->completion_count) {
+        struct sa_completion completion = ctx->completions[ctx->completion_head++];
+        if (--ctx->completion_count == 0) ctx->completion_head = 0;
+
+        completion.callback(ctx, completion.result, completion.userdata);
+        ++delivered;
+    }
+    return delivered;
+}
+
+static void sa_pending_finish(mss_context *ctx, struct sa_pending *slot, int result)
+{
+    slot->result = result;
+    slot->done = true;
+    --ctx->in_flight;
+
+    if (slot->deferred) {
+        if (slot->callback) {
+            sa_completion_push(ctx, slot->callback, slot->userdata, result);
+        } else if (result != MSS_SUCCESS && ctx->pipeline_result == MSS_SUCCESS) {
+            ctx->pipeline_result = result;
+        }
+        slot->in_use = false;
+    }
+}
+
+// Grows the in-flight table to at least slots entries, keeping what is in it
+static bool sa_pending_reserve(mss_context *ctx, int slots)
+{
+    int size = ctx->pending_mask + 1;
+    if (slots <= size) return true;
+    while (size < slots) size <<= 1;
+
+    struct sa_pending *pending = calloc(size, sizeof(struct sa_pending));
+    if (!pending) return false;
+
+    // Ids in flight are distinct modulo the old size, so they stay distinct
+    for (int i = 0; i <= ctx->pending_mask; ++i) {
+        if (ctx->pending[i].in_use) pending[ctx->pending[i].id & (size - 1)] = ctx->pending[i];
+    }
+
+    free(ctx->pending);
+    ctx->pending = pending;
+    ctx->pending_mask = size - 1;
+    return true;
+}
+
+// Drops the session; every request still in flight on it fails with result
+static void sa_session_abort(mss_context *ctx, int result)
+{
+    if (ctx->session_fd != -1) {
+        socket_close(ctx->session_fd);
+        ctx->session_fd = -1;
+    }
+
+    for (int i = 0; i <= ctx->pending_mask && ctx->in_flight; ++i) {
+        struct sa_pending *slot = &ctx->pending[i];
+        if (slot->in_use && !slot->done) sa_pending_finish(ctx, slot, result);
+    }
+}
+
+static void sa_session_close(mss_context *ctx)
+{
+    sa_session_abort(ctx, MSS_ERROR_CONNECTION);
+}
+
+static bool sa_session_open(mss_context *ctx)
+{
+    int sockfd;
+    char bytes[] = { 0x01, 0x00, SA_OPCODE_SESSION };
+    struct sa_response_header header;
+
+    if (!socket_open(&sockfd)) return false;
+    socket_set_nosigpipe(sockfd);
+
+    if (!socket_connect(sockfd, ctx->socket_path) ||
+        !sa_send_request(ctx, sockfd, 0, bytes, sizeof(bytes)) ||
+        sa_read_response(ctx, sockfd, &header) != MSS_SUCCESS ||
+        header.status != SA_STATUS_OK) {
+        socket_close(sockfd);
+        return false;
+    }
+
+    ctx->session_fd = sockfd;
+    return true;
+}
+
+// Reads the next response off the session and completes the request it answers
+static bool sa_session_pump(mss_context *ctx)
+{
+    struct sa_response_header header;
+    int result = sa_read_response(ctx, ctx->session_fd, &header);
+
+    if (result == MSS_SUCCESS) {
+        struct sa_pending *slot = &ctx->pending[header.id & ctx->pending_mask];
+        if (slot->in_use && !slot->done && slot->id == header.id) {
+            sa_pending_finish(ctx, slot, sa_decode_response(ctx, &header, slot->decode, slot->out));
+            return true;
+        }
+
+        sa_log("ERROR: Response to unknown request %u", header.id);
+        result = MSS_ERROR_PROTOCOL;
+    }
+
+    sa_session_abort(ctx, result);
+    return false;
+}
+
+//
+// NOTE: Requests on a session are numbered, and each one holds the slot at
+// its id modulo the table size until its response arrives. Sending waits
+// while that slot is taken or limit requests are already in flight. The
+// payload may answer in any order; every response is matched to its slot by
+// the id it echoes.
+//
+
+static int sa_session_submit(mss_context *ctx, const char *bytes, int length, sa_decode_fn decode, void **out,
+                             int limit, bool deferred, struct sa_pending **pending)
+{
+    // The payload never speaks unasked, so an idle session that is readable
+    // was closed by the other end (e.g. Dock.app restarted)
+    if (ctx->session_fd != -1 && !ctx->in_flight) {
+        struct pollfd pfd = { .fd = ctx->session_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 0) > 0) sa_session_close(ctx);
+    }
+
+    if (ctx->session_fd == -1 && !sa_session_open(ctx)) {
+        sa_log("ERROR: Failed to open session with scripting addition");
+        return MSS_ERROR_CONNECTION;
+    }
+
+    uint16_t id = ctx->next_id;
+    struct sa_pending *slot = &ctx->pending[id & ctx->pending_mask];
+    while (slot->in_use || ctx->in_flight >= limit) {
+        if (!sa_session_pump(ctx)) return MSS_ERROR_CONNECTION;
+    }
+
+    if (!sa_send_request(ctx, ctx->session_fd, id, bytes, length)) {
+        sa_session_close(ctx);
+        return MSS_ERROR_CONNECTION;
+    }
+
+    *slot = (struct sa_pending) { .in_use = true, .deferred = deferred, .id = id, .decode = decode };
+    if (out) memcpy(slot->out, out, sizeof(slot->out));
+
+    if (ctx->async_callback) {
+        slot->callback = ctx->async_callback;
+        slot->userdata = ctx->async_userdata;
+        ctx->async_callback = NULL;
+    }
+
+    ctx->next_id = id + 1;
+    ++ctx->in_flight;
+    if (pending) *pending = slot;
+    return MSS_SUCCESS;
+}
+
+//
+// NOTE: The session socket dies whenever Dock.app restarts. A session found
+// closed before sending is replaced, and a request that could not be sent
+// is retried once on a fresh session, which makes reconnects invisible to
+// callers. A request that was sent is never repeated, even if its response
+// is lost, since it may have been applied and not every operation is safe
+// to apply twice. Inside a pipeline a call returns as soon as it is sent:
+// the requests lost with the socket may or may not have been applied.
+//
+
+static int sa_transact_session(mss_context *ctx, const char *bytes, int length, sa_decode_fn decode, void **out)
+{
+    if (ctx->async_callback) {
+        int limit = ctx->depth > SA_ASYNC_DEPTH ? ctx->depth : SA_ASYNC_DEPTH;
+        return sa_session_submit(ctx, bytes, length, decode, out, limit, true, NULL);
+    }
+
+    if (ctx->pipelining) {
+        return sa_session_submit(ctx, bytes, length, decode, out, ctx->depth, true, NULL);
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        struct sa_pending *slot;
+        int result = sa_session_submit(ctx, bytes, length, decode, out, ctx->pending_mask + 1, false, &slot);
+        if (result == MSS_SUCCESS) {
+            while (!slot->done && sa_session_pump(ctx));
+            result = slot->result;
+            slot->in_use = false;
+
+            // Sent, so never repeated, whatever became of the response
+            if (result == MSS_ERROR_CONNECTION) break;
+            return result;
+        }
+
+        if (result != MSS_ERROR_CONNECTION) return result;
+    }
+
+    sa_log("ERROR: Session with scripting addition lost");
+    return MSS_ERROR_CONNECTION;
+}
+
+static int sa_transact_oneshot(mss_context *ctx, const char *bytes, int length, sa_decode_fn decode, void **out)
+{
+    int sockfd;
+
+    if (!socket_open(&sockfd)) {
+        sa_log("ERROR: Failed to open socket");
+        return MSS_ERROR_CONNECTION;
+    }
+
+    if (!socket_connect(sockfd, ctx->socket_path)) {
+        sa_log("ERROR: Failed to connect to socket - payload not running?");
+        socket_close(sockfd);
+        return MSS_ERROR_CONNECTION;
+    }
+
+    struct sa_response_header header;
+    int result = MSS_ERROR_CONNECTION;
+    if (sa_send_request(ctx, sockfd, 0, bytes, length)) {
+        result = sa_read_response(ctx, sockfd, &header);
+    }
+
+    if (result == MSS_SUCCESS) {
+        result = sa_decode_response(ctx, &header, decode, out);
+    } else if (result == MSS_ERROR_CONNECTION) {
+        sa_log("ERROR: No response from payload");
+    }
+
+    socket_close(sockfd);
+    return result;
+}
+
+// Sends one message and completes it, over the session if there is one.
+// Callbacks of asynchronous calls finished along the way run before it returns.
+static int sa_transact(mss_context *ctx, const char *bytes, int length, sa_decode_fn decode, void **out)
+{
+    int result;
+    if (ctx->persistent) {
+        result = sa_transact_session(ctx, bytes, length, decode, out);
+    } else {
+        result = sa_transact_oneshot(ctx, bytes, length, decode, out);
+    }
+
+    ctx->async_callback = NULL;
+    if (ctx->completion_count) sa_deliver_completions(ctx);
+    return result;
+}
+
+static bool sa_send_bytes(mss_context *ctx, char *bytes, int length)
+{
+    return sa_transact(ctx, bytes, length, NULL, NULL) == MSS_SUCCESS;
+}
+
+// ============================================================================
+// Response decoders
+// ============================================================================
+
+static int sa_decode_handshake(const char *payload, uint32_t length, void **out)
+{
+    char *version_buf = out[1];
+
+    const char *zero = memchr(payload, '\0', length < 0x1000 ? length : 0x1000);
+    if (!zero || zero + 1 + sizeof(uint32_t) > payload + length) {
+        sa_log("ERROR: Malformed handshake response");
+        return MSS_ERROR_OPERATION;
+    }
+
+    memcpy(version_buf, payload, zero - payload + 1);
+    memcpy(out[0], zero + 1, sizeof(uint32_t));
+    return MSS_SUCCESS;
+}
+
+static int sa_decode_flag(const char *payload, uint32_t length, void **out)
+{
+    if (length < sizeof(uint8_t)) return MSS_ERROR_OPERATION;
+    *(bool *) out[0] = payload[0] != 0;
+    return MSS_SUCCESS;
+}
+
+static int sa_decode_float(const char *payload, uint32_t length, void **out)
+{
+    if (length < sizeof(float)) return MSS_ERROR_OPERATION;
+    memcpy(out[0], payload, sizeof(float));
+    return MSS_SUCCESS;
+}
+
+static int sa_decode_uint32(const char *payload, uint32_t length, void **out)
+{
+    if (length < sizeof(uint32_t)) return MSS_ERROR_OPERATION;
+    memcpy(out[0], payload, sizeof(uint32_t));
+    return MSS_SUCCESS;
+}
+
+static int sa_decode_uint64(const char *payload, uint32_t length, void **out)
+{
+    if (length < sizeof(uint64_t)) return MSS_ERROR_OPERATION;
+    memcpy(out[0], payload, sizeof(uint64_t));
+    return MSS_SUCCESS;
+}
+
+static int sa_decode_layer(const char *payload, uint32_t length, void **out)
+{
+    int layer;
+    if (length < sizeof(layer)) return MSS_ERROR_OPERATION;
+    memcpy(&layer, payload, sizeof(layer));
+    *(enum mss_window_layer *) out[0] = (enum mss_window_layer) layer;
+    return MSS_SUCCESS;
+}
+
+// x, y, width and height, as ints
+static int sa_decode_frame(const char *payload, uint32_t length, void **out)
+{
+    if (length < 4 * sizeof(int)) return MSS_ERROR_OPERATION;
+    for (int i = 0; i < 4; ++i) {
+        memcpy(out[i], payload + i * sizeof(int), sizeof(int));
+    }
+    return MSS_SUCCESS;
+}
+
+// Count followed by display ids; out[1] carries the caller's max_count
+static int sa_decode_display_list(const char *payload, uint32_t length, void **out)
+{
+    uint32_t *displays = out[0];
+    size_t max_count = (uintptr_t) out[1];
+
+    uint32_t count;
+    if (length < sizeof(count)) return MSS_ERROR_OPERATION;
+    memcpy(&count, payload, sizeof(count));
+    if (length < sizeof(uint32_t) * (1 + (size_t) count)) return MSS_ERROR_OPERATION;
+
+    for (size_t i = 0; i < count && i < max_count; i++) {
+        memcpy(&displays[i], payload + sizeof(uint32_t) * (1 + i), sizeof(uint32_t));
+    }
+    return MSS_SUCCESS;
+}
+
+// An sa_stats record; payloads may send a shorter or longer one
+static int sa_decode_stats(const char *payload, uint32_t length, void **out)
+{
+    struct sa_stats wire = {};
+    if (length < offsetof(struct sa_stats, lanes)) return MSS_ERROR_OPERATION;
+    memcpy(&wire, payload, length < sizeof(wire) ? length : sizeof(wire));
+
+    struct mss_stats *stats = out[0];
+    *stats = (struct mss_stats) {
+        .lane_count = wire.lane_count < MSS_LANE_MAX ? wire.lane_count : MSS_LANE_MAX,
+        .barriers = wire.barriers,
+        .barrier_waits = wire.barrier_waits,
+        .coalesced_moves = wire.coalesced_moves,
+        .coalesced_frames = wire.coalesced_frames,
+        .event_reports = wire.event_reports,
+        .events_sent = wire.events_sent,
+        .cache_hits = wire.cache_hits,
+        .cache_misses = wire.cache_misses,
+    };
+
+    for (uint32_t i = 0; i < stats->lane_count; ++i) {
+        stats->lanes[i] = (struct mss_lane_stats) {
+            .executed = wire.lanes[i].executed,
+            .contended = wire.lanes[i].contended,
+            .depth = wire.lanes[i].depth,
+            .max_depth = wire.lanes[i].max_depth,
+        };
+    }
+    return MSS_SUCCESS;
+}
+
+// Record count followed by records; out[1] carries the count requested
+static int sa_decode_snapshot(const char *payload, uint32_t length, void **out)
+{
+    struct mss_window_state *states = out[0];
+    uint32_t chunk = (uintptr_t) out[1];
+
+    uint32_t records = 0;
+    if (length >= sizeof(records)) memcpy(&records, payload, sizeof(records));
+    if (records != chunk || length != sizeof(uint32_t) + sizeof(struct sa_window_record) * chunk) {
+        return MSS_ERROR_OPERATION;
+    }
+
+    for (uint32_t i = 0; i < chunk; ++i) {
+        struct sa_window_record record;
+        memcpy(&record, payload + sizeof(uint32_t) + sizeof(record) * i, sizeof(record));
+
+        states[i] = (struct mss_window_state) {
+            .wid = record.wid,
+            .x = record.x,
+            .y = record.y,
+            .width = record.width,
+            .height = record.height,
+            .opacity = record.alpha,
+            .level = record.level,
+            .tags = record.tags,
+            .ordered_in = record.ordered_in != 0,
+        };
+    }
+    return MSS_SUCCESS;
+}
+
+// ============================================================================
+// Local reads
+// ============================================================================
+
+//
+// NOTE: With local reads on, queries are answered from the payload's state
+// page (state.h) when it holds a value young enough for the caller. The page
+// is mapped on first use and checked against the file at most once a second,
+// so a payload that restarted is picked up again. While a request of this
+// context is in flight queries are always sent instead, since their answer
+// has to reflect it.
+//
+
+#define SA_STATE_CHECK_INTERVAL 1000000000ull
+
+// Read cache slots; a power of two
+#define SA_CACHE_SHIFT          10
+#define SA_CACHE_SIZE           (1u << SA_CACHE_SHIFT)
+
+// Fields whose changes move the payload's window generation
+#define SA_CACHE_REPORTED       SA_STATE_FRAME
+
+static void sa_state_unmap(mss_context *ctx)
+{
+    if (ctx->state) munmap(ctx->state, sizeof(struct sa_state));
+    ctx->state = NULL;
+}
+
+static struct sa_state *sa_state_get(mss_context *ctx, uint64_t now)
+{
+    if (ctx->state_checked && now - ctx->state_checked < SA_STATE_CHECK_INTERVAL) return ctx->state;
+    ctx->state_checked = now;
+
+    char path[MAXLEN + 8];
+    snprintf(path, sizeof(path), SA_STATE_PATH_FMT, ctx->socket_path);
+
+    struct stat info;
+    if (stat(path, &info) == -1) {
+        sa_state_unmap(ctx);
+        return NULL;
+    }
+    if (ctx->state && info.st_ino == ctx->state_inode) return ctx->state;
+
+    sa_state_unmap(ctx);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return NULL;
+
+    void *page = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t) sizeof(struct sa_state)) {
+        page = mmap(NULL, sizeof(struct sa_state), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (page == MAP_FAILED) return NULL;
+
+    // A page still being set up is retried at the next check
+    struct sa_state *state = page;
+    if (__atomic_load_n(&state->magic, __ATOMIC_ACQUIRE) != SA_STATE_MAGIC ||
+        state->version != SA_STATE_VERSION || state->window_capacity != SA_STATE_WINDOW_MAX) {
+        munmap(page, sizeof(struct sa_state));
+        return NULL;
+    }
+
+    sa_log("Mapped state page %s", path);
+    ctx->state = state;
+    ctx->state_inode = info.st_ino;
+    return state;
+}
+
+// Whether a value learned at updated may still be served at now
+static bool sa_local_fresh(mss_context *ctx, uint64_t updated, uint64_t now)
+{
+    return updated + ctx->local_max_age >= now;
+}
+
+// Copies a window's record if the page knows fields of it and they are fresh
+static bool sa_local_window(mss_context *ctx, uint32_t wid, uint32_t fields, struct sa_window_record *record)
+{
+    if (!ctx->local_max_age || ctx->in_flight) return false;
+
+    uint64_t now = sa_state_now();
+    struct sa_state *state = sa_state_get(ctx, now);
+    if (!state) return false;
+
+    struct sa_state_window *slot = sa_state_window_find(state, wid), entry;
+    if (!slot || !sa_state_read(&slot->sequence, slot, &entry, sizeof(entry))) return false;
+    if (entry.wid != wid || (entry.fields & fields) != fields) return false;
+    if (!sa_local_fresh(ctx, sa_state_window_learned(&entry, fields), now)) return false;
+
+    *record = entry.record;
+    return true;
+}
+
+static bool sa_local_displays(mss_context *ctx, struct sa_state_displays *displays)
+{
+    if (!ctx->local_max_age || ctx->in_flight) return false;
+
+    uint64_t now = sa_state_now();
+    struct sa_state *state = sa_state_get(ctx, now);
+    if (!state) return false;
+
+    if (!sa_state_read(&state->displays.sequence, &state->displays, displays, sizeof(*displays))) return false;
+    return displays->updated && displays->count <= SA_STATE_DISPLAY_MAX && sa_local_fresh(ctx, displays->updated, now);
+}
+
+// ============================================================================
+// Context Management
+// ============================================================================
+
+mss_context *mss_create(const char *socket_path)
+{
+    mss_context *ctx = malloc(sizeof(mss_context));
+    if (!ctx) return NULL;
+
+    if (socket_path) {
+        snprintf(ctx->socket_path, sizeof(ctx->socket_path), "%s", socket_path);
+    } else {
+        // Resolve socket path - handle sudo case like yabai does
+        const char *sudo_uid = getenv("SUDO_UID");
+        uid_t uid = getuid();
+        const char *user = NULL;
+
+        // If running as root via sudo, get the original user
+        if (uid == 0 && sudo_uid) {
+            unsigned int target_uid;
+            if (sscanf(sudo_uid, "%u", &target_uid) == 1) {
+                struct passwd *pw = getpwuid(target_uid);
+                if (pw) {
+                    user = pw->pw_name;
+                }
+            }
+        }
+
+        // Fallback to current user
+        if (!user) {
+            user = getenv("USER");
+        }
+
+        if (!user) {
+            free(ctx);
+            return NULL;
+        }
+
+        snprintf(ctx->socket_path, sizeof(ctx->socket_path), SA_SOCKET_PATH_FMT, user);
+    }
+
+    ctx->connection_id = SLSMainConnectionID();
+    ctx->persistent = false;
+    ctx->session_fd = -1;
+    ctx->pipelining = false;
+    ctx->pipeline_result = MSS_SUCCESS;
+    ctx->depth = 1;
+    ctx->in_flight = 0;
+    ctx->next_id = 0;
+    ctx->pending_mask = 0;
+    ctx->pending = calloc(1, sizeof(struct sa_pending));
+    ctx->async_callback = NULL;
+    ctx->async_userdata = NULL;
+    ctx->completions = NULL;
+    ctx->completion_head = 0;
+    ctx->completion_count = 0;
+    ctx->completion_capacity = 0;
+    ctx->event_fd = -1;
+    ctx->event_callback = NULL;
+    ctx->event_userdata = NULL;
+    ctx->local_max_age = 0;
+    ctx->state = NULL;
+    ctx->state_inode = 0;
+    ctx->state_checked = 0;
+    ctx->cache = NULL;
+    ctx->cache_checked = false;
+    ctx->cache_generation = 0;
+    ctx->recv_buf = NULL;
+    ctx->recv_capacity = 0;
+
+    if (!ctx->pending) {
+        free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+void mss_destroy(mss_context *ctx)
+{
+    if (ctx) {
+        sa_session_close(ctx);
+        mss_unsubscribe(ctx);
+        sa_state_unmap(ctx);
+        free(ctx->cache);
+        free(ctx->pending);
+        free(ctx->completions);
+        free(ctx->recv_buf);
+        free(ctx);
+    }
+}
+
+int mss_set_persistent(mss_context *ctx, bool persistent)
+{
+    if (!ctx) return MSS_ERROR_INVALID_ARG;
+
+    ctx->persistent = persistent;
+
+    if (!persistent) {
+        sa_session_close(ctx);
+        return MSS_SUCCESS;
+    }
+
+    if (ctx->session_fd == -1 && !sa_session_open(ctx)) {
+        sa_log("WARNING: Payload not reachable, session will be opened on first use");
+        return MSS_ERROR_CONNECTION;
+    }
+
+    return MSS_SUCCESS;
+}
+
+int mss_set_local_reads(mss_context *ctx, uint32_t max_age_ms)
+{
+    if (!ctx) return MSS_ERROR_INVALID_ARG;
+
+    ctx->local_max_age = (uint64_t) max_age_ms * 1000000ull;
+
+    if (!max_age_ms) {
+        sa_state_unmap(ctx);
+        ctx->state_checked = 0;
+    }
+
+    return MSS_SUCCESS;
+}
+
+int mss_set_read_cache(mss_context *ctx, bool enabled)
+{
+    if (!ctx) return MSS_ERROR_INVALID_ARG;
+
+    if (!enabled) {
+        free(ctx->cache);
+        ctx->cache = NULL;
+    } else if (!ctx->cache) {
+        ctx->cache = calloc(SA_CACHE_SIZE, sizeof(struct sa_cache_entry));
+        if (!ctx->cache) return MSS_ERROR_OPERATION;
+    }
+
+    ctx->cache_checked = false;
+    return MSS_SUCCESS;
+}
+
+void mss_read_cache_begin(mss_context *ctx)
+{
+    if (ctx) ctx->cache_checked = false;
+}
+
+int mss_pipeline_begin(mss_context *ctx, int depth)
+{
+    if (!ctx || depth < 1 || depth > SA_PIPELINE_MAX || ctx->pipelining) return MSS_ERROR_INVALID_ARG;
+
+    if (!ctx->persistent) {
+        sa_log("ERROR: Pipelining needs a persistent context");
+        return MSS_ERROR_INVALID_ARG;
+    }
+
+    if (!sa_pending_reserve(ctx, depth)) return MSS_ERROR_OPERATION;
+
+    ctx->depth = depth;
+    ctx->pipelining = true;
+    ctx->pipeline_result = MSS_SUCCESS;
+    return MSS_SUCCESS;
+}
+
+int mss_pipeline_end(mss_context *ctx)
+{
+    if (!ctx || !ctx->pipelining) return MSS_ERROR_INVALID_ARG;
+
+    while (ctx->in_flight && sa_session_pump(ctx));
+
+    ctx->depth = 1;
+    ctx->pipelining = false;
+    sa_deliver_completions(ctx);
+    return ctx->pipeline_result;
+}
+
+void mss_set_log_callback(mss_log_callback callback)
+{
+    g_log_callback = callback;
+}
+
+const char *mss_get_socket_path(mss_context *ctx)
+{
+    return ctx ? ctx->socket_path : NULL;
+}
+
+int mss_handshake(mss_context *ctx, uint32_t *capabilities, const char **version)
+{
+    if (!ctx || !capabilities) return MSS_ERROR_INVALID_ARG;
+
+    sa_log("Performing handshake with scripting addition...");
+    sa_log("Socket path: %s", ctx->socket_path);
+
+    char bytes[] = { 0x01, 0x00, SA_OPCODE_HANDSHAKE };
+    static char version_buf[0x1000] = {0};
+
+    // Always a fresh connection, so that it reflects the payload running now
+    int result = sa_transact_oneshot(ctx, bytes, sizeof(bytes), sa_decode_handshake, (void *[4]) { capabilities, version_buf });
+    if (result != MSS_SUCCESS) return result;
+
+    if (version) *version = version_buf;
+
+    sa_log("Handshake successful - Version: %s, Capabilities: 0x%X", version_buf, *capabilities);
+
+    return MSS_SUCCESS;
+}
+
+// ============================================================================
+// Message sending macros
+// ============================================================================
+
+#define sa_payload_init() char bytes[0x1000]; int16_t length = 1+sizeof(length)
+#define pack(v) memcpy(bytes+length, &v, sizeof(v)); length += sizeof(v)
+#define sa_payload_send(ctx, op) *(int16_t*)bytes = length-sizeof(length), bytes[sizeof(length)] = op, sa_send_bytes(ctx, bytes, length)
+
+// Query operation macros
+#define sa_query_init() char send_buf[0x1000]; int16_t send_len = 1+sizeof(send_len)
+#define query_pack(v) do { typeof(v) _tmp = (v); memcpy(send_buf+send_len, &_tmp, sizeof(_tmp)); send_len += sizeof(_tmp); } while(0)
+// decode unpacks the response into the output pointers that follow it
+#define sa_query_send(ctx, op, decode, ...) (*(int16_t*)send_buf = send_len-sizeof(send_len), send_buf[sizeof(send_len)] = op, sa_transact(ctx, send_buf, send_len, decode, (void *[4]) { __VA_ARGS__ }))
+
+// ============================================================================
+// Read cache
+// ============================================================================
+
+//
+// NOTE: With the read cache on, answers to window queries are kept in a
+// direct-mapped table keyed by window id, where a window that hashes to an
+// occupied slot takes it over. The first cached query of a layout pass
+// (mss_read_cache_begin) fetches the payload's window generation, which
+// moves whenever the payload sets or hears of a change to any window; if it
+// moved, the cache is emptied. The rest of the pass trusts the cache without
+// asking. A payload that cannot hear of changes reports 0, and the cache is
+// then left empty and unused for the pass. Opacity, level and tags can
+// change without the generation moving, so they are only kept for the pass
+// that read them.
+//
+// The context's own mutations drop the windows they name, and a batch or
+// transaction drops everything. Only calls that wait for their answer fill
+// the cache; pipelined and asynchronous ones are answered from it but never
+// stored, since their results arrive later.
+//
+
+static bool sa_cache_usable(mss_context *ctx)
+{
+    if (!ctx->cache) return false;
+    if (ctx->cache_checked) return ctx->cache_generation != 0;
+
+    // The generation has to be waited for, and must not claim a callback
+    if (ctx->pipelining || ctx->async_callback) return false;
+
+    uint64_t generation;
+    sa_query_init();
+    if (sa_query_send(ctx, SA_OPCODE_WINDOW_GENERATION, sa_decode_uint64, &generation) != MSS_SUCCESS) return false;
+
+    if (generation != ctx->cache_generation || !generation) {
+        memset(ctx->cache, 0, SA_CACHE_SIZE * sizeof(struct sa_cache_entry));
+        ctx->cache_generation = generation;
+    } else {
+        for (uint32_t i = 0; i < SA_CACHE_SIZE; ++i) ctx->cache[i].fields &= SA_CACHE_REPORTED;
+    }
+
+    // Nothing is cached for the pass when the payload cannot vouch for it
+    ctx->cache_checked = true;
+    return generation != 0;
+}
+
+static struct sa_cache_entry *sa_cache_slot(mss_context *ctx, uint32_t wid)
+{
+    return &ctx->cache[(uint32_t)(wid * 0x9E3779B9u) >> (32 - SA_CACHE_SHIFT)];
+}
+
+static bool sa_cache_get(mss_context *ctx, uint32_t wid, uint32_t fields, struct sa_window_record *record)
+{
+    if (!sa_cache_usable(ctx)) return false;
+
+    struct sa_cache_entry *entry = sa_cache_slot(ctx, wid);
+    if (entry->wid != wid || (entry->fields & fields) != fields) return false;
+
+    *record = entry->record;
+    return true;
+}
+
+// Whether the answer to the query about to be sent may be stored
+static bool sa_cache_fillable(mss_context *ctx)
+{
+    return ctx->cache && ctx->cache_checked && ctx->cache_generation && !ctx->pipelining && !ctx->async_callback;
+}
+
+static void sa_cache_put(mss_context *ctx, uint32_t wid, uint32_t fields, const struct sa_window_record *values)
+{
+    struct sa_cache_entry *entry = sa_cache_slot(ctx, wid);
+    if (entry->wid != wid) *entry = (struct sa_cache_entry) { .wid = wid };
+
+    struct sa_window_record *record = &entry->record;
+    if (fields & SA_STATE_FRAME) {
+        record->x = values->x;
+        record->y = values->y;
+        record->width = values->width;
+        record->height = values->height;
+    }
+    if (fields & SA_STATE_ALPHA) record->alpha = values->alpha;
+    if (fields & SA_STATE_LEVEL) record->level = values->level;
+    if (fields & SA_STATE_TAGS) record->tags = values->tags;
+    entry->fields |= fields;
+}
+
+static void sa_cache_forget(mss_context *ctx, uint32_t wid)
+{
+    if (!ctx->cache) return;
+
+    struct sa_cache_entry *entry = sa_cache_slot(ctx, wid);
+    if (entry->wid == wid) entry->wid = 0;
+}
+
+static void sa_cache_clear(mss_context *ctx)
+{
+    if (ctx->cache) memset(ctx->cache, 0, SA_CACHE_SIZE * sizeof(struct sa_cache_entry));
+}
+
+// ============================================================================
+// Space Operations
+// ============================================================================
+
+bool mss_space_create(mss_context *ctx, uint64_t sid)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(sid);
+    return sa_payload_send(ctx, SA_OPCODE_SPACE_CREATE);
+}
+
+bool mss_space_destroy(mss_context *ctx, uint64_t sid)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(sid);
+    return sa_payload_send(ctx, SA_OPCODE_SPACE_DESTROY);
+}
+
+bool mss_space_focus(mss_context *ctx, uint64_t sid)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(sid);
+    return sa_payload_send(ctx, SA_OPCODE_SPACE_FOCUS);
+}
+
+bool mss_space_move(mss_context *ctx, uint64_t src_sid,
+                          uint64_t dst_sid, uint64_t src_prev_sid, bool focus)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(src_sid);
+    pack(dst_sid);
+    pack(src_prev_sid);
+    pack(focus);
+    return sa_payload_send(ctx, SA_OPCODE_SPACE_MOVE);
+}
+
+// ============================================================================
+// Window Operations
+// ============================================================================
+
+bool mss_window_move(mss_context *ctx, uint32_t wid, int x, int y)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(x);
+    pack(y);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_MOVE);
+}
+
+bool mss_window_set_opacity(mss_context *ctx, uint32_t wid, float opacity)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(opacity);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_OPACITY);
+}
+
+bool mss_window_fade_opacity(mss_context *ctx, uint32_t wid,
+                                   float opacity, float duration)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(opacity);
+    pack(duration);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_OPACITY_FADE);
+}
+
+bool mss_window_set_layer(mss_context *ctx, uint32_t wid,
+                                enum mss_window_layer layer)
+{
+    if (!ctx) return false;
+    int layer_value = (int)layer;
+    sa_payload_init();
+    pack(wid);
+    pack(layer_value);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_LAYER);
+}
+
+bool mss_window_set_sticky(mss_context *ctx, uint32_t wid, bool sticky)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(sticky);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_STICKY);
+}
+
+bool mss_window_set_shadow(mss_context *ctx, uint32_t wid, bool shadow)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(shadow);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SHADOW);
+}
+
+bool mss_window_focus(mss_context *ctx, uint32_t wid)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_FOCUS);
+}
+
+bool mss_window_scale(mss_context *ctx, uint32_t wid,
+                            float x, float y, float w, float h)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(x);
+    pack(y);
+    pack(w);
+    pack(h);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SCALE);
+}
+
+bool mss_window_order(mss_context *ctx, uint32_t wid,
+                            enum mss_window_order order, uint32_t relative_wid)
+{
+    if (!ctx) return false;
+    int order_value = (int)order;
+    sa_payload_init();
+    pack(wid);
+    pack(order_value);
+    pack(relative_wid);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_ORDER);
+}
+
+bool mss_window_order_in(mss_context *ctx, uint32_t *window_list, int count)
+{
+    if (!ctx || !window_list) return false;
+
+    uint32_t dummy_wid = 0;
+    uint8_t ordered_in = 0;
+
+    sa_payload_init();
+    pack(count);
+    for (int i = 0; i < count; ++i) {
+        sa_cache_forget(ctx, window_list[i]);
+        SLSWindowIsOrderedIn(ctx->connection_id, window_list[i], &ordered_in);
+        if (ordered_in) {
+            pack(dummy_wid);
+        } else {
+            pack(window_list[i]);
+        }
+    }
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_ORDER_IN);
+}
+
+bool mss_window_move_to_space(mss_context *ctx, uint32_t wid, uint64_t sid)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(sid);
+    pack(wid);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_TO_SPACE);
+}
+
+bool mss_window_list_move_to_space(mss_context *ctx, uint32_t *window_list,
+                                         int count, uint64_t sid)
+{
+    if (!ctx || !window_list) return false;
+    sa_payload_init();
+    pack(sid);
+    pack(count);
+    for (int i = 0; i < count; ++i) {
+        sa_cache_forget(ctx, window_list[i]);
+        pack(window_list[i]);
+    }
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_LIST_TO_SPACE);
+}
+
+bool mss_window_resize(mss_context *ctx, uint32_t wid, int width, int height)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(width);
+    pack(height);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_RESIZE);
+}
+
+bool mss_window_set_frame(mss_context *ctx, uint32_t wid,
+                                 int x, int y, int width, int height)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(x);
+    pack(y);
+    pack(width);
+    pack(height);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SET_FRAME);
+}
+
+bool mss_window_minimize(mss_context *ctx, uint32_t wid)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_MINIMIZE);
+}
+
+bool mss_window_unminimize(mss_context *ctx, uint32_t wid)
+{
+    if (!ctx) return false;
+    sa_payload_init();
+    pack(wid);
+    sa_cache_forget(ctx, wid);
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_UNMINIMIZE);
+}
+
+bool mss_window_is_minimized(mss_context *ctx, uint32_t wid, bool *result)
+{
+    if (!ctx || !result) return false;
+
+    struct sa_window_record record;
+    if (sa_local_window(ctx, wid, SA_STATE_ORDERED, &record)) {
+        *result = !record.ordered_in;
+        return true;
+    }
+
+    sa_query_init();
+    query_pack(wid);
+
+    return sa_query_send(ctx, SA_OPCODE_WINDOW_IS_MINIMIZED, sa_decode_flag, result) == MSS_SUCCESS;
+}
+
+bool mss_window_get_opacity(mss_context *ctx, uint32_t wid, float *opacity)
+{
+    if (!ctx || !opacity) return false;
+
+    struct sa_window_record record;
+    if (sa_cache_get(ctx, wid, SA_STATE_ALPHA, &record) || sa_local_window(ctx, wid, SA_STATE_ALPHA, &record)) {
+        *opacity = record.alpha;
+        return true;
+    }
+
+    bool fill = sa_cache_fillable(ctx);
+    sa_query_init();
+    query_pack(wid);
+
+    if (sa_query_send(ctx, SA_OPCODE_WINDOW_GET_OPACITY, sa_decode_float, opacity) != MSS_SUCCESS) return false;
+    if (fill) sa_cache_put(ctx, wid, SA_STATE_ALPHA, &(struct sa_window_record) { .alpha = *opacity });
+    return true;
+}
+
+bool mss_window_get_frame(mss_context *ctx, uint32_t wid,
+                                 int *x, int *y, int *width, int *height)
+{
+    if (!ctx || !x || !y || !width || !height) return false;
+
+    struct sa_window_record record;
+    if (sa_cache_get(ctx, wid, SA_STATE_FRAME, &record) || sa_local_window(ctx, wid, SA_STATE_FRAME, &record)) {
+        *x = record.x, *y = record.y, *width = record.width, *height = record.height;
+        return true;
+    }
+
+    bool fill = sa_cache_fillable(ctx);
+    sa_query_init();
+    query_pack(wid);
+
+    if (sa_query_send(ctx, SA_OPCODE_WINDOW_GET_FRAME, sa_decode_frame, x, y, width, height) != MSS_SUCCESS) return false;
+    if (fill) sa_cache_put(ctx, wid, SA_STATE_FRAME, &(struct sa_window_record) { .x = *x, .y = *y, .width = *width, .height = *height });
+    return true;
+}
+
+bool mss_window_is_sticky(mss_context *ctx, uint32_t wid, bool *sticky)
+{
+    if (!ctx || !sticky) return false;
+
+    struct sa_window_record record;
+    if (sa_cache_get(ctx, wid, SA_STATE_TAGS, &record) || sa_local_window(ctx, wid, SA_STATE_TAGS, &record)) {
+        *sticky = (record.tags & 0x800) != 0;
+        return true;
+    }
+
+    bool fill = sa_cache_fillable(ctx);
+    sa_query_init();
+    query_pack(wid);
+
+    if (sa_query_send(ctx, SA_OPCODE_WINDOW_IS_STICKY, sa_decode_flag, sticky) != MSS_SUCCESS) return false;
+    // Only the sticky bit is known; that is all the cache is asked for
+    if (fill) sa_cache_put(ctx, wid, SA_STATE_TAGS, &(struct sa_window_record) { .tags = *sticky ? 0x800 : 0 });
+    return true;
+}
+
+bool mss_window_get_layer(mss_context *ctx, uint32_t wid,
+                                 enum mss_window_layer *layer)
+{
+    if (!ctx || !layer) return false;
+
+    struct sa_window_record record;
+    if (sa_cache_get(ctx, wid, SA_STATE_LEVEL, &record) || sa_local_window(ctx, wid, SA_STATE_LEVEL, &record)) {
+        *layer = (enum mss_window_layer) record.level;
+        return true;
+    }
+
+    bool fill = sa_cache_fillable(ctx);
+    sa_query_init();
+    query_pack(wid);
+
+    if (sa_query_send(ctx, SA_OPCODE_WINDOW_GET_LAYER, sa_decode_layer, layer) != MSS_SUCCESS) return false;
+    if (fill) sa_cache_put(ctx, wid, SA_STATE_LEVEL, &(struct sa_window_record) { .level = *layer });
+    return true;
+}
+
+//
+// NOTE: Ids are sent in chunks of SA_SNAPSHOT_MAX, so a snapshot of up to
+// that many windows is a single round trip however large the reply is.
+//
+
+int mss_window_snapshot(mss_context *ctx, const uint32_t *wids, int count,
+                        struct mss_window_state *states)
+{
+    if (!ctx || count < 0 || (count && (!wids || !states))) return MSS_ERROR_INVALID_ARG;
+
+    int chunk_max = count < SA_SNAPSHOT_MAX ? count : SA_SNAPSHOT_MAX;
+    int send_size = sizeof(int16_t) + 1 + sizeof(uint32_t) + sizeof(uint32_t) * chunk_max;
+    char *send_buf = malloc(send_size);
+    if (!send_buf) return MSS_ERROR_OPERATION;
+
+    int result = MSS_SUCCESS;
+
+    for (int offset = 0; offset < count || offset == 0; offset += chunk_max) {
+        uint32_t chunk = count - offset < chunk_max ? count - offset : chunk_max;
+        int16_t send_len = sizeof(int16_t) + 1 + sizeof(chunk) + sizeof(uint32_t) * chunk;
+
+        *(int16_t *) send_buf = send_len - sizeof(send_len);
+        send_buf[sizeof(send_len)] = SA_OPCODE_WINDOW_SNAPSHOT;
+        memcpy(send_buf + sizeof(send_len) + 1, &chunk, sizeof(chunk));
+        memcpy(send_buf + sizeof(send_len) + 1 + sizeof(chunk), wids + offset, sizeof(uint32_t) * chunk);
+
+        result = sa_transact(ctx, send_buf, send_len, sa_decode_snapshot, (void *[4]) { states + offset, (void *)(uintptr_t) chunk });
+        if (result != MSS_SUCCESS) break;
+
+        if (!count) break;
+    }
+
+    free(send_buf);
+    return result;
+}
+
+int mss_display_get_count(mss_context *ctx, uint32_t *count)
+{
+    if (!ctx || !count) return MSS_ERROR_INVALID_ARG;
+
+    struct sa_state_displays local;
+    if (sa_local_displays(ctx, &local)) {
+        *count = local.count;
+        return MSS_SUCCESS;
+    }
+
+    sa_query_init();
+
+    return sa_query_send(ctx, SA_OPCODE_DISPLAY_GET_COUNT, sa_decode_uint32, count);
+}
+
+int mss_display_get_list(mss_context *ctx, uint32_t *displays, size_t max_count)
+{
+    if (!ctx || !displays) return MSS_ERROR_INVALID_ARG;
+
+    struct sa_state_displays local;
+    if (sa_local_displays(ctx, &local)) {
+        for (size_t i = 0; i < local.count && i < max_count; i++) displays[i] = local.ids[i];
+        return MSS_SUCCESS;
+    }
+
+    sa_query_init();
+    query_pack((uint32_t)max_count);
+
+    return sa_query_send(ctx, SA_OPCODE_DISPLAY_GET_LIST, sa_decode_display_list, displays, (void *)(uintptr_t) max_count);
+}
+
+int mss_display_get_current_space(mss_context *ctx, uint32_t did, uint64_t *sid)
+{
+    if (!ctx || !sid) return MSS_ERROR_INVALID_ARG;
+
+    struct sa_state_displays local;
+    if (sa_local_displays(ctx, &local)) {
+        for (uint32_t i = 0; i < local.count; ++i) {
+            if (local.ids[i] != did) continue;
+            *sid = local.spaces[i];
+            return MSS_SUCCESS;
+        }
+    }
+
+    sa_query_init();
+    query_pack(did);
+
+    return sa_query_send(ctx, SA_OPCODE_DISPLAY_GET_SPACE, sa_decode_uint64, sid);
+}
+
+// ============================================================================
+// Diagnostics
+// ============================================================================
+
+int mss_get_stats(mss_context *ctx, struct mss_stats *stats)
+{
+    if (!ctx || !stats) return MSS_ERROR_INVALID_ARG;
+
+    sa_query_init();
+
+    return sa_query_send(ctx, SA_OPCODE_STATS, sa_decode_stats, stats);
+}
+
+// ============================================================================
+// Window Animation
+// ============================================================================
+
+bool mss_window_swap_proxy_in(mss_context *ctx,
+                                    struct mss_window_animation *animations,
+                                    int count)
+{
+    if (!ctx || !animations) return false;
+
+    sa_payload_init();
+    pack(count);
+    for (int i = 0; i < count; ++i) {
+        sa_cache_forget(ctx, animations[i].wid);
+        pack(animations[i].wid);
+        pack(animations[i].proxy_wid);
+    }
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SWAP_PROXY_IN);
+}
+
+bool mss_window_swap_proxy_out(mss_context *ctx,
+                                     struct mss_window_animation *animations,
+                                     int count)
+{
+    if (!ctx || !animations) return false;
+
+    sa_payload_init();
+    pack(count);
+    for (int i = 0; i < count; ++i) {
+        sa_cache_forget(ctx, animations[i].wid);
+        pack(animations[i].wid);
+        pack(animations[i].proxy_wid);
+    }
+    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SWAP_PROXY_OUT);
+}
+
+// ============================================================================
+// Batch Operations
+// ============================================================================
+
+// Batch message header: length prefix, opcode and operation count
+#define SA_BATCH_HEADER_SIZE (sizeof(int16_t) + 1 + sizeof(int))
+
+struct mss_batch {
+    mss_context *ctx;
+    uint8_t opcode;     // SA_OPCODE_BATCH or SA_OPCODE_WINDOW_TRANSACTION
+    int count;          // Operations in the pending message
+    int length;         // Bytes used in the pending message
+    bool failed;        // An automatic flush was lost, or a transaction overflowed
+    char bytes[SA_MESSAGE_MAX];
+};
+
+// A transaction is a batch that must reach the payload as a single message
+struct mss_txn {
+    struct mss_batch batch;
+};
+
+static void sa_batch_reset(mss_batch *batch)
+{
+    batch->count = 0;
+    batch->length = SA_BATCH_HEADER_SIZE;
+}
+
+static bool sa_batch_flush(mss_batch *batch)
+{
+    if (batch->count == 0) return true;
+
+    *(int16_t *) batch->bytes = batch->length - sizeof(int16_t);
+    batch->bytes[sizeof(int16_t)] = batch->opcode;
+    memcpy(batch->bytes + sizeof(int16_t) + 1, &batch->count, sizeof(int));
+
+    // Operations may name any window
+    sa_cache_clear(batch->ctx);
+
+    bool result = sa_send_bytes(batch->ctx, batch->bytes, batch->length);
+    sa_batch_reset(batch);
+    return result;
+}
+
+//
+// NOTE: Operations are packed exactly like standalone messages and appended
+// to the pending batch. A batch that would outgrow SA_MESSAGE_MAX is sent
+// early, so arbitrarily long batches cost one round trip per full message.
+// A transaction cannot be split without losing atomicity, so it is marked
+// as failed instead.
+//
+
+static bool sa_batch_append(mss_batch *batch, char *bytes, int16_t length, uint8_t op)
+{
+    *(int16_t *) bytes = length - sizeof(length);
+    bytes[sizeof(length)] = op;
+
+    if (batch->length + length > SA_MESSAGE_MAX) {
+        if (batch->opcode == SA_OPCODE_WINDOW_TRANSACTION) {
+            batch->failed = true;
+            return false;
+        }
+
+        if (!sa_batch_flush(batch)) batch->failed = true;
+    }
+
+    memcpy(batch->bytes + batch->length, bytes, length);
+    batch->length += length;
+    batch->count += 1;
+    return true;
+}
+
+#define sa_batch_add(batch, op) sa_batch_append(batch, bytes, length, op)
+
+mss_batch *mss_batch_create(mss_context *ctx)
+{
+    if (!ctx) return NULL;
+
+    mss_batch *batch = malloc(sizeof(mss_batch));
+    if (!batch) return NULL;
+
+    batch->ctx = ctx;
+    batch->opcode = SA_OPCODE_BATCH;
+    batch->failed = false;
+    sa_batch_reset(batch);
+    return batch;
+}
+
+void mss_batch_destroy(mss_batch *batch)
+{
+    if (batch) {
+        free(batch);
+    }
+}
+
+int mss_batch_count(mss_batch *batch)
+{
+    return batch ? batch->count : 0;
+}
+
+bool mss_batch_commit(mss_batch *batch)
+{
+    if (!batch) return false;
+
+    bool result = sa_batch_flush(batch) && !batch->failed;
+    batch->failed = false;
+    return result;
+}
+
+void mss_batch_clear(mss_batch *batch)
+{
+    if (batch) {
+        batch->failed = false;
+        sa_batch_reset(batch);
+    }
+}
+
+bool mss_batch_window_move(mss_batch *batch, uint32_t wid, int x, int y)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(x);
+    pack(y);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_MOVE);
+}
+
+bool mss_batch_window_set_opacity(mss_batch *batch, uint32_t wid, float opacity)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(opacity);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_OPACITY);
+}
+
+bool mss_batch_window_fade_opacity(mss_batch *batch, uint32_t wid,
+                                   float opacity, float duration)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(opacity);
+    pack(duration);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_OPACITY_FADE);
+}
+
+bool mss_batch_window_set_layer(mss_batch *batch, uint32_t wid,
+                                enum mss_window_layer layer)
+{
+    if (!batch) return false;
+    int layer_value = (int)layer;
+    sa_payload_init();
+    pack(wid);
+    pack(layer_value);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_LAYER);
+}
+
+bool mss_batch_window_set_sticky(mss_batch *batch, uint32_t wid, bool sticky)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(sticky);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_STICKY);
+}
+
+bool mss_batch_window_set_shadow(mss_batch *batch, uint32_t wid, bool shadow)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(shadow);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_SHADOW);
+}
+
+bool mss_batch_window_order(mss_batch *batch, uint32_t wid,
+                            enum mss_window_order order, uint32_t relative_wid)
+{
+    if (!batch) return false;
+    int order_value = (int)order;
+    sa_payload_init();
+    pack(wid);
+    pack(order_value);
+    pack(relative_wid);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_ORDER);
+}
+
+bool mss_batch_window_move_to_space(mss_batch *batch, uint32_t wid, uint64_t sid)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(sid);
+    pack(wid);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_TO_SPACE);
+}
+
+bool mss_batch_window_resize(mss_batch *batch, uint32_t wid, int width, int height)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(width);
+    pack(height);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_RESIZE);
+}
+
+bool mss_batch_window_set_frame(mss_batch *batch, uint32_t wid,
+                                int x, int y, int width, int height)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(x);
+    pack(y);
+    pack(width);
+    pack(height);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_SET_FRAME);
+}
+
+bool mss_batch_window_minimize(mss_batch *batch, uint32_t wid)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_MINIMIZE);
+}
+
+bool mss_batch_window_unminimize(mss_batch *batch, uint32_t wid)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(wid);
+    return sa_batch_add(batch, SA_OPCODE_WINDOW_UNMINIMIZE);
+}
+
+bool mss_batch_space_focus(mss_batch *batch, uint64_t sid)
+{
+    if (!batch) return false;
+    sa_payload_init();
+    pack(sid);
+    return sa_batch_add(batch, SA_OPCODE_SPACE_FOCUS);
+}
+
+// ============================================================================
+// Window Transactions
+// ============================================================================
+
+mss_txn *mss_txn_begin(mss_context *ctx)
+{
+    if (!ctx) return NULL;
+
+    mss_txn *txn = malloc(sizeof(mss_txn));
+    if (!txn) return NULL;
+
+    txn->batch.ctx = ctx;
+    txn->batch.opcode = SA_OPCODE_WINDOW_TRANSACTION;
+    txn->batch.failed = false;
+    sa_batch_reset(&txn->batch);
+    return txn;
+}
+
+bool mss_txn_move(mss_txn *txn, uint32_t wid, int x, int y)
+{
+    if (!txn) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(x);
+    pack(y);
+    return sa_batch_add(&txn->batch, SA_OPCODE_WINDOW_MOVE);
+}
+
+bool mss_txn_set_opacity(mss_txn *txn, uint32_t wid, float opacity)
+{
+    if (!txn) return false;
+    sa_payload_init();
+    pack(wid);
+    pack(opacity);
+    return sa_batch_add(&txn->batch, SA_OPCODE_WINDOW_OPACITY);
+}
+
+bool mss_txn_order(mss_txn *txn, uint32_t wid,
+                   enum mss_window_order order, uint32_t relative_wid)
+{
+    if (!txn) return false;
+    int order_value = (int)order;
+    sa_payload_init();
+    pack(wid);
+    pack(order_value);
+    pack(relative_wid);
+    return sa_batch_add(&txn->batch, SA_OPCODE_WINDOW_ORDER);
+}
+
+bool mss_txn_set_layer(mss_txn *txn, uint32_t wid, enum mss_window_layer layer)
+{
+    if (!txn) return false;
+    int layer_value = (int)layer;
+    sa_payload_init();
+    pack(wid);
+    pack(layer_value);
+    return sa_batch_add(&txn->batch, SA_OPCODE_WINDOW_LAYER);
+}
+
+bool mss_txn_commit(mss_txn *txn)
+{
+    if (!txn) return false;
+
+    bool result = false;
+    if (txn->batch.failed) {
+        sa_log("ERROR: Transaction exceeds the maximum message size, nothing was applied");
+    } else {
+        result = sa_batch_flush(&txn->batch);
+    }
+
+    free(txn);
+    return result;
+}
+
+void mss_txn_abort(mss_txn *txn)
+{
+    if (txn) {
+        free(txn);
+    }
+}
+
+// ============================================================================
+// Asynchronous Operations
+// ============================================================================
+
+//
+// NOTE: An asynchronous call is its synchronous counterpart with a callback
+// armed on the context. The first request the call sends claims the callback
+// and returns without waiting (see sa_transact_session). A call that succeeds
+// without sending anything completes with MSS_SUCCESS on the next dispatch;
+// one that fails before sending leaves no callback behind.
+//
+
+static bool sa_async_arm(mss_context *ctx, mss_completion_callback callback, void *userdata)
+{
+    if (!ctx || !callback) return false;
+
+    if (!ctx->persistent) {
+        sa_log("ERROR: Asynchronous calls need a persistent context");
+        return false;
+    }
+
+    if (!sa_pending_reserve(ctx, SA_ASYNC_DEPTH)) return false;
+
+    ctx->async_callback = callback;
+    ctx->async_userdata = userdata;
+    return true;
+}
+
+static bool sa_async_disarm(mss_context *ctx, bool sent)
+{
+    if (ctx->async_callback) {
+        if (sent) sa_completion_push(ctx, ctx->async_callback, ctx->async_userdata, MSS_SUCCESS);
+        ctx->async_callback = NULL;
+    }
+    return sent;
+}
+
+#define sa_async(ctx, callback, userdata, call) (sa_async_arm(ctx, callback, userdata) && sa_async_disarm(ctx, (call)))
+
+static bool sa_session_readable(mss_context *ctx)
+{
+    struct pollfd pfd = { .fd = ctx->session_fd, .events = POLLIN };
+    return poll(&pfd, 1, 0) > 0;
+}
+
+int mss_async_fd(mss_context *ctx)
+{
+    if (!ctx || !ctx->persistent) return -1;
+    if (ctx->session_fd == -1 && !sa_session_open(ctx)) return -1;
+    return ctx->session_fd;
+}
+
+int mss_async_dispatch(mss_context *ctx)
+{
+    if (!ctx) return MSS_ERROR_INVALID_ARG;
+
+    while (ctx->in_flight && sa_session_readable(ctx)) {
+        if (!sa_session_pump(ctx)) break;
+    }
+
+    return sa_deliver_completions(ctx);
+}
+
+int mss_async_wait(mss_context *ctx)
+{
+    if (!ctx) return MSS_ERROR_INVALID_ARG;
+
+    while (ctx->in_flight && sa_session_pump(ctx));
+
+    return sa_deliver_completions(ctx);
+}
+
+bool mss_space_create_async(mss_context *ctx, uint64_t sid,
+                            mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_space_create(ctx, sid));
+}
+
+bool mss_space_destroy_async(mss_context *ctx, uint64_t sid,
+                             mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_space_destroy(ctx, sid));
+}
+
+bool mss_space_focus_async(mss_context *ctx, uint64_t sid,
+                           mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_space_focus(ctx, sid));
+}
+
+bool mss_space_move_async(mss_context *ctx, uint64_t src_sid, uint64_t dst_sid,
+                          uint64_t src_prev_sid, bool focus,
+                          mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_space_move(ctx, src_sid, dst_sid, src_prev_sid, focus));
+}
+
+bool mss_window_move_async(mss_context *ctx, uint32_t wid, int x, int y,
+                           mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_move(ctx, wid, x, y));
+}
+
+bool mss_window_set_opacity_async(mss_context *ctx, uint32_t wid, float opacity,
+                                  mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_set_opacity(ctx, wid, opacity));
+}
+
+bool mss_window_fade_opacity_async(mss_context *ctx, uint32_t wid, float opacity, float duration,
+                                   mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_fade_opacity(ctx, wid, opacity, duration));
+}
+
+bool mss_window_set_layer_async(mss_context *ctx, uint32_t wid, enum mss_window_layer layer,
+                                mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_set_layer(ctx, wid, layer));
+}
+
+bool mss_window_set_sticky_async(mss_context *ctx, uint32_t wid, bool sticky,
+                                 mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_set_sticky(ctx, wid, sticky));
+}
+
+bool mss_window_set_shadow_async(mss_context *ctx, uint32_t wid, bool shadow,
+                                 mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_set_shadow(ctx, wid, shadow));
+}
+
+bool mss_window_focus_async(mss_context *ctx, uint32_t wid,
+                            mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_focus(ctx, wid));
+}
+
+bool mss_window_scale_async(mss_context *ctx, uint32_t wid, float x, float y, float w, float h,
+                            mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_scale(ctx, wid, x, y, w, h));
+}
+
+bool mss_window_order_async(mss_context *ctx, uint32_t wid,
+                            enum mss_window_order order, uint32_t relative_wid,
+                            mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_order(ctx, wid, order, relative_wid));
+}
+
+bool mss_window_order_in_async(mss_context *ctx, uint32_t *window_list, int count,
+                               mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_order_in(ctx, window_list, count));
+}
+
+bool mss_window_move_to_space_async(mss_context *ctx, uint32_t wid, uint64_t sid,
+                                    mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_move_to_space(ctx, wid, sid));
+}
+
+bool mss_window_list_move_to_space_async(mss_context *ctx, uint32_t *window_list, int count, uint64_t sid,
+                                         mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_list_move_to_space(ctx, window_list, count, sid));
+}
+
+bool mss_window_resize_async(mss_context *ctx, uint32_t wid, int width, int height,
+                             mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_resize(ctx, wid, width, height));
+}
+
+bool mss_window_set_frame_async(mss_context *ctx, uint32_t wid, int x, int y, int width, int height,
+                                mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_set_frame(ctx, wid, x, y, width, height));
+}
+
+bool mss_window_minimize_async(mss_context *ctx, uint32_t wid,
+                               mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_minimize(ctx, wid));
+}
+
+bool mss_window_unminimize_async(mss_context *ctx, uint32_t wid,
+                                 mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_unminimize(ctx, wid));
+}
+
+bool mss_window_swap_proxy_in_async(mss_context *ctx, struct mss_window_animation *animations, int count,
+                                    mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_swap_proxy_in(ctx, animations, count));
+}
+
+bool mss_window_swap_proxy_out_async(mss_context *ctx, struct mss_window_animation *animations, int count,
+                                     mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_swap_proxy_out(ctx, animations, count));
+}
+
+bool mss_window_is_minimized_async(mss_context *ctx, uint32_t wid, bool *result,
+                                   mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_is_minimized(ctx, wid, result));
+}
+
+bool mss_window_get_opacity_async(mss_context *ctx, uint32_t wid, float *opacity,
+                                  mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_get_opacity(ctx, wid, opacity));
+}
+
+bool mss_window_get_frame_async(mss_context *ctx, uint32_t wid, int *x, int *y, int *width, int *height,
+                                mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_get_frame(ctx, wid, x, y, width, height));
+}
+
+bool mss_window_is_sticky_async(mss_context *ctx, uint32_t wid, bool *sticky,
+                                mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_is_sticky(ctx, wid, sticky));
+}
+
+bool mss_window_get_layer_async(mss_context *ctx, uint32_t wid, enum mss_window_layer *layer,
+                                mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_window_get_layer(ctx, wid, layer));
+}
+
+bool mss_window_snapshot_async(mss_context *ctx, const uint32_t *wids, int count,
+                               struct mss_window_state *states,
+                               mss_completion_callback callback, void *userdata)
+{
+    // One request, so that one callback covers the whole snapshot
+    if (count > SA_SNAPSHOT_MAX) return false;
+    return sa_async(ctx, callback, userdata, mss_window_snapshot(ctx, wids, count, states) == MSS_SUCCESS);
+}
+
+bool mss_display_get_count_async(mss_context *ctx, uint32_t *count,
+                                 mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_display_get_count(ctx, count) == MSS_SUCCESS);
+}
+
+bool mss_display_get_list_async(mss_context *ctx, uint32_t *displays, size_t max_count,
+                                mss_completion_callback callback, void *userdata)
+{
+    return sa_async(ctx, callback, userdata, mss_display_get_list(ctx, displays, max_count) == MSS_SUCCESS);
+}
+
+bool mss_batch_commit_async(mss_batch *batch, mss_completion_callback callback, void *userdata)
+{
+    if (!batch) return false;
+
+    // Operations already lost in an automatic flush can only be reported here
+    if (batch->failed) {
+        mss_batch_commit(batch);
+        return false;
+    }
+
+    return sa_async(batch->ctx, callback, userdata, sa_batch_flush(batch));
+}
+
+bool mss_txn_commit_async(mss_txn *txn, mss_completion_callback callback, void *userdata)
+{
+    if (!txn) return false;
+
+    bool result = false;
+    if (txn->batch.failed) {
+        sa_log("ERROR: Transaction exceeds the maximum message size, nothing was applied");
+    } else {
+        result = sa_async(txn->batch.ctx, callback, userdata, sa_batch_flush(&txn->batch));
+    }
+
+    free(txn);
+    return result;
+}
+
+// ============================================================================
+// Change Notifications
+// ============================================================================
+
+// Most windows one subscription can name
+#define SA_SUBSCRIBE_MAX ((SA_MESSAGE_MAX - sizeof(int16_t) - 1 - 2 * sizeof(uint32_t)) / sizeof(uint32_t))
+
+//
+// NOTE: A subscription has a connection of its own, separate from the
+// session, since the payload sends on it whenever something changes. Events
+// are copied out of the receive buffer before their callbacks run, so that
+// the callbacks are free to make calls on the context.
+//
+
+int mss_subscribe(mss_context *ctx, uint32_t events, const uint32_t *wids, int count,
+                  mss_event_callback callback, void *userdata)
+{
+    if (!ctx || !callback || count < 0 || (count && !wids) || (size_t) count > SA_SUBSCRIBE_MAX) return MSS_ERROR_INVALID_ARG;
+
+    mss_unsubscribe(ctx);
+
+    int length = sizeof(int16_t) + 1 + 2 * sizeof(uint32_t) + sizeof(uint32_t) * count;
+    char *bytes = malloc(length);
+    if (!bytes) return MSS_ERROR_OPERATION;
+
+    uint32_t wid_count = count;
+    *(int16_t *) bytes = length - sizeof(int16_t);
+    bytes[sizeof(int16_t)] = SA_OPCODE_SUBSCRIBE;
+    memcpy(bytes + sizeof(int16_t) + 1, &events, sizeof(events));
+    memcpy(bytes + sizeof(int16_t) + 1 + sizeof(events), &wid_count, sizeof(wid_count));
+    if (count) memcpy(bytes + sizeof(int16_t) + 1 + 2 * sizeof(uint32_t), wids, sizeof(uint32_t) * count);
+
+    int sockfd;
+    if (!socket_open(&sockfd)) {
+        free(bytes);
+        return MSS_ERROR_CONNECTION;
+    }
+    socket_set_nosigpipe(sockfd);
+
+    struct sa_response_header header;
+    int result = MSS_ERROR_CONNECTION;
+    if (socket_connect(sockfd, ctx->socket_path) && sa_send_request(ctx, sockfd, 0, bytes, length)) {
+        result = sa_read_response(ctx, sockfd, &header);
+        if (result == MSS_SUCCESS) result = sa_decode_response(ctx, &header, NULL, NULL);
+    }
+    free(bytes);
+
+    if (result != MSS_SUCCESS) {
+        sa_log("ERROR: Failed to subscribe to changes");
+        socket_close(sockfd);
+        return result;
+    }
+
+    ctx->event_fd = sockfd;
+    ctx->event_callback = callback;
+    ctx->event_userdata = userdata;
+    return MSS_SUCCESS;
+}
+
+int mss_subscription_fd(mss_context *ctx)
+{
+    return ctx ? ctx->event_fd : -1;
+}
+
+int mss_subscription_dispatch(mss_context *ctx)
+{
+    if (!ctx) return MSS_ERROR_INVALID_ARG;
+    if (ctx->event_fd == -1) return MSS_ERROR_CONNECTION;
+
+    int delivered = 0;
+    struct pollfd pfd = { .fd = ctx->event_fd, .events = POLLIN };
+    while (ctx->event_fd != -1 && poll(&pfd, 1, 0) > 0) {
+        struct sa_response_header header;
+        int result = sa_read_response(ctx, ctx->event_fd, &header);
+        if (result == MSS_SUCCESS && (header.status != SA_STATUS_OK || header.length % sizeof(struct sa_event))) {
+            result = MSS_ERROR_PROTOCOL;
+        }
+
+        if (result != MSS_SUCCESS) {
+            sa_log("ERROR: Subscription lost");
+            mss_unsubscribe(ctx);
+            return result;
+        }
+
+        int count = header.length / sizeof(struct sa_event);
+        struct sa_event *events = malloc(header.length ? header.length : 1);
+        if (!events) return MSS_ERROR_OPERATION;
+        memcpy(events, ctx->recv_buf, header.length);
+
+        // A callback may unsubscribe, which drops the rest of the frame
+        mss_event_callback callback = ctx->event_callback;
+        void *userdata = ctx->event_userdata;
+        for (int i = 0; i < count && ctx->event_callback == callback; ++i) {
+            struct mss_event event = { .events = events[i].events, .id = events[i].id, .sid = events[i].sid };
+            callback(ctx, &event, userdata);
+            ++delivered;
+        }
+
+        free(events);
+        pfd.fd = ctx->event_fd;
+    }
+
+    return delivered;
+}
+
+void mss_unsubscribe(mss_context *ctx)
+{
+    if (!ctx || ctx->event_fd == -1) return;
+
+    socket_close(ctx->event_fd);
+    ctx->event_fd = -1;
+    ctx->event_callback = NULL;
+    ctx->event_userdata = NULL;
+}
+
+#undef sa_async
+#undef sa_batch_add
+#undef sa_payload_init
+#undef pack
+#undef sa_payload_send
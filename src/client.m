@@ -1,8 +1,3 @@
-#include "../include/mss.h"
-#include "../include/mss_types.h"
-#include "common.h"
-#include "util.h"
-
 #include <Cocoa/Cocoa.h>
 #include <CoreGraphics/CoreGraphics.h>
 #include <stdio.h>
@@ -22,38 +17,7 @@ extern int csr_get_active_config(uint32_t *config);
 #define CSR_ALLOW_UNRESTRICTED_FS 0x02
 #define CSR_ALLOW_TASK_FOR_PID    0x04
 
-// External SkyLight functions
-extern int SLSMainConnectionID(void);
-extern int SLSWindowIsOrderedIn(int cid, uint32_t wid, uint8_t *ordered_in);
-
-// Maximum path length
-#define MAXLEN 4096
-
-// Socket path format
-#define SA_SOCKET_PATH_FMT "/tmp/mss_%s.socket"
-
-// Global logging callback
-static mss_log_callback g_log_callback = NULL;
-
-// Helper to log messages
-static void sa_log(const char *format, ...) __attribute__((format(printf, 1, 2)));
-static void sa_log(const char *format, ...)
-{
-    if (g_log_callback) {
-        char buffer[4096];
-        va_list args;
-        va_start(args, format);
-        vsnprintf(buffer, sizeof(buffer), format, args);
-        va_end(args);
-        g_log_callback(buffer);
-    }
-}
-
-// Context structure
-struct mss_context {
-    char socket_path[MAXLEN];
-    int connection_id;  // SkyLight connection ID
-};
+#include "client.c"
 
 // Plist contents for SA bundle
 static char sa_plist[] =
@@ -248,176 +212,6 @@ static void sa_restart_dock(void)
     [dock makeObjectsPerformSelector:@selector(terminate)];
 }
 
-static bool sa_send_bytes(mss_context *ctx, char *bytes, int length)
-{
-    int sockfd;
-    char dummy;
-    bool result = false;
-
-    if (socket_open(&sockfd)) {
-        if (socket_connect(sockfd, ctx->socket_path)) {
-            if (send(sockfd, bytes, length, 0) != -1) {
-                recv(sockfd, &dummy, 1, 0);
-                result = true;
-            }
-        }
-
-        socket_close(sockfd);
-    }
-
-    return result;
-}
-
-// Query operation helper - sends request and receives response
-static bool sa_query_bytes(mss_context *ctx, char *send_bytes, int send_length,
-                           void *recv_buffer, int recv_buffer_size, int *bytes_received)
-{
-    int sockfd;
-    bool result = false;
-
-    if (!socket_open(&sockfd)) {
-        sa_log("ERROR: Failed to open socket for query");
-        return false;
-    }
-
-    if (!socket_connect(sockfd, ctx->socket_path)) {
-        sa_log("ERROR: Failed to connect socket for query");
-        socket_close(sockfd);
-        return false;
-    }
-
-    if (send(sockfd, send_bytes, send_length, 0) == -1) {
-        sa_log("ERROR: Failed to send query request");
-        socket_close(sockfd);
-        return false;
-    }
-
-    // Receive response
-    int received = recv(sockfd, recv_buffer, recv_buffer_size, 0);
-    if (received > 0) {
-        if (bytes_received) *bytes_received = received;
-        result = true;
-    } else {
-        sa_log("ERROR: Failed to receive query response (received=%d)", received);
-    }
-
-    socket_close(sockfd);
-    return result;
-}
-
-// ============================================================================
-// Context Management
-// ============================================================================
-
-mss_context *mss_create(const char *socket_path)
-{
-    mss_context *ctx = malloc(sizeof(mss_context));
-    if (!ctx) return NULL;
-
-    if (socket_path) {
-        snprintf(ctx->socket_path, sizeof(ctx->socket_path), "%s", socket_path);
-    } else {
-        // Resolve socket path - handle sudo case like yabai does
-        const char *sudo_uid = getenv("SUDO_UID");
-        uid_t uid = getuid();
-        const char *user = NULL;
-
-        // If running as root via sudo, get the original user
-        if (uid == 0 && sudo_uid) {
-            unsigned int target_uid;
-            if (sscanf(sudo_uid, "%u", &target_uid) == 1) {
-                struct passwd *pw = getpwuid(target_uid);
-                if (pw) {
-                    user = pw->pw_name;
-                }
-            }
-        }
-
-        // Fallback to current user
-        if (!user) {
-            user = getenv("USER");
-        }
-
-        if (!user) {
-            free(ctx);
-            return NULL;
-        }
-
-        snprintf(ctx->socket_path, sizeof(ctx->socket_path), SA_SOCKET_PATH_FMT, user);
-    }
-
-    ctx->connection_id = SLSMainConnectionID();
-
-    return ctx;
-}
-
-void mss_destroy(mss_context *ctx)
-{
-    if (ctx) {
-        free(ctx);
-    }
-}
-
-void mss_set_log_callback(mss_log_callback callback)
-{
-    g_log_callback = callback;
-}
-
-const char *mss_get_socket_path(mss_context *ctx)
-{
-    return ctx ? ctx->socket_path : NULL;
-}
-
-int mss_handshake(mss_context *ctx, uint32_t *capabilities, const char **version)
-{
-    if (!ctx) return MSS_ERROR_INVALID_ARG;
-
-    sa_log("Performing handshake with scripting addition...");
-    sa_log("Socket path: %s", ctx->socket_path);
-
-    int sockfd;
-    char rsp[BUFSIZ] = {0};
-    char bytes[0x1000] = { 0x01, 0x00, SA_OPCODE_HANDSHAKE };
-    static char version_buf[0x1000] = {0};
-
-    if (!socket_open(&sockfd)) {
-        sa_log("ERROR: Failed to open socket");
-        return MSS_ERROR_CONNECTION;
-    }
-
-    if (!socket_connect(sockfd, ctx->socket_path)) {
-        sa_log("ERROR: Failed to connect to socket - payload not running?");
-        socket_close(sockfd);
-        return MSS_ERROR_CONNECTION;
-    }
-
-    if (send(sockfd, bytes, 3, 0) == -1) {
-        sa_log("ERROR: Failed to send handshake message");
-        socket_close(sockfd);
-        return MSS_ERROR_CONNECTION;
-    }
-
-    int length = recv(sockfd, rsp, sizeof(rsp)-1, 0);
-    socket_close(sockfd);
-
-    if (length <= 0) {
-        sa_log("ERROR: No response from payload");
-        return MSS_ERROR_CONNECTION;
-    }
-
-    char *zero = rsp;
-    while (*zero != '\0') ++zero;
-
-    memcpy(version_buf, rsp, zero - rsp + 1);
-    memcpy(capabilities, zero+1, sizeof(uint32_t));
-
-    if (version) *version = version_buf;
-
-    sa_log("Handshake successful - Version: %s, Capabilities: 0x%X", version_buf, *capabilities);
-
-    return MSS_SUCCESS;
-}
-
 // ============================================================================
 // Requirements Checking
 // ============================================================================
@@ -671,414 +465,3 @@ int mss_load(mss_context *ctx)
         return MSS_ERROR_LOAD;
     }
 }
-
-// ============================================================================
-// Message sending macros
-// ============================================================================
-
-#define sa_payload_init() char bytes[0x1000]; int16_t length = 1+sizeof(length)
-#define pack(v) memcpy(bytes+length, &v, sizeof(v)); length += sizeof(v)
-#define sa_payload_send(ctx, op) *(int16_t*)bytes = length-sizeof(length), bytes[sizeof(length)] = op, sa_send_bytes(ctx, bytes, length)
-
-// Query operation macros
-#define sa_query_init() char send_buf[0x1000]; char recv_buf[0x1000]; int16_t send_len = 1+sizeof(send_len); int recv_len = 0
-#define query_pack(v) do { typeof(v) _tmp = (v); memcpy(send_buf+send_len, &_tmp, sizeof(_tmp)); send_len += sizeof(_tmp); } while(0)
-#define sa_query_send(ctx, op) (*(int16_t*)send_buf = send_len-sizeof(send_len), send_buf[sizeof(send_len)] = op, sa_query_bytes(ctx, send_buf, send_len, recv_buf, sizeof(recv_buf), &recv_len))
-#define unpack_response(v) do { memcpy(&v, recv_buf + unpack_offset, sizeof(v)); unpack_offset += sizeof(v); } while(0)
-
-// ============================================================================
-// Space Operations
-// ============================================================================
-
-bool mss_space_create(mss_context *ctx, uint64_t sid)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(sid);
-    return sa_payload_send(ctx, SA_OPCODE_SPACE_CREATE);
-}
-
-bool mss_space_destroy(mss_context *ctx, uint64_t sid)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(sid);
-    return sa_payload_send(ctx, SA_OPCODE_SPACE_DESTROY);
-}
-
-bool mss_space_focus(mss_context *ctx, uint64_t sid)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(sid);
-    return sa_payload_send(ctx, SA_OPCODE_SPACE_FOCUS);
-}
-
-bool mss_space_move(mss_context *ctx, uint64_t src_sid,
-                          uint64_t dst_sid, uint64_t src_prev_sid, bool focus)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(src_sid);
-    pack(dst_sid);
-    pack(src_prev_sid);
-    pack(focus);
-    return sa_payload_send(ctx, SA_OPCODE_SPACE_MOVE);
-}
-
-// ============================================================================
-// Window Operations
-// ============================================================================
-
-bool mss_window_move(mss_context *ctx, uint32_t wid, int x, int y)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    pack(x);
-    pack(y);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_MOVE);
-}
-
-bool mss_window_set_opacity(mss_context *ctx, uint32_t wid, float opacity)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    pack(opacity);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_OPACITY);
-}
-
-bool mss_window_fade_opacity(mss_context *ctx, uint32_t wid,
-                                   float opacity, float duration)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    pack(opacity);
-    pack(duration);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_OPACITY_FADE);
-}
-
-bool mss_window_set_layer(mss_context *ctx, uint32_t wid,
-                                enum mss_window_layer layer)
-{
-    if (!ctx) return false;
-    int layer_value = (int)layer;
-    sa_payload_init();
-    pack(wid);
-    pack(layer_value);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_LAYER);
-}
-
-bool mss_window_set_sticky(mss_context *ctx, uint32_t wid, bool sticky)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    pack(sticky);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_STICKY);
-}
-
-bool mss_window_set_shadow(mss_context *ctx, uint32_t wid, bool shadow)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    pack(shadow);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SHADOW);
-}
-
-bool mss_window_focus(mss_context *ctx, uint32_t wid)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_FOCUS);
-}
-
-bool mss_window_scale(mss_context *ctx, uint32_t wid,
-                            float x, float y, float w, float h)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    pack(x);
-    pack(y);
-    pack(w);
-    pack(h);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SCALE);
-}
-
-bool mss_window_order(mss_context *ctx, uint32_t wid,
-                            enum mss_window_order order, uint32_t relative_wid)
-{
-    if (!ctx) return false;
-    int order_value = (int)order;
-    sa_payload_init();
-    pack(wid);
-    pack(order_value);
-    pack(relative_wid);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_ORDER);
-}
-
-bool mss_window_order_in(mss_context *ctx, uint32_t *window_list, int count)
-{
-    if (!ctx || !window_list) return false;
-
-    uint32_t dummy_wid = 0;
-    uint8_t ordered_in = 0;
-
-    sa_payload_init();
-    pack(count);
-    for (int i = 0; i < count; ++i) {
-        SLSWindowIsOrderedIn(ctx->connection_id, window_list[i], &ordered_in);
-        if (ordered_in) {
-            pack(dummy_wid);
-        } else {
-            pack(window_list[i]);
-        }
-    }
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_ORDER_IN);
-}
-
-bool mss_window_move_to_space(mss_context *ctx, uint32_t wid, uint64_t sid)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(sid);
-    pack(wid);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_TO_SPACE);
-}
-
-bool mss_window_list_move_to_space(mss_context *ctx, uint32_t *window_list,
-                                         int count, uint64_t sid)
-{
-    if (!ctx || !window_list) return false;
-    sa_payload_init();
-    pack(sid);
-    pack(count);
-    for (int i = 0; i < count; ++i) {
-        pack(window_list[i]);
-    }
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_LIST_TO_SPACE);
-}
-
-bool mss_window_resize(mss_context *ctx, uint32_t wid, int width, int height)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    pack(width);
-    pack(height);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_RESIZE);
-}
-
-bool mss_window_set_frame(mss_context *ctx, uint32_t wid,
-                                 int x, int y, int width, int height)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    pack(x);
-    pack(y);
-    pack(width);
-    pack(height);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SET_FRAME);
-}
-
-bool mss_window_minimize(mss_context *ctx, uint32_t wid)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_MINIMIZE);
-}
-
-bool mss_window_unminimize(mss_context *ctx, uint32_t wid)
-{
-    if (!ctx) return false;
-    sa_payload_init();
-    pack(wid);
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_UNMINIMIZE);
-}
-
-bool mss_window_is_minimized(mss_context *ctx, uint32_t wid, bool *result)
-{
-    if (!ctx || !result) return false;
-
-    sa_query_init();
-    query_pack(wid);
-
-    if (!sa_query_send(ctx, SA_OPCODE_WINDOW_IS_MINIMIZED)) {
-        return false;
-    }
-
-    // Unpack response
-    int unpack_offset = 0;
-    uint8_t minimized_byte;
-    unpack_response(minimized_byte);
-    *result = (minimized_byte != 0);
-
-    return true;
-}
-
-bool mss_window_get_opacity(mss_context *ctx, uint32_t wid, float *opacity)
-{
-    if (!ctx || !opacity) return false;
-
-    sa_query_init();
-    query_pack(wid);
-
-    if (!sa_query_send(ctx, SA_OPCODE_WINDOW_GET_OPACITY)) {
-        return false;
-    }
-
-    // Unpack response
-    int unpack_offset = 0;
-    unpack_response(*opacity);
-
-    return true;
-}
-
-bool mss_window_get_frame(mss_context *ctx, uint32_t wid,
-                                 int *x, int *y, int *width, int *height)
-{
-    if (!ctx || !x || !y || !width || !height) return false;
-
-    sa_query_init();
-    query_pack(wid);
-
-    if (!sa_query_send(ctx, SA_OPCODE_WINDOW_GET_FRAME)) {
-        return false;
-    }
-
-    // Unpack response (x, y, width, height)
-    int unpack_offset = 0;
-    unpack_response(*x);
-    unpack_response(*y);
-    unpack_response(*width);
-    unpack_response(*height);
-
-    return true;
-}
-
-bool mss_window_is_sticky(mss_context *ctx, uint32_t wid, bool *sticky)
-{
-    if (!ctx || !sticky) return false;
-
-    sa_query_init();
-    query_pack(wid);
-
-    if (!sa_query_send(ctx, SA_OPCODE_WINDOW_IS_STICKY)) {
-        return false;
-    }
-
-    // Unpack response
-    int unpack_offset = 0;
-    uint8_t sticky_byte;
-    unpack_response(sticky_byte);
-    *sticky = (sticky_byte != 0);
-
-    return true;
-}
-
-bool mss_window_get_layer(mss_context *ctx, uint32_t wid,
-                                 enum mss_window_layer *layer)
-{
-    if (!ctx || !layer) return false;
-
-    sa_query_init();
-    query_pack(wid);
-
-    if (!sa_query_send(ctx, SA_OPCODE_WINDOW_GET_LAYER)) {
-        return false;
-    }
-
-    // Unpack response
-    int unpack_offset = 0;
-    int layer_val;
-    unpack_response(layer_val);
-    *layer = (enum mss_window_layer)layer_val;
-
-    return true;
-}
-
-int mss_display_get_count(mss_context *ctx, uint32_t *count)
-{
-    if (!ctx || !count) return MSS_ERROR_INVALID_ARG;
-
-    sa_query_init();
-
-    if (!sa_query_send(ctx, SA_OPCODE_DISPLAY_GET_COUNT)) {
-        return MSS_ERROR_CONNECTION;
-    }
-
-    // Unpack response
-    int unpack_offset = 0;
-    unpack_response(*count);
-
-    return MSS_SUCCESS;
-}
-
-int mss_display_get_list(mss_context *ctx, uint32_t *displays, size_t max_count)
-{
-    if (!ctx || !displays) return MSS_ERROR_INVALID_ARG;
-
-    sa_query_init();
-    query_pack((uint32_t)max_count);
-
-    if (!sa_query_send(ctx, SA_OPCODE_DISPLAY_GET_LIST)) {
-        return MSS_ERROR_CONNECTION;
-    }
-
-    // Unpack response: count followed by display IDs
-    int unpack_offset = 0;
-    uint32_t count;
-    unpack_response(count);
-
-    // Copy display IDs
-    for (size_t i = 0; i < count && i < max_count; i++) {
-        unpack_response(displays[i]);
-    }
-
-    return MSS_SUCCESS;
-}
-
-// ============================================================================
-// Window Animation
-// ============================================================================
-
-bool mss_window_swap_proxy_in(mss_context *ctx,
-                                    struct mss_window_animation *animations,
-                                    int count)
-{
-    if (!ctx || !animations) return false;
-
-    sa_payload_init();
-    pack(count);
-    for (int i = 0; i < count; ++i) {
-        pack(animations[i].wid);
-        pack(animations[i].proxy_wid);
-    }
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SWAP_PROXY_IN);
-}
-
-bool mss_window_swap_proxy_out(mss_context *ctx,
-                                     struct mss_window_animation *animations,
-                                     int count)
-{
-    if (!ctx || !animations) return false;
-
-    sa_payload_init();
-    pack(count);
-    for (int i = 0; i < count; ++i) {
-        pack(animations[i].wid);
-        pack(animations[i].proxy_wid);
-    }
-    return sa_payload_send(ctx, SA_OPCODE_WINDOW_SWAP_PROXY_OUT);
-}
-
-#undef sa_payload_init
-#undef pack
-#undef sa_payload_send
@@ -19,6 +19,20 @@
                                      OSAX_ATTRIB_SET_WINDOW | \
                                      OSAX_ATTRIB_ANIM_TIME)
 
+// Socket the payload listens on, per user
+#define SA_SOCKET_PATH_FMT          "/tmp/mss_%s.socket"
+
+// Largest framed message (length prefix included, request id not) the
+// payload will accept
+#define SA_MESSAGE_MAX              0x8000
+
+// Most window ids one SA_OPCODE_WINDOW_SNAPSHOT request may carry
+#define SA_SNAPSHOT_MAX             4096
+
+// Version of the request and response framing; payloads that predate it
+// reply unframed
+#define SA_PROTOCOL_VERSION         3
+
 enum sa_opcode
 {
     SA_OPCODE_HANDSHAKE             = 0x01,
@@ -55,6 +69,124 @@ enum sa_opcode
     // Display queries
     SA_OPCODE_DISPLAY_GET_COUNT     = 0x1D,
     SA_OPCODE_DISPLAY_GET_LIST      = 0x1E,
+    // Connection control
+    SA_OPCODE_SESSION               = 0x1F,
+    SA_OPCODE_BATCH                 = 0x20,
+    SA_OPCODE_WINDOW_TRANSACTION    = 0x21,
+    SA_OPCODE_WINDOW_SNAPSHOT       = 0x22,
+    SA_OPCODE_STATS                 = 0x23,
+    SA_OPCODE_DISPLAY_GET_SPACE     = 0x24,
+    SA_OPCODE_SUBSCRIBE             = 0x25,
+    SA_OPCODE_WINDOW_GENERATION     = 0x26,
+};
+
+enum sa_status
+{
+    SA_STATUS_OK                    = 0x00,
+    SA_STATUS_BAD_REQUEST           = 0x01,   // Truncated or malformed arguments
+    SA_STATUS_UNKNOWN_OPCODE        = 0x02,
+};
+
+//
+// NOTE: A request on the wire is a uint16_t request id chosen by the client,
+// then the message: its int16_t length, the opcode and the arguments.
+//
+// Every request is answered with exactly one response, on session and
+// one-shot connections alike: this header, then length bytes of payload.
+// Mutations reply with an empty payload once they have been applied. id
+// echoes the request id, so a client can keep many requests in flight on a
+// session and match responses as they arrive. The version byte comes first
+// so that a client can tell an older, unframed payload apart before trusting
+// the rest of the header.
+//
+
+struct sa_response_header
+{
+    uint8_t version;
+    uint8_t status;
+    uint16_t id;
+    uint32_t length;
+};
+
+//
+// NOTE: A snapshot request is a count followed by that many window ids. The
+// response payload is a uint32_t record count and one record per requested
+// id, in order. A record whose wid is 0 names a window that does not exist.
+//
+
+struct sa_window_record
+{
+    uint32_t wid;
+    int32_t x, y;
+    int32_t width, height;
+    float alpha;
+    int32_t level;
+    uint32_t ordered_in;
+    uint64_t tags;
 };
 
+//
+// NOTE: The stats response is an sa_stats record describing how the payload
+// has been executing requests. Fields are only ever appended; a client reads
+// as much of the record as it knows and the payload sends all of it.
+//
+
+// Most execution lanes the payload runs
+#define SA_LANE_MAX                 8
+
+struct sa_lane_stats
+{
+    uint64_t executed;              // Requests run on the lane
+    uint64_t contended;             // Times the lane lock was already held
+    uint32_t depth;                 // Requests queued or running right now
+    uint32_t max_depth;             // Most requests ever queued at once
+};
+
+struct sa_stats
+{
+    uint32_t lane_count;
+    uint32_t reserved;
+    uint64_t barriers;              // Requests run across every lane
+    uint64_t barrier_waits;         // Times a lane stalled on a barrier
+    struct sa_lane_stats lanes[SA_LANE_MAX];
+    uint64_t coalesced_moves;       // Queued moves replaced by a newer one
+    uint64_t coalesced_frames;      // Queued set_frames replaced by a newer one
+    uint64_t event_reports;         // Changes reported while anyone was subscribed
+    uint64_t events_sent;           // Events sent to subscribers after merging
+    uint64_t cache_hits;            // Window queries answered from the attribute cache
+    uint64_t cache_misses;          // Window queries read from SkyLight
+};
+
+//
+// NOTE: A subscribe request is a uint32_t mask of SA_EVENT_* bits, then a
+// count followed by that many window ids whose window events are wanted. It
+// must be the first request on its connection. Once acknowledged, the
+// connection carries only events: responses that echo the subscribe
+// request's id, each with a payload of sa_event records. Reports are merged
+// per window and per display and sent at most once per frame, so one event
+// may stand for many changes; readers query what they need afterwards.
+//
+
+#define SA_EVENT_WINDOW_MOVED       0x01
+#define SA_EVENT_WINDOW_RESIZED     0x02
+#define SA_EVENT_WINDOW_ORDERED     0x04    // Ordered in or out, minimized, closed
+#define SA_EVENT_WINDOW_ALPHA       0x08
+#define SA_EVENT_SPACE_CHANGED      0x10    // A display shows another space
+#define SA_EVENT_DISPLAY_CHANGED    0x20    // Displays or their spaces were rearranged
+#define SA_EVENT_WINDOW_ALL         0x0F
+#define SA_EVENT_ALL                0x3F
+
+struct sa_event
+{
+    uint32_t events;                // SA_EVENT_* bits that changed
+    uint32_t id;                    // Window id, or display id for display events
+    uint64_t sid;                   // SA_EVENT_SPACE_CHANGED: the display's space now
+};
+
+// Most events in one response; a frame with more is sent as several
+#define SA_EVENT_BATCH_MAX          4096
+
+// Largest response payload the payload sends (a full snapshot)
+#define SA_RESPONSE_MAX             (sizeof(uint32_t) + SA_SNAPSHOT_MAX * sizeof(struct sa_window_record))
+
 #endif
@@ -0,0 +1,2478 @@
+//
+// Portable half of the payload: socket listener, worker pool, message
+// framing, dispatch, batches, window transactions and the fade animation
+// thread.
+//
+// Nothing here talks to SkyLight directly; every compositor operation goes
+// through the struct backend installed by daemon_start(). payload.m includes
+// this file with the SkyLight backend, and the Linux tools include it with
+// the fake backend from src/fake_backend.c.
+//
+// OSAX_VERSION must be defined by the build.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <errno.h>
+
+#include "common.h"
+#include "util.h"
+#include "backend.h"
+#include "state.h"
+
+#define WID_TABLE_IMPLEMENTATION
+#include "wid_table.h"
+#undef WID_TABLE_IMPLEMENTATION
+
+#define unpack(v) memcpy(&v, message, sizeof(v)); message += sizeof(v)
+#define lerp(a, t, b) (((1.0-t)*a) + (t*b))
+
+struct window_fade_context
+{
+    uint32_t wid;
+    int index;
+    float alpha;
+    float start_alpha;
+    float end_alpha;
+    float duration;
+    double start_time;
+};
+
+pthread_mutex_t window_fade_lock;
+pthread_cond_t window_fade_cond;
+struct wid_table window_fade_table;
+
+static pthread_t window_fade_thread;
+static struct window_fade_context **window_fade_list;
+static int window_fade_count;
+static int window_fade_capacity;
+
+struct client_connection
+{
+    int sockfd;
+    bool session;
+    bool responded;
+    uint16_t request_id;
+    pthread_mutex_t *send_lock;     // Set when several threads write to sockfd
+    struct event_subscriber *subscriber; // Set by SA_OPCODE_SUBSCRIBE, which takes over sockfd
+};
+
+//
+// NOTE: Requests are executed by worker threads, separate from the threads
+// that accept connections and read requests. Each worker drains one lane, a
+// serial queue. A request that targets one window goes to the lane its wid
+// hashes to, and a space operation to the lane of its sid, so operations on
+// the same window run in the order they were read while different windows
+// run on different cores. Requests that touch several windows or spaces
+// (batches, transactions, list operations, snapshots) are barriers: they are
+// queued on every lane and run once every lane has reached them, so they see
+// everything read before them and everything read after them sees them.
+// Requests with no target go to lane 0.
+//
+
+struct daemon_job
+{
+    struct daemon_job *next;
+    struct daemon_job *barrier;     // Set on a barrier's placeholders
+    struct client_session *session; // NULL for a one-shot connection
+    struct client_connection conn;
+    uint32_t wid;                   // Target of a single-window request
+    bool coalesced;                 // Superseded; only acknowledged
+    int waiting;                    // Barrier: lanes yet to reach it
+    int references;                 // Barrier: lanes yet to move past it
+    bool done;
+    int length;
+    char message[];
+};
+
+//
+// NOTE: A window that is being dragged receives far more moves than SkyLight
+// needs to apply. Each lane remembers, per wid, the last request it has
+// queued for that window while it is a move or set_frame. When another one
+// of the same kind arrives before the first has started, its arguments are
+// written over the queued request, which then applies the newest value, and
+// the new request is only acknowledged once its turn comes. Any other
+// request for the window, or a barrier, ends the run, so nothing ever sees
+// a value out of order.
+//
+
+struct lane_pending
+{
+    struct daemon_job *job;
+    uint64_t epoch;
+};
+
+struct daemon_lane
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    struct daemon_job *head;
+    struct daemon_job *tail;
+    struct wid_table pending;
+    uint64_t epoch;                 // Barriers queued so far
+    uint32_t depth;
+    uint32_t max_depth;
+    uint64_t executed;
+    uint64_t contended;
+    uint64_t coalesced_moves;
+    uint64_t coalesced_frames;
+};
+
+struct client_session
+{
+    struct client_connection conn;
+    pthread_mutex_t send_lock;
+    pthread_mutex_t lock;
+    pthread_cond_t drained;
+    int pending;
+};
+
+#define SESSION_BACKLOG_MAX 1024
+
+static const struct backend *backend;
+static pthread_t daemon_thread;
+static int daemon_sockfd;
+
+static struct daemon_lane lanes[SA_LANE_MAX];
+static int lane_count;
+
+static pthread_mutex_t barrier_lock;
+static pthread_cond_t barrier_cond;
+static uint64_t barrier_count;
+static uint64_t barrier_waits;
+
+//
+// NOTE: SkyLight calls are safe to make from any thread, so window operations
+// run on whichever worker picked them up. Space operations and focus call
+// into Dock itself, reading and writing its space objects and hopping onto
+// its main thread; they are serialised on dock_lock so that only they queue
+// behind one another.
+//
+
+static pthread_mutex_t dock_lock;
+
+//
+// NOTE: Handlers record what they learn about windows and displays in the
+// shared state page (state.h) before the request is answered: the values a
+// mutation set, the values a query read, and fields a mutation changed in a
+// way the payload cannot know are dropped. A client that has seen the
+// response therefore never reads an older value from the page.
+//
+
+static struct sa_state *state_page;
+
+// Advanced whenever a handler sets a window attribute or the backend reports
+// a change to one; clients compare it to validate what they cached. Changes
+// the backend does not report (alpha, level and tags set by others) leave it
+// alone. Windows are only watched once they have a state page entry, so
+// without a page it is reported as 0, which tells clients it cannot be
+// relied on.
+static uint64_t window_generation = 1;
+
+static void state_write_begin(uint32_t *sequence)
+{
+    for (;;) {
+        uint32_t current = __atomic_load_n(sequence, __ATOMIC_RELAXED);
+        if (!(current & 1) && __atomic_compare_exchange_n(sequence, &current, current + 1, false,
+                                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+static void state_write_end(uint32_t *sequence)
+{
+    __atomic_fetch_add(sequence, 1, __ATOMIC_RELEASE);
+}
+
+// Claims and releases of window slots; lookups take no lock
+static pthread_mutex_t state_claim_lock;
+
+// Returns wid's slot, claiming the first free slot or tombstone within reach
+// of its home if it has none, or NULL if there is none to claim
+static struct sa_state_window *state_window_claim(uint32_t wid)
+{
+    struct sa_state_window *entry = sa_state_window_find(state_page, wid);
+    if (entry) return entry;
+
+    pthread_mutex_lock(&state_claim_lock);
+    entry = sa_state_window_find(state_page, wid);
+
+    uint32_t home = sa_state_home(wid);
+    for (uint32_t i = 0; !entry && i < SA_STATE_PROBE_MAX; ++i) {
+        struct sa_state_window *slot = &state_page->windows[(home + i) & (SA_STATE_WINDOW_MAX - 1)];
+        if (slot->wid != 0 && slot->wid != SA_STATE_TOMBSTONE) continue;
+
+        state_write_begin(&slot->sequence);
+        slot->fields = 0;
+        slot->flags = 0;
+        __atomic_store_n(&slot->wid, wid, __ATOMIC_RELEASE);
+        state_write_end(&slot->sequence);
+        entry = slot;
+    }
+
+    pthread_mutex_unlock(&state_claim_lock);
+    return entry;
+}
+
+// Gives back the slot of a window that closed
+static void state_window_release(uint32_t wid)
+{
+    if (!state_page) return;
+
+    pthread_mutex_lock(&state_claim_lock);
+    struct sa_state_window *entry = sa_state_window_find(state_page, wid);
+    if (entry) {
+        state_write_begin(&entry->sequence);
+        entry->fields = 0;
+        entry->flags = 0;
+        __atomic_store_n(&entry->wid, SA_STATE_TOMBSTONE, __ATOMIC_RELEASE);
+        state_write_end(&entry->sequence);
+
+        // No lookup probes past a free slot, so the tombstones running up to one can be freed too
+        uint32_t index = (uint32_t)(entry - state_page->windows);
+        if (state_page->windows[(index + 1) & (SA_STATE_WINDOW_MAX - 1)].wid == 0) {
+            while (state_page->windows[index].wid == SA_STATE_TOMBSTONE) {
+                __atomic_store_n(&state_page->windows[index].wid, 0, __ATOMIC_RELEASE);
+                index = (index - 1) & (SA_STATE_WINDOW_MAX - 1);
+            }
+        }
+    }
+    pthread_mutex_unlock(&state_claim_lock);
+}
+
+// Writes the parts of values selected by fields; the caller holds the
+// entry's sequence odd
+static void state_window_write(struct sa_state_window *entry, uint32_t wid, uint32_t fields, const struct sa_window_record *values)
+{
+    struct sa_window_record *record = &entry->record;
+    record->wid = wid;
+    if (fields & SA_STATE_ORIGIN) {
+        record->x = values->x;
+        record->y = values->y;
+    }
+    if (fields & SA_STATE_SIZE) {
+        record->width = values->width;
+        record->height = values->height;
+    }
+    if (fields & SA_STATE_ALPHA) record->alpha = values->alpha;
+    if (fields & SA_STATE_LEVEL) record->level = values->level;
+    if (fields & SA_STATE_TAGS) record->tags = values->tags;
+    if (fields & SA_STATE_ORDERED) record->ordered_in = values->ordered_in;
+    entry->fields |= fields;
+
+    uint64_t now = sa_state_now();
+    for (int i = 0; i < SA_STATE_FIELD_COUNT; ++i) {
+        if (fields & (1u << i)) entry->updated[i] = now;
+    }
+}
+
+// Records the parts of values selected by fields, if wid has an entry
+static void state_window_publish(uint32_t wid, uint32_t fields, const struct sa_window_record *values)
+{
+    __atomic_fetch_add(&window_generation, 1, __ATOMIC_RELEASE);
+    if (!state_page || !wid) return;
+
+    struct sa_state_window *entry = sa_state_window_find(state_page, wid);
+    if (!entry) return;
+
+    // The slot may have been released and claimed by another window meanwhile
+    state_write_begin(&entry->sequence);
+    if (entry->wid == wid) state_window_write(entry, wid, fields, values);
+    state_write_end(&entry->sequence);
+}
+
+// Like state_window_publish, but only if the entry's sequence is still the
+// even sequence read before values were; a value read from the backend then
+// never overwrites one published or forgotten while it was being read
+static void state_window_fill(uint32_t wid, uint32_t sequence, uint32_t fields, const struct sa_window_record *values)
+{
+    if (!state_page || !wid || (sequence & 1)) return;
+
+    struct sa_state_window *entry = sa_state_window_find(state_page, wid);
+    if (!entry) return;
+
+    if (!__atomic_compare_exchange_n(&entry->sequence, &sequence, sequence + 1, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+    if (entry->wid == wid) state_window_write(entry, wid, fields, values);
+    state_write_end(&entry->sequence);
+}
+
+// Sets and clears tag bits of a window whose tags are known. The field
+// counts as learned now, since the bits clients ask about after a sticky or
+// shadow change are the ones just written.
+static void state_window_tags(uint32_t wid, uint64_t set, uint64_t clear)
+{
+    __atomic_fetch_add(&window_generation, 1, __ATOMIC_RELEASE);
+    if (!state_page || !wid) return;
+
+    struct sa_state_window *entry = sa_state_window_find(state_page, wid);
+    if (!entry) return;
+
+    state_write_begin(&entry->sequence);
+    if (entry->wid == wid && (entry->fields & SA_STATE_TAGS)) {
+        struct sa_window_record values = { .tags = (entry->record.tags & ~clear) | set };
+        state_window_write(entry, wid, SA_STATE_TAGS, &values);
+    }
+    state_write_end(&entry->sequence);
+}
+
+static void state_window_forget(uint32_t wid, uint32_t fields)
+{
+    __atomic_fetch_add(&window_generation, 1, __ATOMIC_RELEASE);
+    if (!state_page || !wid) return;
+
+    struct sa_state_window *entry = sa_state_window_find(state_page, wid);
+    if (!entry) return;
+
+    state_write_begin(&entry->sequence);
+    if (entry->wid == wid) entry->fields &= ~fields;
+    state_write_end(&entry->sequence);
+}
+
+static void state_displays_publish(void)
+{
+    if (!state_page) return;
+
+    uint32_t ids[SA_STATE_DISPLAY_MAX];
+    uint64_t spaces[SA_STATE_DISPLAY_MAX];
+    uint32_t count = backend->display_list(ids, SA_STATE_DISPLAY_MAX);
+    if (count > SA_STATE_DISPLAY_MAX) count = SA_STATE_DISPLAY_MAX;
+    for (uint32_t i = 0; i < count; ++i) {
+        spaces[i] = backend->display_space(ids[i]);
+    }
+
+    struct sa_state_displays *displays = &state_page->displays;
+    state_write_begin(&displays->sequence);
+    displays->count = count;
+    memcpy(displays->ids, ids, sizeof(uint32_t) * count);
+    memcpy(displays->spaces, spaces, sizeof(uint64_t) * count);
+    displays->updated = sa_state_now();
+    state_write_end(&displays->sequence);
+}
+
+//
+// NOTE: The state page doubles as the payload's own window attribute cache.
+// A query is answered from the window's entry when it holds the fields asked
+// for, and read from the backend and recorded otherwise. Windows are watched
+// from their first query on, and the backend's change reports drop their
+// frame and ordering fields (event_notify) whether or not anyone is
+// subscribed, so those are served however old they are. Alpha, level and
+// tags changes made behind the payload's back are not reported; those fields
+// are only served for CACHE_UNREPORTED_AGE after they were learned.
+// Mutations through the payload update every field in place either way.
+//
+// A miss notes the entry's sequence before reading the backend and records
+// what it read only if the entry is unchanged since (state_window_fill), so
+// a change reported during the read is not covered up by the older value.
+//
+// A window only gets an entry once the backend has confirmed it exists
+// (cache_admit), after its first query has been answered; otherwise any
+// client could fill the page by querying made-up ids. It is watched before
+// the entry is claimed, so nothing recorded in the entry predates the watch.
+// Mutations update the entries of windows that have one and claim none.
+//
+
+#define CACHE_REPORTED          (SA_STATE_FRAME | SA_STATE_ORDERED)
+#define CACHE_UNREPORTED_AGE    250000000ull    // ns
+#define CACHE_UNKNOWN           1               // *sequence for a window without an entry; odd, so never filled
+
+static uint64_t cache_hits;
+static uint64_t cache_misses;
+
+// Copies wid's record into record if it holds fields. On a miss, sets
+// *sequence for state_window_fill, or to CACHE_UNKNOWN if wid has no entry
+// and needs cache_admit, and returns false.
+static bool cache_lookup(uint32_t wid, uint32_t fields, struct sa_window_record *record, uint32_t *sequence)
+{
+    *sequence = CACHE_UNKNOWN;
+    if (!state_page || !wid) return false;
+
+    struct sa_state_window *entry = sa_state_window_find(state_page, wid);
+    struct sa_state_window copy;
+    bool hit = false;
+
+    if (entry && sa_state_read(&entry->sequence, entry, &copy, sizeof(copy)) && copy.wid == wid) {
+        if ((copy.fields & fields) == fields) {
+            uint32_t unreported = fields & ~CACHE_REPORTED;
+            hit = !unreported || sa_state_now() - sa_state_window_learned(&copy, unreported) <= CACHE_UNREPORTED_AGE;
+        }
+        *sequence = copy.sequence;
+    }
+
+    if (hit) {
+        *record = copy.record;
+        __atomic_fetch_add(&cache_hits, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&cache_misses, 1, __ATOMIC_RELAXED);
+    }
+    return hit;
+}
+
+// Watches wid and gives it an entry, empty until its next miss fills it.
+// Unless exists is set, the backend is asked first whether wid is a window.
+static void cache_admit(uint32_t wid, bool exists)
+{
+    if (!state_page || !wid) return;
+
+    if (!exists) {
+        struct sa_window_record record = {};
+        backend->window_snapshot(&wid, 1, &record);
+        if (!record.wid) return;
+    }
+
+    // Changes before the watch went unseen, and a client may have cached an
+    // answer given before it
+    backend->watch_windows(&wid, 1);
+    __atomic_fetch_add(&window_generation, 1, __ATOMIC_RELEASE);
+
+    struct sa_state_window *entry = state_window_claim(wid);
+    if (!entry) return;
+
+    state_write_begin(&entry->sequence);
+    if (entry->wid == wid) entry->flags |= SA_STATE_WATCHED;
+    state_write_end(&entry->sequence);
+}
+
+// Drops the fields of wid that a change report makes stale
+static void cache_invalidate(uint32_t events, uint32_t wid)
+{
+    uint32_t fields = 0;
+    if (events & SA_EVENT_WINDOW_MOVED) fields |= SA_STATE_ORIGIN;
+    if (events & SA_EVENT_WINDOW_RESIZED) fields |= SA_STATE_SIZE;
+    if (events & SA_EVENT_WINDOW_ORDERED) fields |= SA_STATE_ORDERED;
+    if (fields) state_window_forget(wid, fields);
+}
+
+static void state_open(const char *socket_path)
+{
+    char path[256];
+    snprintf(path, sizeof(path), SA_STATE_PATH_FMT, socket_path);
+    unlink(path);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) return;
+
+    if (ftruncate(fd, sizeof(struct sa_state)) == 0) {
+        void *page = mmap(NULL, sizeof(struct sa_state), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (page != MAP_FAILED) {
+            state_page = page;
+            state_page->version = SA_STATE_VERSION;
+            state_page->window_capacity = SA_STATE_WINDOW_MAX;
+            __atomic_store_n(&state_page->magic, SA_STATE_MAGIC, __ATOMIC_RELEASE);
+        }
+    }
+
+    close(fd);
+}
+
+//
+// NOTE: Change reports from the backend, and alpha changes the handlers make,
+// are merged into a pending set keyed by window and by display, and a flush
+// thread sends them to subscribers at most once per frame. However many
+// reports a window gets within a frame, each subscriber receives one event
+// for it, carrying every kind of change seen. Nothing is recorded while
+// nobody is subscribed. Sends happen outside event_subscriber_lock, so a
+// subscriber stalling for up to EVENT_SEND_TIMEOUT holds up that flush but
+// never a client subscribing meanwhile.
+//
+
+#define EVENT_FRAME_NS          16666667ull
+#define EVENT_SEND_TIMEOUT      1       // Seconds a subscriber may stall a flush before it is dropped
+
+struct event_subscriber
+{
+    struct event_subscriber *next;
+    struct client_connection conn;
+    uint32_t events;                // SA_EVENT_* bits wanted
+    struct wid_table windows;       // Windows whose events are wanted; no values
+    bool gone;                      // A send failed; unlinked after the flush
+};
+
+static pthread_mutex_t event_lock;
+static pthread_cond_t event_cond;
+static pthread_t event_thread;
+static bool event_active;                           // Anyone subscribed
+static struct wid_table event_windows;              // wid -> pending SA_EVENT_* bits
+static struct sa_event event_displays[SA_STATE_DISPLAY_MAX];
+static int event_display_count;
+static uint64_t event_reports;
+static uint64_t event_sent;
+
+static pthread_mutex_t event_subscriber_lock;
+static struct event_subscriber *event_subscribers;
+
+static void event_notify(uint32_t events, uint32_t id, uint64_t sid)
+{
+    if (!id) return;
+
+    bool closed = events & BACKEND_WINDOW_CLOSED;
+    events &= ~BACKEND_WINDOW_CLOSED;
+    if (events & SA_EVENT_WINDOW_ALL) cache_invalidate(events, id);
+    if (closed) state_window_release(id);
+    if (!__atomic_load_n(&event_active, __ATOMIC_RELAXED)) return;
+
+    pthread_mutex_lock(&event_lock);
+    ++event_reports;
+
+    if (events & SA_EVENT_WINDOW_ALL) {
+        uint32_t *pending = wid_table_add(&event_windows, id, &(uint32_t) { 0 });
+        *pending |= events & SA_EVENT_WINDOW_ALL;
+    }
+
+    if (events & ~SA_EVENT_WINDOW_ALL) {
+        int i = 0;
+        while (i < event_display_count && event_displays[i].id != id) ++i;
+        if (i < SA_STATE_DISPLAY_MAX) {
+            if (i == event_display_count) event_displays[event_display_count++] = (struct sa_event) { .id = id };
+            event_displays[i].events |= events & ~SA_EVENT_WINDOW_ALL;
+            if (events & SA_EVENT_SPACE_CHANGED) event_displays[i].sid = sid;
+        }
+    }
+
+    pthread_cond_signal(&event_cond);
+    pthread_mutex_unlock(&event_lock);
+}
+
+static void do_space_move(char *message)
+{
+    uint64_t source_space_id, dest_space_id, source_prev_space_id;
+    unpack(source_space_id);
+    unpack(dest_space_id);
+    unpack(source_prev_space_id);
+
+    bool focus_dest_space;
+    unpack(focus_dest_space);
+
+    pthread_mutex_lock(&dock_lock);
+    backend->space_move(source_space_id, dest_space_id, source_prev_space_id, focus_dest_space);
+    pthread_mutex_unlock(&dock_lock);
+
+    state_displays_publish();
+}
+
+static void do_space_destroy(char *message)
+{
+    uint64_t space_id;
+    unpack(space_id);
+
+    pthread_mutex_lock(&dock_lock);
+    backend->space_destroy(space_id);
+    pthread_mutex_unlock(&dock_lock);
+
+    state_displays_publish();
+}
+
+static void do_space_create(char *message)
+{
+    uint64_t space_id;
+    unpack(space_id);
+
+    pthread_mutex_lock(&dock_lock);
+    backend->space_create(space_id);
+    pthread_mutex_unlock(&dock_lock);
+
+    state_displays_publish();
+}
+
+static void do_space_focus(char *message)
+{
+    uint64_t dest_space_id;
+    unpack(dest_space_id);
+
+    if (dest_space_id) {
+        pthread_mutex_lock(&dock_lock);
+        backend->space_focus(dest_space_id);
+        pthread_mutex_unlock(&dock_lock);
+
+        state_displays_publish();
+    }
+}
+
+static void do_window_scale(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    float dx, dy, dw, dh;
+    unpack(dx);
+    unpack(dy);
+    unpack(dw);
+    unpack(dh);
+
+    backend->window_scale(wid, dx, dy, dw, dh);
+    state_window_forget(wid, SA_STATE_FRAME);
+}
+
+static void do_window_move(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    int x, y;
+    unpack(x);
+    unpack(y);
+
+    backend->window_move(wid, x, y);
+    backend->window_reassociate(&wid, 1);
+    state_window_publish(wid, SA_STATE_ORIGIN, &(struct sa_window_record) { .x = x, .y = y });
+}
+
+//
+// NOTE: All fades are driven by a single animation thread. Active fades live
+// in window_fade_list (for iteration) and window_fade_table (for lookup by
+// wid), both guarded by window_fade_lock. Every frame the thread steps each
+// fade from elapsed time and commits all resulting alpha values in one
+// backend transaction. The thread sleeps on window_fade_cond while idle.
+//
+
+static inline double window_fade_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Must be called with window_fade_lock held
+static bool window_fade_retarget(uint32_t wid, float alpha, float duration)
+{
+    struct window_fade_context **entry = wid_table_find(&window_fade_table, wid);
+    if (!entry) return false;
+
+    struct window_fade_context *context = *entry;
+    context->start_alpha = context->alpha;
+    context->end_alpha = alpha;
+    context->duration = duration;
+    context->start_time = window_fade_now();
+    return true;
+}
+
+// Must be called with window_fade_lock held
+static void window_fade_remove(struct window_fade_context *context)
+{
+    struct window_fade_context *last = window_fade_list[--window_fade_count];
+    window_fade_list[context->index] = last;
+    last->index = context->index;
+
+    wid_table_remove(&window_fade_table, context->wid);
+    free(context);
+}
+
+static void *window_fade_thread_proc(void *unused)
+{
+    (void) unused;
+    int frame_duration = 8;
+
+    pthread_mutex_lock(&window_fade_lock);
+    for (;;) {
+        while (window_fade_count == 0) {
+            pthread_cond_wait(&window_fade_cond, &window_fade_lock);
+        }
+
+        double frame_start = window_fade_now();
+        void *transaction = backend->transaction_create();
+
+        for (int i = 0; i < window_fade_count;) {
+            struct window_fade_context *context = window_fade_list[i];
+
+            float t = context->duration > 0.0f ? (frame_start - context->start_time) / context->duration : 1.0f;
+            if (t < 0.0f) t = 0.0f;
+            if (t > 1.0f) t = 1.0f;
+
+            context->alpha = lerp(context->start_alpha, t, context->end_alpha);
+            backend->transaction_set_alpha(transaction, context->wid, context->alpha);
+            state_window_publish(context->wid, SA_STATE_ALPHA, &(struct sa_window_record) { .alpha = context->alpha });
+            event_notify(SA_EVENT_WINDOW_ALPHA, context->wid, 0);
+
+            if (t >= 1.0f) {
+                window_fade_remove(context);
+            } else {
+                ++i;
+            }
+        }
+
+        pthread_mutex_unlock(&window_fade_lock);
+
+        backend->transaction_commit(transaction);
+
+        int elapsed = (int)((window_fade_now() - frame_start) * 1000000.0);
+        if (elapsed < frame_duration*1000) usleep(frame_duration*1000 - elapsed);
+
+        pthread_mutex_lock(&window_fade_lock);
+    }
+
+    return NULL;
+}
+
+static void do_window_opacity(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    float alpha;
+    unpack(alpha);
+
+    pthread_mutex_lock(&window_fade_lock);
+    if (!window_fade_retarget(wid, alpha, 0.0f)) {
+        backend->window_set_alpha(wid, alpha);
+        state_window_publish(wid, SA_STATE_ALPHA, &(struct sa_window_record) { .alpha = alpha });
+        event_notify(SA_EVENT_WINDOW_ALPHA, wid, 0);
+    }
+    pthread_mutex_unlock(&window_fade_lock);
+}
+
+static void do_window_opacity_fade(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    float alpha, duration;
+    unpack(alpha);
+    unpack(duration);
+
+    pthread_mutex_lock(&window_fade_lock);
+    if (!window_fade_retarget(wid, alpha, duration)) {
+        if (window_fade_count == window_fade_capacity) {
+            window_fade_capacity = window_fade_capacity ? 2 * window_fade_capacity : 64;
+            window_fade_list = realloc(window_fade_list, sizeof(struct window_fade_context *) * window_fade_capacity);
+        }
+
+        struct window_fade_context *context = malloc(sizeof(struct window_fade_context));
+        context->wid = wid;
+        context->index = window_fade_count;
+        context->alpha = 1.0f;
+        backend->window_get_alpha(wid, &context->alpha);
+        context->start_alpha = context->alpha;
+        context->end_alpha = alpha;
+        context->duration = duration;
+        context->start_time = window_fade_now();
+
+        window_fade_list[window_fade_count++] = context;
+        wid_table_add(&window_fade_table, wid, &context);
+        pthread_cond_signal(&window_fade_cond);
+    }
+    pthread_mutex_unlock(&window_fade_lock);
+}
+
+static void do_window_layer(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    int layer;
+    unpack(layer);
+
+    backend->window_set_layer(wid, layer);
+    state_window_forget(wid, SA_STATE_LEVEL);
+}
+
+static void do_window_sticky(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    bool value;
+    unpack(value);
+
+    uint64_t tags = (1 << 11);
+    if (value == 1) {
+        backend->window_set_tags(wid, tags);
+        state_window_tags(wid, tags, 0);
+    } else {
+        backend->window_clear_tags(wid, tags);
+        state_window_tags(wid, 0, tags);
+    }
+}
+
+static void do_window_focus(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+
+    pthread_mutex_lock(&dock_lock);
+    backend->window_focus(wid);
+    pthread_mutex_unlock(&dock_lock);
+}
+
+static void do_window_shadow(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    bool value;
+    unpack(value);
+
+    uint64_t tags = (1 << 3);
+    if (value == 1) {
+        backend->window_clear_tags(wid, tags);
+        state_window_tags(wid, 0, tags);
+    } else {
+        backend->window_set_tags(wid, tags);
+        state_window_tags(wid, tags, 0);
+    }
+}
+
+static void do_window_swap_proxy_in(char *message)
+{
+    int count = 0;
+    unpack(count);
+    if (!count) return;
+
+    void *transaction = backend->transaction_create();
+    for (int i = 0; i < count; ++i) {
+        uint32_t wid;
+        unpack(wid);
+        if (!wid) continue;
+
+        uint32_t proxy_wid;
+        unpack(proxy_wid);
+
+        backend->transaction_order_group(transaction, proxy_wid, 1, wid);
+        backend->transaction_set_alpha(transaction, wid, 0);
+        state_window_forget(wid, SA_STATE_ALPHA);
+    }
+    backend->transaction_commit(transaction);
+}
+
+static void do_window_swap_proxy_out(char *message)
+{
+    int count = 0;
+    unpack(count);
+    if (!count) return;
+
+    void *transaction = backend->transaction_create();
+    for (int i = 0; i < count; ++i) {
+        uint32_t wid;
+        unpack(wid);
+        if (!wid) continue;
+
+        uint32_t proxy_wid;
+        unpack(proxy_wid);
+
+        backend->transaction_set_alpha(transaction, wid, 1.0f);
+        backend->transaction_order_group(transaction, proxy_wid, 0, wid);
+        state_window_forget(wid, SA_STATE_ALPHA);
+    }
+    backend->transaction_commit(transaction);
+}
+
+static void do_window_order(char *message)
+{
+    uint32_t a_wid;
+    unpack(a_wid);
+    if (!a_wid) return;
+
+    int order;
+    unpack(order);
+
+    uint32_t b_wid;
+    unpack(b_wid);
+
+    backend->window_order(a_wid, order, b_wid);
+    state_window_publish(a_wid, SA_STATE_ORDERED, &(struct sa_window_record) { .ordered_in = order != 0 });
+}
+
+static void do_window_order_in(char *message)
+{
+    int count = 0;
+    unpack(count);
+    if (!count) return;
+
+    void *transaction = backend->transaction_create();
+    for (int i = 0; i < count; ++i) {
+        uint32_t wid;
+        unpack(wid);
+        if (!wid) continue;
+
+        backend->transaction_order_group(transaction, wid, 1, 0);
+        state_window_publish(wid, SA_STATE_ORDERED, &(struct sa_window_record) { .ordered_in = true });
+    }
+    backend->transaction_commit(transaction);
+}
+
+static void do_window_list_move_to_space(char *message)
+{
+    uint64_t sid;
+    unpack(sid);
+
+    int count = 0;
+    unpack(count);
+
+    backend->window_move_to_space((uint32_t *) message, count, sid);
+}
+
+static void do_window_move_to_space(char *message)
+{
+    uint64_t sid;
+    unpack(sid);
+
+    uint32_t wid;
+    unpack(wid);
+
+    backend->window_move_to_space(&wid, 1, sid);
+}
+
+//
+// NOTE: A window transaction carries sub-messages framed like batch entries,
+// restricted to move, opacity, order and layer changes; message_check
+// rejects a transaction holding anything else. They are recorded on
+// a single backend transaction so that the whole set is committed in one
+// compositor update. Moved windows are reassociated with their spaces in one
+// call after the commit.
+//
+
+static void do_window_transaction(char *message)
+{
+    int count = 0;
+    unpack(count);
+    if (count <= 0) return;
+
+    uint32_t moved_list[count];
+    int moved_count = 0;
+
+    void *transaction = backend->transaction_create();
+    for (int i = 0; i < count; ++i) {
+        int16_t length;
+        unpack(length);
+        if (length <= 0) break;
+
+        char *next = message + length;
+        enum sa_opcode op = *message++;
+
+        uint32_t wid;
+        unpack(wid);
+
+        if (wid) switch (op) {
+        case SA_OPCODE_WINDOW_MOVE: {
+            int x, y;
+            unpack(x);
+            unpack(y);
+
+            backend->transaction_move(transaction, wid, x, y);
+            moved_list[moved_count++] = wid;
+            state_window_publish(wid, SA_STATE_ORIGIN, &(struct sa_window_record) { .x = x, .y = y });
+        } break;
+        case SA_OPCODE_WINDOW_OPACITY: {
+            float alpha;
+            unpack(alpha);
+
+            pthread_mutex_lock(&window_fade_lock);
+            if (!window_fade_retarget(wid, alpha, 0.0f)) {
+                backend->transaction_set_alpha(transaction, wid, alpha);
+                state_window_publish(wid, SA_STATE_ALPHA, &(struct sa_window_record) { .alpha = alpha });
+                event_notify(SA_EVENT_WINDOW_ALPHA, wid, 0);
+            }
+            pthread_mutex_unlock(&window_fade_lock);
+        } break;
+        case SA_OPCODE_WINDOW_ORDER: {
+            int order;
+            unpack(order);
+
+            uint32_t rel_wid;
+            unpack(rel_wid);
+
+            backend->transaction_order(transaction, wid, order, rel_wid);
+            state_window_publish(wid, SA_STATE_ORDERED, &(struct sa_window_record) { .ordered_in = order != 0 });
+        } break;
+        case SA_OPCODE_WINDOW_LAYER: {
+            int layer;
+            unpack(layer);
+
+            backend->transaction_set_layer(transaction, wid, layer);
+            state_window_forget(wid, SA_STATE_LEVEL);
+        } break;
+        default: break;
+        }
+
+        message = next;
+    }
+    backend->transaction_commit(transaction);
+
+    if (moved_count) {
+        backend->window_reassociate(moved_list, moved_count);
+    }
+}
+
+// ============================================================================
+// New Feature Handlers
+// ============================================================================
+
+static void do_window_resize(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    int width, height;
+    unpack(width);
+    unpack(height);
+
+    // Get current window bounds to preserve position
+    struct backend_rect bounds = {};
+    backend->window_get_bounds(wid, &bounds);
+
+    // Set new size while keeping origin
+    bounds.width = width;
+    bounds.height = height;
+
+    backend->window_move(wid, (int) bounds.x, (int) bounds.y);
+
+    // Note: Full bounds setting may require additional SkyLight functions
+    // that need pattern matching. This is a simplified implementation.
+}
+
+static void do_window_set_frame(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    int x, y, width, height;
+    unpack(x);
+    unpack(y);
+    unpack(width);
+    unpack(height);
+
+    backend->window_move(wid, x, y);
+
+    // Note: Resize portion needs SLSSetWindowBounds or similar
+    // This implementation handles position; size change needs additional work
+
+    backend->window_reassociate(&wid, 1);
+    state_window_publish(wid, SA_STATE_ORIGIN, &(struct sa_window_record) { .x = x, .y = y });
+}
+
+static void do_window_minimize(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    // Minimize by ordering window out
+    // kCGSOrderOut = 0
+    backend->window_order(wid, 0, 0);
+    state_window_publish(wid, SA_STATE_ORDERED, &(struct sa_window_record) { .ordered_in = false });
+}
+
+static void do_window_unminimize(char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+    if (!wid) return;
+
+    // Restore window by ordering it back in
+    // kCGSOrderAbove = 1
+    backend->window_order(wid, 1, 0);
+    state_window_publish(wid, SA_STATE_ORDERED, &(struct sa_window_record) { .ordered_in = true });
+}
+
+// Response protocol helpers
+//
+// The first sizeof(struct sa_response_header) bytes of frame are reserved
+// for the header, which is filled in here; length counts the bytes after it.
+// Returns false if the client could not be written to.
+static bool send_frame(struct client_connection *conn, enum sa_status status, char *frame, uint32_t length)
+{
+    conn->responded = true;
+
+    struct sa_response_header header = {
+        .version = SA_PROTOCOL_VERSION,
+        .status = status,
+        .id = conn->request_id,
+        .length = length,
+    };
+    memcpy(frame, &header, sizeof(header));
+
+    if (conn->send_lock) pthread_mutex_lock(conn->send_lock);
+    bool sent = socket_send_all(conn->sockfd, frame, sizeof(header) + length);
+    if (conn->send_lock) pthread_mutex_unlock(conn->send_lock);
+    return sent;
+}
+
+static void send_response(struct client_connection *conn, const void *data, int length)
+{
+    char frame[sizeof(struct sa_response_header) + BUFSIZ];
+    if (length) memcpy(frame + sizeof(struct sa_response_header), data, length);
+    send_frame(conn, SA_STATUS_OK, frame, length);
+}
+
+// Query operation handlers
+static void do_window_get_opacity_query(struct client_connection *conn, char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+
+    struct sa_window_record record;
+    uint32_t sequence;
+    if (!cache_lookup(wid, SA_STATE_ALPHA, &record, &sequence)) {
+        record.alpha = 1.0f;
+        backend->window_get_alpha(wid, &record.alpha);
+        state_window_fill(wid, sequence, SA_STATE_ALPHA, &record);
+    }
+
+    float opacity = record.alpha;
+    send_response(conn, &opacity, sizeof(opacity));
+    if (sequence == CACHE_UNKNOWN) cache_admit(wid, false);
+}
+
+static void do_window_get_frame_query(struct client_connection *conn, char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+
+    struct sa_window_record record;
+    uint32_t sequence;
+    if (!cache_lookup(wid, SA_STATE_FRAME, &record, &sequence)) {
+        struct backend_rect frame = {};
+        backend->window_get_bounds(wid, &frame);
+        record.x = (int32_t) frame.x;
+        record.y = (int32_t) frame.y;
+        record.width = (int32_t) frame.width;
+        record.height = (int32_t) frame.height;
+        state_window_fill(wid, sequence, SA_STATE_FRAME, &record);
+    }
+
+    // Pack response: x, y, width, height as ints
+    int x = record.x;
+    int y = record.y;
+    int width = record.width;
+    int height = record.height;
+
+    char response[sizeof(int) * 4];
+    memcpy(response, &x, sizeof(int));
+    memcpy(response + sizeof(int), &y, sizeof(int));
+    memcpy(response + sizeof(int) * 2, &width, sizeof(int));
+    memcpy(response + sizeof(int) * 3, &height, sizeof(int));
+
+    send_response(conn, response, sizeof(response));
+    if (sequence == CACHE_UNKNOWN) cache_admit(wid, false);
+}
+
+static void do_window_is_sticky_query(struct client_connection *conn, char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+
+    struct sa_window_record record;
+    uint32_t sequence;
+    if (!cache_lookup(wid, SA_STATE_TAGS, &record, &sequence)) {
+        record.tags = backend->window_get_tags(wid);
+        state_window_fill(wid, sequence, SA_STATE_TAGS, &record);
+    }
+
+    // Tag 0x800 indicates sticky window
+    uint8_t is_sticky = (record.tags & 0x800) ? 1 : 0;
+    send_response(conn, &is_sticky, sizeof(is_sticky));
+    if (sequence == CACHE_UNKNOWN) cache_admit(wid, false);
+}
+
+static void do_window_get_layer_query(struct client_connection *conn, char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+
+    struct sa_window_record record;
+    uint32_t sequence;
+    if (!cache_lookup(wid, SA_STATE_LEVEL, &record, &sequence)) {
+        int level = 0;
+        backend->window_get_level(wid, &level);
+        record.level = level;
+        state_window_fill(wid, sequence, SA_STATE_LEVEL, &record);
+    }
+
+    int level = record.level;
+    send_response(conn, &level, sizeof(level));
+    if (sequence == CACHE_UNKNOWN) cache_admit(wid, false);
+}
+
+static void do_window_is_minimized_query(struct client_connection *conn, char *message)
+{
+    uint32_t wid;
+    unpack(wid);
+
+    struct sa_window_record record;
+    uint32_t sequence;
+    if (!cache_lookup(wid, SA_STATE_ORDERED, &record, &sequence)) {
+        record.ordered_in = backend->window_is_ordered_in(wid);
+        state_window_fill(wid, sequence, SA_STATE_ORDERED, &record);
+    }
+
+    // Window is minimized if it's NOT ordered in
+    uint8_t is_minimized = record.ordered_in ? 0 : 1;
+    send_response(conn, &is_minimized, sizeof(is_minimized));
+    if (sequence == CACHE_UNKNOWN) cache_admit(wid, false);
+}
+
+static void do_display_get_count_query(struct client_connection *conn, char *message)
+{
+    (void)message; // unused
+    uint32_t count = backend->display_list(NULL, 0);
+    state_displays_publish();
+    send_response(conn, &count, sizeof(count));
+}
+
+static void do_display_get_list_query(struct client_connection *conn, char *message)
+{
+    uint32_t max_count;
+    unpack(max_count);
+
+    uint32_t displays[32] = {};
+
+    if (max_count > 32) max_count = 32;
+
+    uint32_t count = backend->display_list(displays, max_count);
+    if (count > max_count) count = max_count;
+    state_displays_publish();
+
+    // Send count followed by display IDs
+    char response[sizeof(uint32_t) * 33]; // count + up to 32 displays
+    memcpy(response, &count, sizeof(uint32_t));
+    memcpy(response + sizeof(uint32_t), displays, sizeof(uint32_t) * count);
+
+    send_response(conn, response, sizeof(uint32_t) * (1 + count));
+}
+
+static void do_display_get_space_query(struct client_connection *conn, char *message)
+{
+    uint32_t did;
+    unpack(did);
+
+    uint64_t sid = backend->display_space(did);
+    send_response(conn, &sid, sizeof(sid));
+}
+
+static void do_window_snapshot_query(struct client_connection *conn, char *message)
+{
+    uint32_t count;
+    unpack(count);
+
+    int offset = sizeof(struct sa_response_header);
+    uint32_t length = sizeof(uint32_t) + count * sizeof(struct sa_window_record);
+    char *frame = malloc(offset + length);
+    uint32_t *admit = NULL;
+    uint32_t admit_count = 0;
+
+    // Records are filled in aligned storage; behind the count they are not
+    memcpy(frame + offset, &count, sizeof(count));
+    if (count) {
+        uint32_t wids[count];
+        struct sa_window_record *records = malloc(count * sizeof(struct sa_window_record));
+        memcpy(wids, message, sizeof(uint32_t) * count);
+
+        // Only the windows the cache cannot answer for go to the backend
+        uint32_t missed[count];
+        uint32_t sequences[count];
+        uint32_t miss_count = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t sequence;
+            if (cache_lookup(wids[i], SA_STATE_ALL, &records[i], &sequence)) continue;
+            missed[miss_count] = i;
+            sequences[miss_count] = sequence;
+            wids[miss_count++] = wids[i];
+        }
+
+        if (miss_count) {
+            struct sa_window_record *read = malloc(miss_count * sizeof(struct sa_window_record));
+            admit = malloc(miss_count * sizeof(uint32_t));
+            backend->window_snapshot(wids, miss_count, read);
+            for (uint32_t i = 0; i < miss_count; ++i) {
+                if (read[i].wid) {
+                    if (sequences[i] == CACHE_UNKNOWN) admit[admit_count++] = wids[i];
+                    state_window_fill(wids[i], sequences[i], SA_STATE_ALL, &read[i]);
+                } else {
+                    state_window_release(wids[i]);
+                }
+                records[missed[i]] = read[i];
+            }
+            free(read);
+        }
+
+        memcpy(frame + offset + sizeof(count), records, count * sizeof(struct sa_window_record));
+        free(records);
+    }
+
+    send_frame(conn, SA_STATUS_OK, frame, length);
+    free(frame);
+
+    // The backend just confirmed these exist
+    for (uint32_t i = 0; i < admit_count; ++i) {
+        cache_admit(admit[i], true);
+    }
+    free(admit);
+}
+
+static void do_window_generation_query(struct client_connection *conn)
+{
+    uint64_t generation = state_page ? __atomic_load_n(&window_generation, __ATOMIC_ACQUIRE) : 0;
+    send_response(conn, &generation, sizeof(generation));
+}
+
+static void do_stats_query(struct client_connection *conn)
+{
+    struct sa_stats stats = { .lane_count = lane_count };
+
+    for (int i = 0; i < lane_count; ++i) {
+        struct daemon_lane *lane = &lanes[i];
+        pthread_mutex_lock(&lane->lock);
+        stats.lanes[i] = (struct sa_lane_stats) {
+            .executed = lane->executed,
+            .contended = lane->contended,
+            .depth = lane->depth,
+            .max_depth = lane->max_depth,
+        };
+        stats.coalesced_moves += lane->coalesced_moves;
+        stats.coalesced_frames += lane->coalesced_frames;
+        pthread_mutex_unlock(&lane->lock);
+    }
+
+    pthread_mutex_lock(&barrier_lock);
+    stats.barriers = barrier_count;
+    stats.barrier_waits = barrier_waits;
+    pthread_mutex_unlock(&barrier_lock);
+
+    pthread_mutex_lock(&event_lock);
+    stats.event_reports = event_reports;
+    stats.events_sent = event_sent;
+    stats.cache_hits = __atomic_load_n(&cache_hits, __ATOMIC_RELAXED);
+    stats.cache_misses = __atomic_load_n(&cache_misses, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&event_lock);
+
+    send_response(conn, &stats, sizeof(stats));
+}
+
+// The connection becomes the subscriber's once the request is acknowledged
+static void do_subscribe(struct client_connection *conn, char *message)
+{
+    if (conn->send_lock) {
+        char frame[sizeof(struct sa_response_header)];
+        send_frame(conn, SA_STATUS_BAD_REQUEST, frame, 0);
+        return;
+    }
+
+    uint32_t events;
+    unpack(events);
+
+    uint32_t count;
+    unpack(count);
+
+    struct event_subscriber *subscriber = calloc(1, sizeof(struct event_subscriber));
+    subscriber->events = events & SA_EVENT_ALL;
+    wid_table_init(&subscriber->windows, count, 0);
+
+    uint32_t *wids = malloc(sizeof(uint32_t) * (count + 1));
+    memcpy(wids, message, sizeof(uint32_t) * count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (wids[i]) wid_table_add(&subscriber->windows, wids[i], NULL);
+    }
+
+    if (count && (events & SA_EVENT_WINDOW_ALL)) backend->watch_windows(wids, count);
+    free(wids);
+
+    conn->subscriber = subscriber;
+}
+
+static void do_handshake(struct client_connection *conn)
+{
+    uint32_t attrib = backend->capabilities();
+
+    char bytes[BUFSIZ] = {};
+    int version_length = strlen(OSAX_VERSION);
+    int attrib_length = sizeof(uint32_t);
+    int bytes_length = version_length + 1 + attrib_length;
+
+    memcpy(bytes, OSAX_VERSION, version_length);
+    memcpy(bytes + version_length + 1, &attrib, attrib_length);
+    bytes[version_length] = '\0';
+    bytes[bytes_length] = '\n';
+
+    send_response(conn, bytes, bytes_length+1);
+}
+
+static void handle_message(struct client_connection *conn, char *message);
+static enum sa_status message_check(char *message, int length);
+
+static bool is_batchable(enum sa_opcode op)
+{
+    switch (op) {
+    case SA_OPCODE_HANDSHAKE:
+    case SA_OPCODE_SESSION:
+    case SA_OPCODE_BATCH:
+    case SA_OPCODE_WINDOW_GET_OPACITY:
+    case SA_OPCODE_WINDOW_GET_FRAME:
+    case SA_OPCODE_WINDOW_IS_STICKY:
+    case SA_OPCODE_WINDOW_GET_LAYER:
+    case SA_OPCODE_WINDOW_IS_MINIMIZED:
+    case SA_OPCODE_DISPLAY_GET_COUNT:
+    case SA_OPCODE_DISPLAY_GET_LIST:
+    case SA_OPCODE_WINDOW_SNAPSHOT:
+    case SA_OPCODE_STATS:
+    case SA_OPCODE_DISPLAY_GET_SPACE:
+    case SA_OPCODE_SUBSCRIBE:
+    case SA_OPCODE_WINDOW_GENERATION:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// Operations a transaction may carry; do_window_transaction reads a wid
+// from each before looking at its opcode
+static bool is_transactable(enum sa_opcode op)
+{
+    switch (op) {
+    case SA_OPCODE_WINDOW_MOVE:
+    case SA_OPCODE_WINDOW_OPACITY:
+    case SA_OPCODE_WINDOW_ORDER:
+    case SA_OPCODE_WINDOW_LAYER:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Checks that a count at offset is followed by that many items of item_size
+static bool message_list_fits(char *args, int length, int offset, int item_size)
+{
+    int count;
+    if (length < offset + (int) sizeof(count)) return false;
+
+    memcpy(&count, args + offset, sizeof(count));
+    return count >= 0 && count <= (length - offset - (int) sizeof(count)) / item_size;
+}
+
+// Checks that count sub-messages, framed like batch entries, fill args
+// exactly; a transaction's must also be operations it can carry
+static enum sa_status message_check_nested(char *args, int length, bool transaction)
+{
+    int count;
+    if (length < (int) sizeof(count)) return SA_STATUS_BAD_REQUEST;
+
+    memcpy(&count, args, sizeof(count));
+    args += sizeof(count);
+    length -= sizeof(count);
+    if (count < 0) return SA_STATUS_BAD_REQUEST;
+
+    for (int i = 0; i < count; ++i) {
+        int16_t sub_length;
+        if (length < (int) sizeof(sub_length)) return SA_STATUS_BAD_REQUEST;
+
+        memcpy(&sub_length, args, sizeof(sub_length));
+        args += sizeof(sub_length);
+        length -= sizeof(sub_length);
+        if (sub_length <= 0 || sub_length > length) return SA_STATUS_BAD_REQUEST;
+        if (transaction && !is_transactable(*args)) return SA_STATUS_BAD_REQUEST;
+
+        enum sa_status status = message_check(args, sub_length);
+        if (status != SA_STATUS_OK) return status;
+
+        args += sub_length;
+        length -= sub_length;
+    }
+
+    return SA_STATUS_OK;
+}
+
+//
+// NOTE: Handlers unpack their arguments without bounds checks, so every
+// message is checked against the layout of its opcode before it runs. A
+// malformed batch or transaction is rejected as a whole, not partially
+// applied.
+//
+
+static enum sa_status message_check(char *message, int length)
+{
+    if (length < 1) return SA_STATUS_BAD_REQUEST;
+
+    enum sa_opcode op = *message;
+    char *args = message + 1;
+    int args_length = length - 1;
+    int size = 0;
+
+    switch (op) {
+    case SA_OPCODE_HANDSHAKE:
+    case SA_OPCODE_SESSION:
+    case SA_OPCODE_STATS:
+    case SA_OPCODE_DISPLAY_GET_COUNT:
+    case SA_OPCODE_WINDOW_GENERATION:
+        size = 0;
+        break;
+    case SA_OPCODE_WINDOW_FOCUS:
+    case SA_OPCODE_WINDOW_GET_OPACITY:
+    case SA_OPCODE_WINDOW_GET_FRAME:
+    case SA_OPCODE_WINDOW_IS_STICKY:
+    case SA_OPCODE_WINDOW_GET_LAYER:
+    case SA_OPCODE_WINDOW_MINIMIZE:
+    case SA_OPCODE_WINDOW_UNMINIMIZE:
+    case SA_OPCODE_WINDOW_IS_MINIMIZED:
+    case SA_OPCODE_DISPLAY_GET_LIST:
+    case SA_OPCODE_DISPLAY_GET_SPACE:
+        size = sizeof(uint32_t);
+        break;
+    case SA_OPCODE_WINDOW_STICKY:
+    case SA_OPCODE_WINDOW_SHADOW:
+        size = sizeof(uint32_t) + sizeof(bool);
+        break;
+    case SA_OPCODE_WINDOW_OPACITY:
+    case SA_OPCODE_WINDOW_LAYER:
+        size = sizeof(uint32_t) + sizeof(int);
+        break;
+    case SA_OPCODE_SPACE_FOCUS:
+    case SA_OPCODE_SPACE_CREATE:
+    case SA_OPCODE_SPACE_DESTROY:
+        size = sizeof(uint64_t);
+        break;
+    case SA_OPCODE_WINDOW_MOVE:
+    case SA_OPCODE_WINDOW_OPACITY_FADE:
+    case SA_OPCODE_WINDOW_ORDER:
+    case SA_OPCODE_WINDOW_RESIZE:
+        size = sizeof(uint32_t) + 2 * sizeof(int);
+        break;
+    case SA_OPCODE_WINDOW_TO_SPACE:
+        size = sizeof(uint64_t) + sizeof(uint32_t);
+        break;
+    case SA_OPCODE_WINDOW_SCALE:
+    case SA_OPCODE_WINDOW_SET_FRAME:
+        size = sizeof(uint32_t) + 4 * sizeof(int);
+        break;
+    case SA_OPCODE_SPACE_MOVE:
+        size = 3 * sizeof(uint64_t) + sizeof(bool);
+        break;
+    case SA_OPCODE_WINDOW_SWAP_PROXY_IN:
+    case SA_OPCODE_WINDOW_SWAP_PROXY_OUT:
+        return message_list_fits(args, args_length, 0, 2 * sizeof(uint32_t)) ? SA_STATUS_OK : SA_STATUS_BAD_REQUEST;
+    case SA_OPCODE_WINDOW_ORDER_IN:
+        return message_list_fits(args, args_length, 0, sizeof(uint32_t)) ? SA_STATUS_OK : SA_STATUS_BAD_REQUEST;
+    case SA_OPCODE_WINDOW_LIST_TO_SPACE:
+        return message_list_fits(args, args_length, sizeof(uint64_t), sizeof(uint32_t)) ? SA_STATUS_OK : SA_STATUS_BAD_REQUEST;
+    case SA_OPCODE_SUBSCRIBE:
+        return message_list_fits(args, args_length, sizeof(uint32_t), sizeof(uint32_t)) ? SA_STATUS_OK : SA_STATUS_BAD_REQUEST;
+    case SA_OPCODE_WINDOW_SNAPSHOT: {
+        uint32_t count = 0;
+        if (args_length >= (int) sizeof(count)) memcpy(&count, args, sizeof(count));
+        return count <= SA_SNAPSHOT_MAX && message_list_fits(args, args_length, 0, sizeof(uint32_t)) ? SA_STATUS_OK : SA_STATUS_BAD_REQUEST;
+    }
+    case SA_OPCODE_BATCH:
+        return message_check_nested(args, args_length, false);
+    case SA_OPCODE_WINDOW_TRANSACTION:
+        return message_check_nested(args, args_length, true);
+    default:
+        return SA_STATUS_UNKNOWN_OPCODE;
+    }
+
+    return args_length >= size ? SA_STATUS_OK : SA_STATUS_BAD_REQUEST;
+}
+
+//
+// NOTE: A batch is a count followed by that many complete sub-messages, each
+// framed like a top-level message without the request id. They run in order
+// under the same request and are answered with a single acknowledgement.
+// Only mutations are accepted; queries and control opcodes inside a batch
+// are skipped.
+//
+
+static void do_batch(struct client_connection *conn, char *message)
+{
+    int count = 0;
+    unpack(count);
+
+    for (int i = 0; i < count; ++i) {
+        int16_t length;
+        unpack(length);
+        if (length <= 0) break;
+
+        if (is_batchable(*message)) {
+            handle_message(conn, message);
+        }
+
+        message += length;
+    }
+}
+
+static void handle_message(struct client_connection *conn, char *message)
+{
+    enum sa_opcode op = *message++;
+    switch (op) {
+    case SA_OPCODE_HANDSHAKE: {
+        do_handshake(conn);
+    } break;
+    case SA_OPCODE_SPACE_FOCUS: {
+        do_space_focus(message);
+    } break;
+    case SA_OPCODE_SPACE_CREATE: {
+        do_space_create(message);
+    } break;
+    case SA_OPCODE_SPACE_DESTROY: {
+        do_space_destroy(message);
+    } break;
+    case SA_OPCODE_SPACE_MOVE: {
+        do_space_move(message);
+    } break;
+    case SA_OPCODE_WINDOW_MOVE: {
+        do_window_move(message);
+    } break;
+    case SA_OPCODE_WINDOW_OPACITY: {
+        do_window_opacity(message);
+    } break;
+    case SA_OPCODE_WINDOW_OPACITY_FADE: {
+        do_window_opacity_fade(message);
+    } break;
+    case SA_OPCODE_WINDOW_LAYER: {
+        do_window_layer(message);
+    } break;
+    case SA_OPCODE_WINDOW_STICKY: {
+        do_window_sticky(message);
+    } break;
+    case SA_OPCODE_WINDOW_SHADOW: {
+        do_window_shadow(message);
+    } break;
+    case SA_OPCODE_WINDOW_FOCUS: {
+        do_window_focus(message);
+    } break;
+    case SA_OPCODE_WINDOW_SCALE: {
+        do_window_scale(message);
+    } break;
+    case SA_OPCODE_WINDOW_SWAP_PROXY_IN: {
+        do_window_swap_proxy_in(message);
+    } break;
+    case SA_OPCODE_WINDOW_SWAP_PROXY_OUT: {
+        do_window_swap_proxy_out(message);
+    } break;
+    case SA_OPCODE_WINDOW_ORDER: {
+        do_window_order(message);
+    } break;
+    case SA_OPCODE_WINDOW_ORDER_IN: {
+        do_window_order_in(message);
+    } break;
+    case SA_OPCODE_WINDOW_LIST_TO_SPACE: {
+        do_window_list_move_to_space(message);
+    } break;
+    case SA_OPCODE_WINDOW_TO_SPACE: {
+        do_window_move_to_space(message);
+    } break;
+    // New feature opcodes
+    case SA_OPCODE_WINDOW_RESIZE: {
+        do_window_resize(message);
+    } break;
+    case SA_OPCODE_WINDOW_SET_FRAME: {
+        do_window_set_frame(message);
+    } break;
+    case SA_OPCODE_WINDOW_MINIMIZE: {
+        do_window_minimize(message);
+    } break;
+    case SA_OPCODE_WINDOW_UNMINIMIZE: {
+        do_window_unminimize(message);
+    } break;
+    // Query operations
+    case SA_OPCODE_WINDOW_GET_OPACITY: {
+        do_window_get_opacity_query(conn, message);
+    } break;
+    case SA_OPCODE_WINDOW_GET_FRAME: {
+        do_window_get_frame_query(conn, message);
+    } break;
+    case SA_OPCODE_WINDOW_IS_STICKY: {
+        do_window_is_sticky_query(conn, message);
+    } break;
+    case SA_OPCODE_WINDOW_GET_LAYER: {
+        do_window_get_layer_query(conn, message);
+    } break;
+    case SA_OPCODE_WINDOW_IS_MINIMIZED: {
+        do_window_is_minimized_query(conn, message);
+    } break;
+    case SA_OPCODE_DISPLAY_GET_COUNT: {
+        do_display_get_count_query(conn, message);
+    } break;
+    case SA_OPCODE_DISPLAY_GET_LIST: {
+        do_display_get_list_query(conn, message);
+    } break;
+    case SA_OPCODE_DISPLAY_GET_SPACE: {
+        do_display_get_space_query(conn, message);
+    } break;
+    case SA_OPCODE_WINDOW_SNAPSHOT: {
+        do_window_snapshot_query(conn, message);
+    } break;
+    case SA_OPCODE_STATS: {
+        do_stats_query(conn);
+    } break;
+    case SA_OPCODE_WINDOW_GENERATION: {
+        do_window_generation_query(conn);
+    } break;
+    case SA_OPCODE_SESSION: {
+        conn->session = true;
+    } break;
+    case SA_OPCODE_SUBSCRIBE: {
+        do_subscribe(conn, message);
+    } break;
+    case SA_OPCODE_BATCH: {
+        do_batch(conn, message);
+    } break;
+    case SA_OPCODE_WINDOW_TRANSACTION: {
+        do_window_transaction(message);
+    } break;
+    }
+}
+
+static void dispatch_message(struct client_connection *conn, char *message, int length)
+{
+    conn->responded = false;
+
+    enum sa_status status = message_check(message, length);
+    if (status == SA_STATUS_OK) {
+        handle_message(conn, message);
+    }
+
+    //
+    // NOTE: Clients wait for a response to every message so that they know
+    // when it has been applied. Mutations and rejected messages produce no
+    // payload, so they are answered with a bare header.
+    //
+
+    if (!conn->responded) {
+        char frame[sizeof(struct sa_response_header)];
+        send_frame(conn, status, frame, 0);
+    }
+}
+
+// Returns the length of the message read, or -1 once the connection is done
+static inline int read_message(struct client_connection *conn, char *message)
+{
+    uint16_t request_id;
+    int16_t length;
+
+    if (!socket_recv_all(conn->sockfd, &request_id, sizeof(request_id)) ||
+        !socket_recv_all(conn->sockfd, &length, sizeof(length))) {
+        return -1;
+    }
+
+    conn->request_id = request_id;
+
+    if (length < 0 || length > SA_MESSAGE_MAX - (int) sizeof(int16_t)) {
+        char frame[sizeof(struct sa_response_header)];
+        send_frame(conn, SA_STATUS_BAD_REQUEST, frame, 0);
+        return -1;
+    }
+
+    return socket_recv_all(conn->sockfd, message, length) ? length : -1;
+}
+
+// Returns false for a barrier; key is 0 for requests with no target, and
+// wid is set for requests that target one window
+static bool message_lane_key(char *message, uint64_t *key, uint32_t *wid)
+{
+    *wid = 0;
+
+    enum sa_opcode op = *message++;
+    switch (op) {
+    case SA_OPCODE_SPACE_FOCUS:
+    case SA_OPCODE_SPACE_CREATE:
+    case SA_OPCODE_SPACE_DESTROY:
+    case SA_OPCODE_SPACE_MOVE: {
+        uint64_t sid;
+        unpack(sid);
+        *key = sid;
+    } return true;
+    case SA_OPCODE_WINDOW_MOVE:
+    case SA_OPCODE_WINDOW_OPACITY:
+    case SA_OPCODE_WINDOW_OPACITY_FADE:
+    case SA_OPCODE_WINDOW_LAYER:
+    case SA_OPCODE_WINDOW_STICKY:
+    case SA_OPCODE_WINDOW_SHADOW:
+    case SA_OPCODE_WINDOW_FOCUS:
+    case SA_OPCODE_WINDOW_SCALE:
+    case SA_OPCODE_WINDOW_ORDER:
+    case SA_OPCODE_WINDOW_RESIZE:
+    case SA_OPCODE_WINDOW_SET_FRAME:
+    case SA_OPCODE_WINDOW_MINIMIZE:
+    case SA_OPCODE_WINDOW_UNMINIMIZE:
+    case SA_OPCODE_WINDOW_GET_OPACITY:
+    case SA_OPCODE_WINDOW_GET_FRAME:
+    case SA_OPCODE_WINDOW_IS_STICKY:
+    case SA_OPCODE_WINDOW_GET_LAYER:
+    case SA_OPCODE_WINDOW_IS_MINIMIZED: {
+        unpack(*wid);
+        *key = *wid;
+    } return true;
+    case SA_OPCODE_HANDSHAKE:
+    case SA_OPCODE_SESSION:
+    case SA_OPCODE_DISPLAY_GET_COUNT:
+    case SA_OPCODE_DISPLAY_GET_LIST:
+    case SA_OPCODE_DISPLAY_GET_SPACE:
+    case SA_OPCODE_STATS:
+    case SA_OPCODE_SUBSCRIBE:
+    case SA_OPCODE_WINDOW_GENERATION: {
+        *key = 0;
+    } return true;
+    default:
+        return false;
+    }
+}
+
+static inline struct daemon_lane *lane_for_key(uint64_t key)
+{
+    if (!key) return &lanes[0];
+
+    uint64_t hash = (key ^ (key >> 32)) * 0x9E3779B97F4A7C15ull;
+    return &lanes[(hash >> 32) % lane_count];
+}
+
+static inline void lane_lock(struct daemon_lane *lane)
+{
+    if (pthread_mutex_trylock(&lane->lock) != 0) {
+        pthread_mutex_lock(&lane->lock);
+        ++lane->contended;
+    }
+}
+
+// Must be called with the lane lock held
+static void lane_coalesce(struct daemon_lane *lane, struct daemon_job *job)
+{
+    enum sa_opcode op = job->message[0];
+    bool coalescable = op == SA_OPCODE_WINDOW_MOVE || op == SA_OPCODE_WINDOW_SET_FRAME;
+    struct lane_pending *pending = wid_table_find(&lane->pending, job->wid);
+
+    if (coalescable && pending && pending->epoch == lane->epoch && (enum sa_opcode) pending->job->message[0] == op) {
+        struct daemon_job *queued = pending->job;
+        memcpy(queued->message, job->message, job->length < queued->length ? job->length : queued->length);
+        job->coalesced = true;
+
+        if (op == SA_OPCODE_WINDOW_MOVE) {
+            ++lane->coalesced_moves;
+        } else {
+            ++lane->coalesced_frames;
+        }
+    } else if (coalescable) {
+        pending = wid_table_add(&lane->pending, job->wid, NULL);
+        *pending = (struct lane_pending) { .job = job, .epoch = lane->epoch };
+    } else if (pending) {
+        wid_table_remove(&lane->pending, job->wid);
+    }
+}
+
+static void lane_push(struct daemon_lane *lane, struct daemon_job *job)
+{
+    job->next = NULL;
+
+    lane_lock(lane);
+    if (job->barrier || job->references) {
+        ++lane->epoch;
+    } else if (job->wid) {
+        lane_coalesce(lane, job);
+    }
+
+    if (lane->tail) {
+        lane->tail->next = job;
+    } else {
+        lane->head = job;
+    }
+    lane->tail = job;
+    if (++lane->depth > lane->max_depth) lane->max_depth = lane->depth;
+    pthread_cond_signal(&lane->cond);
+    pthread_mutex_unlock(&lane->lock);
+}
+
+static void daemon_submit(struct daemon_job *job)
+{
+    struct client_session *session = job->session;
+    if (session) {
+        pthread_mutex_lock(&session->lock);
+        ++session->pending;
+        pthread_mutex_unlock(&session->lock);
+    }
+
+    // Malformed messages are only answered, so any lane will do
+    if (message_check(job->message, job->length) != SA_STATUS_OK) {
+        lane_push(&lanes[0], job);
+        return;
+    }
+
+    uint64_t key;
+    if (message_lane_key(job->message, &key, &job->wid)) {
+        lane_push(lane_for_key(key), job);
+        return;
+    }
+
+    //
+    // NOTE: Barriers are queued on every lane under barrier_lock, so that two
+    // barriers are always queued in the same order on every lane. Otherwise
+    // two lanes could each be waiting for the other to reach a barrier.
+    //
+
+    job->waiting = lane_count;
+    job->references = lane_count;
+    job->done = false;
+
+    pthread_mutex_lock(&barrier_lock);
+    lane_push(&lanes[0], job);
+    for (int i = 1; i < lane_count; ++i) {
+        struct daemon_job *placeholder = calloc(1, sizeof(struct daemon_job));
+        placeholder->barrier = job;
+        lane_push(&lanes[i], placeholder);
+    }
+    pthread_mutex_unlock(&barrier_lock);
+}
+
+static struct daemon_job *daemon_job_create(struct client_session *session, struct client_connection *conn, char *message, int length)
+{
+    struct daemon_job *job = calloc(1, sizeof(struct daemon_job) + length);
+    job->session = session;
+    job->conn = *conn;
+    job->length = length;
+    memcpy(job->message, message, length);
+    return job;
+}
+
+static void *handle_session(void *data)
+{
+    struct client_session *session = data;
+
+    char message[SA_MESSAGE_MAX];
+    int length;
+    while ((length = read_message(&session->conn, message)) != -1) {
+        pthread_mutex_lock(&session->lock);
+        while (session->pending >= SESSION_BACKLOG_MAX) {
+            pthread_cond_wait(&session->drained, &session->lock);
+        }
+        pthread_mutex_unlock(&session->lock);
+
+        daemon_submit(daemon_job_create(session, &session->conn, message, length));
+    }
+
+    pthread_mutex_lock(&session->lock);
+    while (session->pending > 0) {
+        pthread_cond_wait(&session->drained, &session->lock);
+    }
+    pthread_mutex_unlock(&session->lock);
+
+    shutdown(session->conn.sockfd, SHUT_RDWR);
+    close(session->conn.sockfd);
+    pthread_cond_destroy(&session->drained);
+    pthread_mutex_destroy(&session->lock);
+    pthread_mutex_destroy(&session->send_lock);
+    free(session);
+
+    return NULL;
+}
+
+static bool session_start(struct client_connection *conn)
+{
+    struct client_session *session = calloc(1, sizeof(struct client_session));
+    pthread_mutex_init(&session->send_lock, NULL);
+    pthread_mutex_init(&session->lock, NULL);
+    pthread_cond_init(&session->drained, NULL);
+    session->conn = *conn;
+    session->conn.send_lock = &session->send_lock;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &handle_session, session) == 0) {
+        pthread_detach(thread);
+        return true;
+    }
+
+    pthread_cond_destroy(&session->drained);
+    pthread_mutex_destroy(&session->lock);
+    pthread_mutex_destroy(&session->send_lock);
+    free(session);
+    return false;
+}
+
+static void event_subscriber_free(struct event_subscriber *subscriber)
+{
+    shutdown(subscriber->conn.sockfd, SHUT_RDWR);
+    close(subscriber->conn.sockfd);
+    wid_table_free(&subscriber->windows);
+    free(subscriber);
+}
+
+static void event_subscribe(struct event_subscriber *subscriber, struct client_connection *conn)
+{
+    subscriber->conn = *conn;
+    subscriber->conn.subscriber = NULL;
+
+    struct timeval timeout = { .tv_sec = EVENT_SEND_TIMEOUT };
+    setsockopt(conn->sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    pthread_mutex_lock(&event_subscriber_lock);
+    subscriber->next = event_subscribers;
+    event_subscribers = subscriber;
+    __atomic_store_n(&event_active, true, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&event_subscriber_lock);
+}
+
+//
+// NOTE: Before sending, the flush thread re-reads the geometry and ordering
+// of reported windows the state page knows and records them, so that local
+// reads see changes made behind the payload's back within a frame. Like a
+// query that missed the cache, it records nothing if the entry changed while
+// it was reading.
+//
+
+static void event_refresh_window(uint32_t wid, uint32_t events)
+{
+    struct sa_state_window *entry = sa_state_window_find(state_page, wid);
+    if (!entry) return;
+
+    uint32_t sequence = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+    struct sa_window_record record = {};
+    uint32_t fields = 0;
+
+    if (events & (SA_EVENT_WINDOW_MOVED | SA_EVENT_WINDOW_RESIZED)) {
+        struct backend_rect frame = {};
+        backend->window_get_bounds(wid, &frame);
+        record.x = (int32_t) frame.x;
+        record.y = (int32_t) frame.y;
+        record.width = (int32_t) frame.width;
+        record.height = (int32_t) frame.height;
+        fields |= SA_STATE_FRAME;
+    }
+
+    if (events & SA_EVENT_WINDOW_ORDERED) {
+        record.ordered_in = backend->window_is_ordered_in(wid);
+        fields |= SA_STATE_ORDERED;
+    }
+
+    if (fields) state_window_fill(wid, sequence, fields, &record);
+}
+
+static void event_refresh(struct wid_table *windows, int display_count)
+{
+    if (!state_page) return;
+
+    wid_table_for(slot, *windows) event_refresh_window(slot->wid, *(uint32_t *) wid_slot_value(slot));
+
+    if (display_count) state_displays_publish();
+}
+
+// Fills in the event a subscriber gets for a window, if any; returns how many
+static int event_select(struct event_subscriber *subscriber, uint32_t wid, uint32_t changed, struct sa_event *event)
+{
+    uint32_t wanted = changed & subscriber->events;
+    if (!wanted || !wid_table_find(&subscriber->windows, wid)) return 0;
+
+    *event = (struct sa_event) { .events = wanted, .id = wid };
+    return 1;
+}
+
+// Sends a subscriber its share of a flush; false once it is gone
+static bool event_send(struct event_subscriber *subscriber, char *frame, const struct sa_event *events, int count)
+{
+    for (int offset = 0; offset < count; offset += SA_EVENT_BATCH_MAX) {
+        int chunk = count - offset < SA_EVENT_BATCH_MAX ? count - offset : SA_EVENT_BATCH_MAX;
+        memcpy(frame + sizeof(struct sa_response_header), events + offset, sizeof(struct sa_event) * chunk);
+        if (!send_frame(&subscriber->conn, SA_STATUS_OK, frame, sizeof(struct sa_event) * chunk)) return false;
+    }
+
+    return true;
+}
+
+static void *event_thread_proc(void *unused)
+{
+    (void) unused;
+
+    struct wid_table windows;
+    wid_table_init(&windows, 64, sizeof(uint32_t));
+
+    struct sa_event displays[SA_STATE_DISPLAY_MAX];
+    struct sa_event *events = NULL;
+    int capacity = 0;
+    char *frame = malloc(sizeof(struct sa_response_header) + sizeof(struct sa_event) * SA_EVENT_BATCH_MAX);
+    uint64_t flushed = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&event_lock);
+        while (!event_windows.count && !event_display_count) {
+            pthread_cond_wait(&event_cond, &event_lock);
+        }
+        pthread_mutex_unlock(&event_lock);
+
+        // Reports arriving during the rest of the frame join this flush
+        uint64_t now = sa_state_now();
+        if (now < flushed + EVENT_FRAME_NS) {
+            uint64_t wait = flushed + EVENT_FRAME_NS - now;
+            nanosleep(&(struct timespec) { .tv_sec = wait / 1000000000ull, .tv_nsec = wait % 1000000000ull }, NULL);
+        }
+        flushed = sa_state_now();
+
+        pthread_mutex_lock(&event_lock);
+        struct wid_table pending = event_windows;
+        event_windows = windows;
+        windows = pending;
+        int display_count = event_display_count;
+        memcpy(displays, event_displays, sizeof(struct sa_event) * display_count);
+        event_display_count = 0;
+        pthread_mutex_unlock(&event_lock);
+
+        event_refresh(&windows, display_count);
+
+        if (capacity < windows.count + display_count) {
+            capacity = windows.count + display_count;
+            events = realloc(events, sizeof(struct sa_event) * capacity);
+        }
+
+        // Only this thread unlinks subscribers and others only push new ones
+        // onto the head, so the list from the current head on can be walked
+        // and sent to without holding the lock
+        pthread_mutex_lock(&event_subscriber_lock);
+        struct event_subscriber *head = event_subscribers;
+        pthread_mutex_unlock(&event_subscriber_lock);
+
+        uint64_t sent = 0;
+        bool failed = false;
+        for (struct event_subscriber *subscriber = head; subscriber; subscriber = subscriber->next) {
+            int count = 0;
+            wid_table_for(slot, windows) count += event_select(subscriber, slot->wid, *(uint32_t *) wid_slot_value(slot), &events[count]);
+
+            for (int i = 0; i < display_count; ++i) {
+                uint32_t wanted = displays[i].events & subscriber->events;
+                if (wanted) events[count++] = (struct sa_event) { .events = wanted, .id = displays[i].id, .sid = displays[i].sid };
+            }
+
+            if (event_send(subscriber, frame, events, count)) {
+                sent += count;
+            } else {
+                subscriber->gone = true;
+                failed = true;
+            }
+        }
+
+        if (failed) {
+            struct event_subscriber *gone = NULL;
+            pthread_mutex_lock(&event_subscriber_lock);
+            for (struct event_subscriber **link = &event_subscribers; *link;) {
+                struct event_subscriber *subscriber = *link;
+                if (subscriber->gone) {
+                    *link = subscriber->next;
+                    subscriber->next = gone;
+                    gone = subscriber;
+                } else {
+                    link = &subscriber->next;
+                }
+            }
+            __atomic_store_n(&event_active, event_subscribers != NULL, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&event_subscriber_lock);
+
+            while (gone) {
+                struct event_subscriber *next = gone->next;
+                event_subscriber_free(gone);
+                gone = next;
+            }
+        }
+
+        wid_table_clear(&windows);
+
+        pthread_mutex_lock(&event_lock);
+        event_sent += sent;
+        pthread_mutex_unlock(&event_lock);
+    }
+
+    return NULL;
+}
+
+static void job_run(struct daemon_job *job)
+{
+    if (job->coalesced) {
+        char frame[sizeof(struct sa_response_header)];
+        send_frame(&job->conn, SA_STATUS_OK, frame, 0);
+    } else {
+        dispatch_message(&job->conn, job->message, job->length);
+    }
+
+    struct client_session *session = job->session;
+    if (session) {
+        pthread_mutex_lock(&session->lock);
+        --session->pending;
+        pthread_cond_signal(&session->drained);
+        pthread_mutex_unlock(&session->lock);
+        return;
+    }
+
+    //
+    // NOTE: A session keeps its socket open for as long as the client wants
+    // it, so its requests are read by a thread of its own from here on.
+    //
+
+    if (job->conn.session && session_start(&job->conn)) return;
+
+    if (job->conn.subscriber) {
+        event_subscribe(job->conn.subscriber, &job->conn);
+        return;
+    }
+
+    shutdown(job->conn.sockfd, SHUT_RDWR);
+    close(job->conn.sockfd);
+}
+
+// The last lane to reach a barrier runs it while the others wait
+static void job_run_barrier(struct daemon_job *job)
+{
+    pthread_mutex_lock(&barrier_lock);
+    if (--job->waiting == 0) {
+        ++barrier_count;
+        pthread_mutex_unlock(&barrier_lock);
+
+        job_run(job);
+
+        pthread_mutex_lock(&barrier_lock);
+        job->done = true;
+        pthread_cond_broadcast(&barrier_cond);
+    } else {
+        ++barrier_waits;
+        while (!job->done) {
+            pthread_cond_wait(&barrier_cond, &barrier_lock);
+        }
+    }
+
+    bool last = --job->references == 0;
+    pthread_mutex_unlock(&barrier_lock);
+
+    if (last) free(job);
+}
+
+static void *lane_thread_proc(void *data)
+{
+    struct daemon_lane *lane = data;
+
+    for (;;) {
+        lane_lock(lane);
+        while (!lane->head) {
+            pthread_cond_wait(&lane->cond, &lane->lock);
+        }
+        struct daemon_job *job = lane->head;
+        lane->head = job->next;
+        if (!lane->head) lane->tail = NULL;
+
+        // Once started, a request can no longer absorb newer ones
+        if (job->wid && !job->coalesced) {
+            struct lane_pending *pending = wid_table_find(&lane->pending, job->wid);
+            if (pending && pending->job == job) wid_table_remove(&lane->pending, job->wid);
+        }
+        pthread_mutex_unlock(&lane->lock);
+
+        if (job->barrier) {
+            job_run_barrier(job->barrier);
+            free(job);
+        } else if (job->references) {
+            job_run_barrier(job);
+        } else {
+            job_run(job);
+            free(job);
+        }
+
+        lane_lock(lane);
+        --lane->depth;
+        ++lane->executed;
+        pthread_mutex_unlock(&lane->lock);
+    }
+
+    return NULL;
+}
+
+//
+// NOTE: The accept thread never blocks on a client. Accepted sockets are made
+// non-blocking and polled together with the listening socket, and each one's
+// first message is read in whatever pieces arrive. Only once it is complete
+// is the socket made blocking again and handed on as a job, so a client that
+// connects and then stalls delays nobody else. A connection whose first
+// message has not arrived within CONNECTION_READ_TIMEOUT is dropped, and no
+// more are accepted while CONNECTION_PENDING_MAX are still being read.
+//
+
+#define CONNECTION_PENDING_MAX  256
+#define CONNECTION_READ_TIMEOUT 5000000000ull   // ns
+
+struct pending_connection
+{
+    int sockfd;
+    uint64_t accepted;
+    int received;                   // Bytes of header, then of message
+    char header[sizeof(uint16_t) + sizeof(int16_t)];
+    int16_t length;                 // Valid once the header is in
+    char *message;
+};
+
+static void pending_connection_close(struct pending_connection *pending)
+{
+    shutdown(pending->sockfd, SHUT_RDWR);
+    close(pending->sockfd);
+    free(pending->message);
+}
+
+// Reads whatever has arrived. Returns false once the connection is no
+// longer pending: its message was submitted, or it was closed.
+static bool pending_connection_read(struct pending_connection *pending)
+{
+    int header_size = sizeof(pending->header);
+
+    for (;;) {
+        char *target = pending->received < header_size
+                     ? pending->header + pending->received
+                     : pending->message + (pending->received - header_size);
+        int wanted = pending->received < header_size
+                   ? header_size - pending->received
+                   : header_size + pending->length - pending->received;
+        if (!wanted) break;
+
+        ssize_t result = recv(pending->sockfd, target, wanted, 0);
+        if (result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return true;
+        if (result <= 0) {
+            pending_connection_close(pending);
+            return false;
+        }
+
+        bool header_done = pending->received < header_size && pending->received + result == header_size;
+        pending->received += (int) result;
+        if (!header_done) continue;
+
+        memcpy(&pending->length, pending->header + sizeof(uint16_t), sizeof(int16_t));
+        if (pending->length < 0 || pending->length > SA_MESSAGE_MAX - (int) sizeof(int16_t)) {
+            struct client_connection conn = { .sockfd = pending->sockfd };
+            memcpy(&conn.request_id, pending->header, sizeof(uint16_t));
+            fcntl(pending->sockfd, F_SETFL, fcntl(pending->sockfd, F_GETFL) & ~O_NONBLOCK);
+
+            char frame[sizeof(struct sa_response_header)];
+            send_frame(&conn, SA_STATUS_BAD_REQUEST, frame, 0);
+            pending_connection_close(pending);
+            return false;
+        }
+        pending->message = malloc(pending->length ? pending->length : 1);
+    }
+
+    struct client_connection conn = { .sockfd = pending->sockfd };
+    memcpy(&conn.request_id, pending->header, sizeof(uint16_t));
+    fcntl(pending->sockfd, F_SETFL, fcntl(pending->sockfd, F_GETFL) & ~O_NONBLOCK);
+
+    daemon_submit(daemon_job_create(NULL, &conn, pending->message, pending->length));
+    free(pending->message);
+    return false;
+}
+
+static void *handle_connection(void *unused)
+{
+    (void) unused;
+
+    fcntl(daemon_sockfd, F_SETFL, fcntl(daemon_sockfd, F_GETFL) | O_NONBLOCK);
+
+    struct pending_connection pending[CONNECTION_PENDING_MAX];
+    struct pollfd fds[CONNECTION_PENDING_MAX + 1];
+    int count = 0;
+
+    for (;;) {
+        fds[0] = (struct pollfd) { .fd = daemon_sockfd, .events = count < CONNECTION_PENDING_MAX ? POLLIN : 0 };
+        for (int i = 0; i < count; ++i) {
+            fds[i + 1] = (struct pollfd) { .fd = pending[i].sockfd, .events = POLLIN };
+        }
+
+        if (poll(fds, count + 1, count ? 1000 : -1) == -1) continue;
+
+        uint64_t now = sa_state_now();
+        int kept = 0;
+        for (int i = 0; i < count; ++i) {
+            bool open = true;
+            if (fds[i + 1].revents) {
+                open = pending_connection_read(&pending[i]);
+            } else if (now - pending[i].accepted > CONNECTION_READ_TIMEOUT) {
+                pending_connection_close(&pending[i]);
+                open = false;
+            }
+            if (open) pending[kept++] = pending[i];
+        }
+        count = kept;
+
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        while (count < CONNECTION_PENDING_MAX) {
+            int sockfd = accept(daemon_sockfd, NULL, 0);
+            if (sockfd == -1) break;
+
+            socket_set_nosigpipe(sockfd);
+            fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK);
+            pending[count++] = (struct pending_connection) { .sockfd = sockfd, .accepted = now };
+        }
+    }
+
+    return NULL;
+}
+
+bool daemon_listen(const char *socket_path)
+{
+    struct sockaddr_un socket_address;
+    socket_address.sun_family = AF_UNIX;
+    snprintf(socket_address.sun_path, sizeof(socket_address.sun_path), "%s", socket_path);
+    unlink(socket_path);
+
+    if ((daemon_sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+        return false;
+    }
+
+    if (bind(daemon_sockfd, (struct sockaddr *) &socket_address, sizeof(socket_address)) == -1) {
+        return false;
+    }
+
+    if (chmod(socket_path, 0600) != 0) {
+        return false;
+    }
+
+    if (listen(daemon_sockfd, SOMAXCONN) == -1) {
+        return false;
+    }
+
+    // Clients fall back to requests when there is no state page
+    state_open(socket_path);
+
+    return true;
+}
+
+// Sets up dispatch and animation state; the accept loop and lanes only run if serve is set
+void daemon_start(const struct backend *daemon_backend, bool serve)
+{
+    backend = daemon_backend;
+    pthread_mutex_init(&dock_lock, NULL);
+    pthread_mutex_init(&state_claim_lock, NULL);
+    pthread_mutex_init(&barrier_lock, NULL);
+    pthread_cond_init(&barrier_cond, NULL);
+    pthread_mutex_init(&window_fade_lock, NULL);
+    pthread_cond_init(&window_fade_cond, NULL);
+    pthread_mutex_init(&event_lock, NULL);
+    pthread_cond_init(&event_cond, NULL);
+    pthread_mutex_init(&event_subscriber_lock, NULL);
+    wid_table_init(&event_windows, 64, sizeof(uint32_t));
+    wid_table_init(&window_fade_table, 150, sizeof(struct window_fade_context *));
+    pthread_create(&window_fade_thread, NULL, &window_fade_thread_proc, NULL);
+    state_displays_publish();
+    if (!serve) return;
+
+    pthread_create(&event_thread, NULL, &event_thread_proc, NULL);
+    backend->watch(event_notify);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    lane_count = cpus < 2 ? 2 : cpus > SA_LANE_MAX ? SA_LANE_MAX : (int) cpus;
+    for (int i = 0; i < lane_count; ++i) {
+        pthread_mutex_init(&lanes[i].lock, NULL);
+        pthread_cond_init(&lanes[i].cond, NULL);
+        wid_table_init(&lanes[i].pending, 64, sizeof(struct lane_pending));
+        pthread_create(&lanes[i].thread, NULL, &lane_thread_proc, &lanes[i]);
+    }
+
+    pthread_create(&daemon_thread, NULL, &handle_connection, NULL);
+}
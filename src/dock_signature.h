@@ -0,0 +1,114 @@
+#ifndef DOCK_SIGNATURE_H
+#define DOCK_SIGNATURE_H
+
+//
+// Per-macOS-version Dock signatures. The rows live in src/signatures.txt and
+// are compiled by tools/siggen into dock_signatures.h, which holds one
+// pre-parsed table per architecture (dock_signatures_x86_64 and
+// dock_signatures_arm64). Nothing is parsed at runtime.
+//
+// Requires sigscan.h.
+//
+
+enum dock_symbol
+{
+    DOCK_SYMBOL_SPACES,
+    DOCK_SYMBOL_DPPM,
+    DOCK_SYMBOL_ADD_SPACE,
+    DOCK_SYMBOL_REMOVE_SPACE,
+    DOCK_SYMBOL_MOVE_SPACE,
+    DOCK_SYMBOL_SET_FRONT_WINDOW,
+    DOCK_SYMBOL_FIX_ANIMATION,
+    DOCK_SYMBOL_COUNT
+};
+
+enum dock_version_match
+{
+    DOCK_VERSION_ANY,
+    DOCK_VERSION_EXACT,
+    DOCK_VERSION_AT_LEAST
+};
+
+struct dock_signature
+{
+    int symbol;
+    int major;
+    int minor;
+    int match;
+    uint64_t offset;
+    struct sig_pattern pattern;
+};
+
+extern const char *dock_symbol_name[DOCK_SYMBOL_COUNT];
+
+const struct dock_signature *dock_signature_lookup(const struct dock_signature *table, int count, int symbol, long major, long minor);
+uint64_t decode_adrp_add(uint64_t addr, uint64_t offset);
+
+#endif
+
+#ifdef DOCK_SIGNATURE_IMPLEMENTATION
+const char *dock_symbol_name[DOCK_SYMBOL_COUNT] = {
+    [DOCK_SYMBOL_SPACES]           = "dock.spaces",
+    [DOCK_SYMBOL_DPPM]             = "dppm",
+    [DOCK_SYMBOL_ADD_SPACE]        = "addSpace",
+    [DOCK_SYMBOL_REMOVE_SPACE]     = "removeSpace",
+    [DOCK_SYMBOL_MOVE_SPACE]       = "moveSpace",
+    [DOCK_SYMBOL_SET_FRONT_WINDOW] = "setFrontWindow",
+    [DOCK_SYMBOL_FIX_ANIMATION]    = "animation-time",
+};
+
+//
+// NOTE: An exact minor version beats a "M.N+" row, a "M.N+" row beats a
+// lower one, and a bare major is the fallback.
+//
+const struct dock_signature *dock_signature_lookup(const struct dock_signature *table, int count, int symbol, long major, long minor)
+{
+    const struct dock_signature *result = NULL;
+    int best = -1;
+
+    for (int i = 0; i < count; ++i) {
+        const struct dock_signature *row = &table[i];
+        if (row->symbol != symbol || row->major != major) continue;
+
+        int score = -1;
+        if (row->match == DOCK_VERSION_ANY) {
+            score = 0;
+        } else if (row->match == DOCK_VERSION_AT_LEAST && minor >= row->minor) {
+            score = 1 + row->minor;
+        } else if (row->match == DOCK_VERSION_EXACT && minor == row->minor) {
+            score = 0x10000;
+        }
+
+        if (score > best) {
+            best = score;
+            result = row;
+        }
+    }
+
+    return result;
+}
+
+//
+// Resolves an arm64 ADRP + ADD pair at addr to the address it materialises,
+// relative to the same base as offset (the instruction's own offset).
+//
+uint64_t decode_adrp_add(uint64_t addr, uint64_t offset)
+{
+    uint32_t adrp_instr = *(uint32_t *) addr;
+
+    uint32_t immlo = (0x60000000 & adrp_instr) >> 29;
+    uint32_t immhi = (0xffffe0 & adrp_instr) >> 3;
+
+    int32_t value = (immhi | immlo) << 12;
+    int64_t value_64 = value;
+
+    uint32_t add_instr = *(uint32_t *) (addr + 4);
+    uint64_t imm12 = (add_instr & 0x3ffc00) >> 10;
+
+    if (add_instr & 0xc00000) {
+        imm12 <<= 12;
+    }
+
+    return (offset & 0xfffffffffffff000) + value_64 + imm12;
+}
+#endif
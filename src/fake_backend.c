@@ -0,0 +1,572 @@
+//
+// In-memory compositor implementing struct backend, for running the daemon
+// off a Mac.
+//
+// It keeps the state SkyLight would: per-window frame, alpha, level, tags,
+// ordering and space, and per-display current space. Transactions record
+// their changes and apply them all at once on commit, so a reader never sees
+// half of one. Level keys are mapped like CGWindowLevelForKey(). Changes are
+// reported to the daemon the way SkyLight reports them, for every window
+// rather than a watch list, and fake_user_set_frame() and fake_user_close()
+// change a window behind the daemon's back, like a user dragging or closing
+// it.
+//
+// Include after daemon.c (it relies on wid_table.h and backend.h), then call
+// fake_backend_init() before daemon_start(&fake_backend, ...).
+//
+
+#define FAKE_DISPLAY_MAX 16
+#define FAKE_SPACE_MAX   256
+
+struct fake_window
+{
+    struct backend_rect frame;
+    float alpha;
+    int level;
+    uint64_t tags;
+    bool ordered_in;
+    bool scaled;
+    int z;
+    uint64_t sid;
+};
+
+struct fake_space
+{
+    uint64_t sid;
+    int display;
+};
+
+enum fake_op_kind
+{
+    FAKE_OP_MOVE,
+    FAKE_OP_ALPHA,
+    FAKE_OP_LAYER,
+    FAKE_OP_ORDER
+};
+
+struct fake_op
+{
+    int kind;
+    uint32_t wid;
+    uint32_t rel_wid;
+    int x, y;
+    float alpha;
+};
+
+struct fake_transaction
+{
+    struct fake_op *ops;
+    int count;
+    int capacity;
+};
+
+static pthread_mutex_t fake_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct wid_table fake_windows;
+static struct fake_space fake_spaces[FAKE_SPACE_MAX];
+static int fake_space_count;
+static uint64_t fake_next_sid;
+static uint32_t fake_displays[FAKE_DISPLAY_MAX];
+static uint64_t fake_display_space[FAKE_DISPLAY_MAX];
+static int fake_display_count;
+static int fake_z_top;
+static int fake_z_bottom;
+static uint64_t fake_commit_count;
+static backend_notify_fn fake_notify;
+
+static int fake_level_for_key(int key)
+{
+    static const int levels[] = {
+        INT32_MIN,              // base
+        INT32_MIN + 1,          // minimum
+        INT32_MIN + 1 + 20,     // desktop
+        -20,                    // backstop menu
+        0,                      // normal
+        3,                      // floating
+        3,                      // torn off menu
+        20,                     // dock
+        24,                     // main menu
+        25,                     // status
+        8,                      // modal panel
+        101,                    // pop up menu
+        500,                    // dragging
+        1000,                   // screen saver
+        INT32_MAX - 16,         // maximum
+        102,                    // overlay
+        200,                    // help
+        19,                     // utility
+        INT32_MIN + 1 + 40,     // desktop icon
+        INT32_MAX - 17,         // cursor
+        1500,                   // assistive tech high
+    };
+
+    if (key < 0 || key >= (int)(sizeof(levels) / sizeof(*levels))) return 0;
+    return levels[key];
+}
+
+// Must be called with fake_lock held
+static void fake_report(uint32_t events, uint32_t id, uint64_t sid)
+{
+    if (fake_notify) fake_notify(events, id, sid);
+}
+
+// Must be called with fake_lock held
+static void fake_show_space(int display, uint64_t sid)
+{
+    if (fake_display_space[display] == sid) return;
+    fake_display_space[display] = sid;
+    fake_report(SA_EVENT_SPACE_CHANGED, fake_displays[display], sid);
+}
+
+static struct fake_space *fake_space_find(uint64_t sid)
+{
+    for (int i = 0; i < fake_space_count; ++i) {
+        if (fake_spaces[i].sid == sid) return &fake_spaces[i];
+    }
+    return NULL;
+}
+
+static uint64_t fake_first_space_on(int display, uint64_t except)
+{
+    for (int i = 0; i < fake_space_count; ++i) {
+        if (fake_spaces[i].display == display && fake_spaces[i].sid != except) return fake_spaces[i].sid;
+    }
+    return 0;
+}
+
+// Must be called with fake_lock held
+static void fake_apply_order(struct fake_window *window, int order, uint32_t rel_wid)
+{
+    struct fake_window *relative = rel_wid ? wid_table_find(&fake_windows, rel_wid) : NULL;
+
+    if (order == 0) {
+        window->ordered_in = false;
+    } else if (order > 0) {
+        window->ordered_in = true;
+        window->z = relative ? relative->z + 1 : ++fake_z_top;
+        if (window->z > fake_z_top) fake_z_top = window->z;
+    } else {
+        window->ordered_in = true;
+        window->z = relative ? relative->z - 1 : --fake_z_bottom;
+        if (window->z < fake_z_bottom) fake_z_bottom = window->z;
+    }
+}
+
+// Sets up windows 1..window_count spread across display_count displays, each
+// with spaces_per_display spaces; every window starts on its display's first space
+void fake_backend_init(int window_count, int display_count, int spaces_per_display)
+{
+    pthread_mutex_lock(&fake_lock);
+
+    if (display_count < 1) display_count = 1;
+    if (display_count > FAKE_DISPLAY_MAX) display_count = FAKE_DISPLAY_MAX;
+    if (spaces_per_display < 1) spaces_per_display = 1;
+    if (display_count * spaces_per_display > FAKE_SPACE_MAX) spaces_per_display = FAKE_SPACE_MAX / display_count;
+
+    fake_space_count = 0;
+    fake_next_sid = 1;
+    fake_display_count = display_count;
+    for (int d = 0; d < display_count; ++d) {
+        fake_displays[d] = 0x1000 + d;
+        for (int s = 0; s < spaces_per_display; ++s) {
+            fake_spaces[fake_space_count++] = (struct fake_space) { .sid = fake_next_sid++, .display = d };
+        }
+        fake_display_space[d] = fake_first_space_on(d, 0);
+    }
+
+    if (fake_windows.slots) wid_table_free(&fake_windows);
+    wid_table_init(&fake_windows, window_count, sizeof(struct fake_window));
+
+    fake_z_top = 0;
+    fake_z_bottom = 0;
+    for (int i = 0; i < window_count; ++i) {
+        struct fake_window window = {
+            .frame = { 40.0 * (i % 16), 30.0 * (i % 16), 800, 600 },
+            .alpha = 1.0f,
+            .ordered_in = true,
+            .z = ++fake_z_top,
+            .sid = fake_display_space[i % display_count],
+        };
+        wid_table_add(&fake_windows, (uint32_t)(i + 1), &window);
+    }
+
+    fake_commit_count = 0;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+// Copies the current state of a window; returns false for an unknown wid
+bool fake_window_state(uint32_t wid, struct fake_window *result)
+{
+    pthread_mutex_lock(&fake_lock);
+    struct fake_window *window = wid_table_find(&fake_windows, wid);
+    if (window) *result = *window;
+    pthread_mutex_unlock(&fake_lock);
+    return window != NULL;
+}
+
+uint64_t fake_display_current_space(int display)
+{
+    pthread_mutex_lock(&fake_lock);
+    uint64_t sid = display >= 0 && display < fake_display_count ? fake_display_space[display] : 0;
+    pthread_mutex_unlock(&fake_lock);
+    return sid;
+}
+
+// Moves or resizes a window without going through the daemon
+void fake_user_set_frame(uint32_t wid, struct backend_rect frame)
+{
+    pthread_mutex_lock(&fake_lock);
+    struct fake_window *window = wid_table_find(&fake_windows, wid);
+    if (window) {
+        uint32_t events = 0;
+        if (frame.x != window->frame.x || frame.y != window->frame.y) events |= SA_EVENT_WINDOW_MOVED;
+        if (frame.width != window->frame.width || frame.height != window->frame.height) events |= SA_EVENT_WINDOW_RESIZED;
+        window->frame = frame;
+        if (events) fake_report(events, wid, 0);
+    }
+    pthread_mutex_unlock(&fake_lock);
+}
+
+// Closes a window without going through the daemon
+void fake_user_close(uint32_t wid)
+{
+    pthread_mutex_lock(&fake_lock);
+    if (wid_table_find(&fake_windows, wid)) {
+        wid_table_remove(&fake_windows, wid);
+        fake_report(SA_EVENT_WINDOW_ORDERED | BACKEND_WINDOW_CLOSED, wid, 0);
+    }
+    pthread_mutex_unlock(&fake_lock);
+}
+
+uint64_t fake_commits(void)
+{
+    pthread_mutex_lock(&fake_lock);
+    uint64_t count = fake_commit_count;
+    pthread_mutex_unlock(&fake_lock);
+    return count;
+}
+
+static uint32_t fake_capabilities(void)
+{
+    return OSAX_ATTRIB_ALL;
+}
+
+#define fake_with_window(wid, code) \
+    pthread_mutex_lock(&fake_lock); \
+    struct fake_window *window = wid_table_find(&fake_windows, wid); \
+    if (window) { code; } \
+    pthread_mutex_unlock(&fake_lock)
+
+static void fake_window_get_bounds(uint32_t wid, struct backend_rect *frame)
+{
+    fake_with_window(wid, *frame = window->frame);
+}
+
+static void fake_window_move(uint32_t wid, int x, int y)
+{
+    fake_with_window(wid, window->frame.x = x; window->frame.y = y; fake_report(SA_EVENT_WINDOW_MOVED, wid, 0));
+}
+
+static void fake_window_reassociate(const uint32_t *wids, int count)
+{
+    (void) wids;
+    (void) count;
+}
+
+static void fake_window_scale(uint32_t wid, float dx, float dy, float dw, float dh)
+{
+    (void) dx; (void) dy; (void) dw; (void) dh;
+    fake_with_window(wid, window->scaled = !window->scaled);
+}
+
+static void fake_window_get_alpha(uint32_t wid, float *alpha)
+{
+    fake_with_window(wid, *alpha = window->alpha);
+}
+
+static void fake_window_set_alpha(uint32_t wid, float alpha)
+{
+    fake_with_window(wid, window->alpha = alpha);
+}
+
+static void fake_window_set_layer(uint32_t wid, int layer)
+{
+    fake_with_window(wid, window->level = fake_level_for_key(layer));
+}
+
+static void fake_window_get_level(uint32_t wid, int *level)
+{
+    fake_with_window(wid, *level = window->level);
+}
+
+static void fake_window_set_tags(uint32_t wid, uint64_t tags)
+{
+    fake_with_window(wid, window->tags |= tags);
+}
+
+static void fake_window_clear_tags(uint32_t wid, uint64_t tags)
+{
+    fake_with_window(wid, window->tags &= ~tags);
+}
+
+static uint64_t fake_window_get_tags(uint32_t wid)
+{
+    uint64_t tags = 0;
+    fake_with_window(wid, tags = window->tags);
+    return tags;
+}
+
+static void fake_window_order(uint32_t wid, int order, uint32_t rel_wid)
+{
+    fake_with_window(wid, fake_apply_order(window, order, rel_wid); fake_report(SA_EVENT_WINDOW_ORDERED, wid, 0));
+}
+
+static bool fake_window_is_ordered_in(uint32_t wid)
+{
+    bool ordered_in = true;
+    fake_with_window(wid, ordered_in = window->ordered_in);
+    return ordered_in;
+}
+
+static void fake_window_focus(uint32_t wid)
+{
+    fake_with_window(wid, fake_apply_order(window, 1, 0); fake_report(SA_EVENT_WINDOW_ORDERED, wid, 0));
+}
+
+static void fake_window_move_to_space(const uint32_t *wids, int count, uint64_t sid)
+{
+    pthread_mutex_lock(&fake_lock);
+    if (fake_space_find(sid)) {
+        for (int i = 0; i < count; ++i) {
+            uint32_t wid;
+            memcpy(&wid, wids + i, sizeof(wid));
+
+            struct fake_window *window = wid_table_find(&fake_windows, wid);
+            if (window) window->sid = sid;
+        }
+    }
+    pthread_mutex_unlock(&fake_lock);
+}
+
+static void fake_window_snapshot(const uint32_t *wids, int count, struct sa_window_record *records)
+{
+    pthread_mutex_lock(&fake_lock);
+    for (int i = 0; i < count; ++i) {
+        struct fake_window *window = wid_table_find(&fake_windows, wids[i]);
+        if (!window) {
+            memset(&records[i], 0, sizeof(struct sa_window_record));
+            continue;
+        }
+
+        records[i] = (struct sa_window_record) {
+            .wid = wids[i],
+            .x = (int32_t) window->frame.x,
+            .y = (int32_t) window->frame.y,
+            .width = (int32_t) window->frame.width,
+            .height = (int32_t) window->frame.height,
+            .alpha = window->alpha,
+            .level = window->level,
+            .ordered_in = window->ordered_in,
+            .tags = window->tags,
+        };
+    }
+    pthread_mutex_unlock(&fake_lock);
+}
+
+static void *fake_transaction_create(void)
+{
+    return calloc(1, sizeof(struct fake_transaction));
+}
+
+static void fake_transaction_push(void *transaction, struct fake_op op)
+{
+    struct fake_transaction *t = transaction;
+    if (t->count == t->capacity) {
+        t->capacity = t->capacity ? 2 * t->capacity : 16;
+        t->ops = realloc(t->ops, sizeof(struct fake_op) * t->capacity);
+    }
+    t->ops[t->count++] = op;
+}
+
+static void fake_transaction_move(void *transaction, uint32_t wid, int x, int y)
+{
+    fake_transaction_push(transaction, (struct fake_op) { .kind = FAKE_OP_MOVE, .wid = wid, .x = x, .y = y });
+}
+
+static void fake_transaction_set_alpha(void *transaction, uint32_t wid, float alpha)
+{
+    fake_transaction_push(transaction, (struct fake_op) { .kind = FAKE_OP_ALPHA, .wid = wid, .alpha = alpha });
+}
+
+static void fake_transaction_set_layer(void *transaction, uint32_t wid, int layer)
+{
+    fake_transaction_push(transaction, (struct fake_op) { .kind = FAKE_OP_LAYER, .wid = wid, .x = layer });
+}
+
+static void fake_transaction_order(void *transaction, uint32_t wid, int order, uint32_t rel_wid)
+{
+    fake_transaction_push(transaction, (struct fake_op) { .kind = FAKE_OP_ORDER, .wid = wid, .x = order, .rel_wid = rel_wid });
+}
+
+static void fake_transaction_commit(void *transaction)
+{
+    struct fake_transaction *t = transaction;
+
+    pthread_mutex_lock(&fake_lock);
+    for (int i = 0; i < t->count; ++i) {
+        struct fake_op *op = &t->ops[i];
+        struct fake_window *window = wid_table_find(&fake_windows, op->wid);
+        if (!window) continue;
+
+        switch (op->kind) {
+        case FAKE_OP_MOVE:  window->frame.x = op->x; window->frame.y = op->y; fake_report(SA_EVENT_WINDOW_MOVED, op->wid, 0); break;
+        case FAKE_OP_ALPHA: window->alpha = op->alpha; break;
+        case FAKE_OP_LAYER: window->level = fake_level_for_key(op->x); break;
+        case FAKE_OP_ORDER: fake_apply_order(window, op->x, op->rel_wid); fake_report(SA_EVENT_WINDOW_ORDERED, op->wid, 0); break;
+        }
+    }
+    ++fake_commit_count;
+    pthread_mutex_unlock(&fake_lock);
+
+    free(t->ops);
+    free(t);
+}
+
+static void fake_space_focus(uint64_t sid)
+{
+    pthread_mutex_lock(&fake_lock);
+    struct fake_space *space = fake_space_find(sid);
+    if (space) fake_show_space(space->display, sid);
+    pthread_mutex_unlock(&fake_lock);
+}
+
+// sid names an existing space; the new one is added to the same display
+static void fake_space_create(uint64_t sid)
+{
+    pthread_mutex_lock(&fake_lock);
+    struct fake_space *space = fake_space_find(sid);
+    if (space && fake_space_count < FAKE_SPACE_MAX) {
+        fake_spaces[fake_space_count++] = (struct fake_space) { .sid = fake_next_sid++, .display = space->display };
+        fake_report(SA_EVENT_DISPLAY_CHANGED, fake_displays[space->display], 0);
+    }
+    pthread_mutex_unlock(&fake_lock);
+}
+
+static void fake_space_destroy(uint64_t sid)
+{
+    pthread_mutex_lock(&fake_lock);
+    struct fake_space *space = fake_space_find(sid);
+    uint64_t fallback = space ? fake_first_space_on(space->display, sid) : 0;
+
+    if (space && fallback) {
+        int display = space->display;
+        *space = fake_spaces[--fake_space_count];
+
+        if (fake_display_space[display] == sid) fake_show_space(display, fallback);
+        fake_report(SA_EVENT_DISPLAY_CHANGED, fake_displays[display], 0);
+
+        wid_table_for(slot, fake_windows) {
+            struct fake_window *window = wid_slot_value(slot);
+            if (window->sid == sid) window->sid = fallback;
+        }
+    }
+    pthread_mutex_unlock(&fake_lock);
+}
+
+static void fake_space_move(uint64_t sid, uint64_t dest_sid, uint64_t prev_sid, bool focus)
+{
+    pthread_mutex_lock(&fake_lock);
+    struct fake_space *space = fake_space_find(sid);
+    struct fake_space *dest = fake_space_find(dest_sid);
+
+    if (space && dest && space->display != dest->display) {
+        int source_display = space->display;
+        uint64_t fallback = fake_first_space_on(source_display, sid);
+
+        if (fallback) {
+            if (prev_sid && fake_space_find(prev_sid)) {
+                fake_show_space(source_display, prev_sid);
+            } else if (fake_display_space[source_display] == sid) {
+                fake_show_space(source_display, fallback);
+            }
+
+            space->display = dest->display;
+            if (focus) fake_show_space(dest->display, sid);
+            fake_report(SA_EVENT_DISPLAY_CHANGED, fake_displays[source_display], 0);
+            fake_report(SA_EVENT_DISPLAY_CHANGED, fake_displays[dest->display], 0);
+        }
+    }
+    pthread_mutex_unlock(&fake_lock);
+}
+
+static uint32_t fake_display_list(uint32_t *ids, uint32_t max)
+{
+    pthread_mutex_lock(&fake_lock);
+    uint32_t count = fake_display_count;
+    if (ids) {
+        for (uint32_t i = 0; i < count && i < max; ++i) ids[i] = fake_displays[i];
+        if (count > max) count = max;
+    }
+    pthread_mutex_unlock(&fake_lock);
+    return count;
+}
+
+static uint64_t fake_display_space_for(uint32_t did)
+{
+    pthread_mutex_lock(&fake_lock);
+    uint64_t sid = 0;
+    for (int i = 0; i < fake_display_count; ++i) {
+        if (fake_displays[i] == did) sid = fake_display_space[i];
+    }
+    pthread_mutex_unlock(&fake_lock);
+    return sid;
+}
+
+static void fake_watch(backend_notify_fn notify)
+{
+    pthread_mutex_lock(&fake_lock);
+    fake_notify = notify;
+    pthread_mutex_unlock(&fake_lock);
+}
+
+// Every window is reported, watched or not
+static void fake_watch_windows(const uint32_t *wids, int count)
+{
+    (void) wids;
+    (void) count;
+}
+
+static const struct backend fake_backend = {
+    .name                        = "fake",
+    .capabilities                = fake_capabilities,
+    .window_get_bounds           = fake_window_get_bounds,
+    .window_move                 = fake_window_move,
+    .window_reassociate          = fake_window_reassociate,
+    .window_scale                = fake_window_scale,
+    .window_get_alpha            = fake_window_get_alpha,
+    .window_set_alpha            = fake_window_set_alpha,
+    .window_set_layer            = fake_window_set_layer,
+    .window_get_level            = fake_window_get_level,
+    .window_set_tags             = fake_window_set_tags,
+    .window_clear_tags           = fake_window_clear_tags,
+    .window_get_tags             = fake_window_get_tags,
+    .window_order                = fake_window_order,
+    .window_is_ordered_in        = fake_window_is_ordered_in,
+    .window_focus                = fake_window_focus,
+    .window_move_to_space        = fake_window_move_to_space,
+    .window_snapshot             = fake_window_snapshot,
+    .transaction_create          = fake_transaction_create,
+    .transaction_move            = fake_transaction_move,
+    .transaction_set_alpha       = fake_transaction_set_alpha,
+    .transaction_set_layer       = fake_transaction_set_layer,
+    .transaction_order           = fake_transaction_order,
+    .transaction_order_group     = fake_transaction_order,
+    .transaction_commit          = fake_transaction_commit,
+    .space_focus                 = fake_space_focus,
+    .space_create                = fake_space_create,
+    .space_destroy               = fake_space_destroy,
+    .space_move                  = fake_space_move,
+    .display_list                = fake_display_list,
+    .display_space               = fake_display_space_for,
+    .watch                       = fake_watch,
+    .watch_windows               = fake_watch_windows,
+};
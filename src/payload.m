@@ -1,4 +1,5 @@
 #include <Foundation/Foundation.h>
+#include <AppKit/AppKit.h>
 
 #include <mach-o/getsect.h>
 #include <mach-o/dyld.h>
@@ -20,11 +21,15 @@
 #include <dlfcn.h>
 
 #include <pthread.h>
+#include <fcntl.h>
+#include <time.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
 #include "common.h"
+#include "util.h"
+#include "daemon.c"
 
 #ifdef __x86_64__
 #include "x64_payload.m"
@@ -33,14 +38,16 @@
 #include <ptrauth.h>
 #endif
 
-#define HASHTABLE_IMPLEMENTATION
-#include "hashtable.h"
-#undef HASHTABLE_IMPLEMENTATION
+#define SIGSCAN_IMPLEMENTATION
+#include "sigscan.h"
+#undef SIGSCAN_IMPLEMENTATION
+
+#define DOCK_SIGNATURE_IMPLEMENTATION
+#include "dock_signature.h"
+#undef DOCK_SIGNATURE_IMPLEMENTATION
+#include "dock_signatures.h"
 
-#define SOCKET_PATH_FMT "/tmp/mss_%s.socket"
 #define page_align(addr) (vm_address_t)((uintptr_t)(addr) & (~(vm_page_size - 1)))
-#define unpack(v) memcpy(&v, message, sizeof(v)); message += sizeof(v)
-#define lerp(a, t, b) (((1.0-t)*a) + (t*b))
 
 extern int SLSMainConnectionID(void);
 extern CGError SLSGetConnectionPSN(int cid, ProcessSerialNumber *psn);
@@ -61,6 +68,9 @@ extern CGError SLSWindowIsOrderedIn(int cid, uint32_t wid, bool *result);
 extern void SLSManagedDisplaySetCurrentSpace(int cid, CFStringRef display_ref, uint64_t sid);
 extern uint64_t SLSManagedDisplayGetCurrentSpace(int cid, CFStringRef display_ref);
 extern CFStringRef SLSCopyManagedDisplayForSpace(int cid, uint64_t sid);
+extern CFUUIDRef CGDisplayCreateUUIDFromDisplayID(uint32_t did);
+extern CGError SLSRegisterConnectionNotifyProc(int cid, void (*handler)(uint32_t event, void *data, size_t data_length, void *context), uint32_t event, void *context);
+extern CGError SLSRequestNotificationsForWindows(int cid, uint32_t *window_list, int window_count);
 extern void SLSMoveWindowsToManagedSpace(int cid, CFArrayRef window_list, uint64_t sid);
 extern void SLSShowSpaces(int cid, CFArrayRef space_list);
 extern void SLSHideSpaces(int cid, CFArrayRef space_list);
@@ -69,18 +79,9 @@ extern CGError SLSTransactionCommit(CFTypeRef transaction, int synchronous);
 extern CGError SLSTransactionOrderWindowGroup(CFTypeRef transaction, uint32_t wid, int order, uint32_t rel_wid);
 extern CGError SLSTransactionSetWindowSystemAlpha(CFTypeRef transaction, uint32_t wid, float alpha);
 extern CGError SLSSetWindowSubLevel(int cid, uint32_t wid, int level);
-
-struct window_fade_context
-{
-    pthread_t thread;
-    uint32_t wid;
-    volatile float alpha;
-    volatile float duration;
-    volatile bool skip;
-};
-
-pthread_mutex_t window_fade_lock;
-struct table window_fade_table;
+extern CGError SLSTransactionMoveWindowWithGroup(CFTypeRef transaction, uint32_t wid, CGPoint point) __attribute__((weak_import));
+extern CGError SLSTransactionOrderWindow(CFTypeRef transaction, uint32_t wid, int order, uint32_t rel_wid) __attribute__((weak_import));
+extern CGError SLSTransactionSetWindowSubLevel(CFTypeRef transaction, uint32_t wid, int level) __attribute__((weak_import));
 
 static id dock_spaces;
 static id dp_desktop_picture_manager;
@@ -91,9 +92,6 @@ static uint64_t set_front_window_fp;
 static uint64_t animation_time_addr;
 static bool macOSSequoia;
 
-static pthread_t daemon_thread;
-static int daemon_sockfd;
-
 static void dump_class_info(Class c)
 {
     const char *name = class_getName(c);
@@ -158,69 +156,232 @@ static uint64_t image_slide(void)
     return 0;
 }
 
-static uint64_t hex_find_seq(uint64_t baddr, const char *c_pattern)
+static bool image_uuid(uint8_t *uuid)
 {
-    if (!baddr || !c_pattern) return 0;
-
-    uint64_t addr = baddr;
-    uint64_t pattern_length = (strlen(c_pattern) + 1) / 3;
-    char buffer_a[pattern_length];
-    char buffer_b[pattern_length];
-    memset(buffer_a, 0, sizeof(buffer_a));
-    memset(buffer_b, 0, sizeof(buffer_b));
+    char path[1024];
+    uint32_t size = sizeof(path);
 
-    char *pattern = (char *) c_pattern + 1;
-    for (int i = 0; i < pattern_length; ++i) {
-        char c = pattern[-1];
-        if (c == '?') {
-            buffer_b[i] = 1;
-        } else {
-            int temp = c <= '9' ? 0 : 9;
-            temp = (temp + c) << 0x4;
-            c = pattern[0];
-            int temp2 = c <= '9' ? 0xd0 : 0xc9;
-            buffer_a[i] = temp2 + c + temp;
-        }
-        pattern += 3;
+    if (_NSGetExecutablePath(path, &size) != 0) {
+        return false;
     }
 
-loop:
-    for (int counter = 0; counter < pattern_length; ++counter) {
-        if ((buffer_b[counter] == 0) && (((char *)addr)[counter] != buffer_a[counter])) {
-            addr = (uint64_t)((char *)addr + 1);
-            if (addr - baddr < 0x1286a0) {
-                goto loop;
-            } else {
-                return 0;
+    for (uint32_t i = 0; i < _dyld_image_count(); i++) {
+        if (strcmp(_dyld_get_image_name(i), path) != 0) continue;
+
+        const struct mach_header_64 *header = (const struct mach_header_64 *) _dyld_get_image_header(i);
+        const struct load_command *command = (const struct load_command *)(header + 1);
+
+        for (uint32_t j = 0; j < header->ncmds; ++j) {
+            if (command->cmd == LC_UUID) {
+                memcpy(uuid, ((const struct uuid_command *) command)->uuid, 16);
+                return true;
             }
+            command = (const struct load_command *)((const char *) command + command->cmdsize);
         }
+
+        return false;
     }
 
-    return addr;
+    return false;
 }
 
-#if __arm64__
-uint64_t decode_adrp_add(uint64_t addr, uint64_t offset)
+//
+// Resolved signature sites are cached on disk as offsets from the slid image
+// base, keyed by the Dock executable's LC_UUID, the macOS version, the
+// payload version and the architecture. The ADRP/ADD decoding that follows is
+// derived from these sites, so caching them covers it too.
+//
+
+#define SYMBOL_CACHE_MAGIC 0x6d737363
+
+#ifdef __x86_64__
+#define SYMBOL_CACHE_ARCH "x86_64"
+#elif __arm64__
+#define SYMBOL_CACHE_ARCH "arm64"
+#endif
+
+struct symbol_cache
 {
-    uint32_t adrp_instr = *(uint32_t *) addr;
+    uint32_t magic;
+    uint32_t count;
+    uint8_t uuid[16];
+    int64_t os_version[3];
+    char osax_version[16];
+    char arch[8];
+    int64_t offsets[DOCK_SYMBOL_COUNT];
+};
 
-    uint32_t immlo = (0x60000000 & adrp_instr) >> 29;
-    uint32_t immhi = (0xffffe0 & adrp_instr) >> 3;
+static NSString *symbol_cache_path(void)
+{
+    NSArray *paths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
+    if (![paths count]) return nil;
+
+    return [NSString stringWithFormat:@"%@/com.mss.payload/symbols-%s.cache", paths[0], SYMBOL_CACHE_ARCH];
+}
+
+static bool symbol_cache_key(struct symbol_cache *cache, NSOperatingSystemVersion os_version)
+{
+    memset(cache, 0, sizeof(struct symbol_cache));
+    if (!image_uuid(cache->uuid)) return false;
+
+    cache->magic = SYMBOL_CACHE_MAGIC;
+    cache->count = DOCK_SYMBOL_COUNT;
+    cache->os_version[0] = os_version.majorVersion;
+    cache->os_version[1] = os_version.minorVersion;
+    cache->os_version[2] = os_version.patchVersion;
+    snprintf(cache->osax_version, sizeof(cache->osax_version), "%s", OSAX_VERSION);
+    snprintf(cache->arch, sizeof(cache->arch), "%s", SYMBOL_CACHE_ARCH);
+    return true;
+}
 
-    int32_t value = (immhi | immlo) << 12;
-    int64_t value_64 = value;
+static bool symbol_cache_load(struct symbol_cache *cache)
+{
+    NSString *path = symbol_cache_path();
+    if (!path) return false;
+
+    int fd = open([path fileSystemRepresentation], O_RDONLY);
+    if (fd == -1) return false;
 
-    uint32_t add_instr = *(uint32_t *) (addr + 4);
-    uint64_t imm12 = (add_instr & 0x3ffc00) >> 10;
+    struct symbol_cache stored;
+    bool valid = read(fd, &stored, sizeof(stored)) == sizeof(stored) &&
+                 memcmp(&stored, cache, offsetof(struct symbol_cache, offsets)) == 0;
+    close(fd);
 
-    if (add_instr & 0xc00000) {
-        imm12 <<= 12;
+    if (!valid) {
+        NSLog(@"[mss] symbol cache is stale or belongs to another Dock build");
+        return false;
     }
 
-    return (offset & 0xfffffffffffff000) + value_64 + imm12;
+    memcpy(cache->offsets, stored.offsets, sizeof(cache->offsets));
+    return true;
 }
+
+static void symbol_cache_save(struct symbol_cache *cache)
+{
+    NSString *path = symbol_cache_path();
+    if (!path) return;
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+
+    char tmp_path[PATH_MAX];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d", [path fileSystemRepresentation], getpid());
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1) return;
+
+    bool written = write(fd, cache, sizeof(struct symbol_cache)) == sizeof(struct symbol_cache);
+    close(fd);
+
+    if (!written || rename(tmp_path, [path fileSystemRepresentation]) != 0) {
+        unlink(tmp_path);
+        NSLog(@"[mss] failed to write symbol cache");
+    }
+}
+
+//
+// NOTE: Every signature is searched for over a window of 0x1286a0 candidate
+// offsets starting at its per-version offset. Many of these windows overlap,
+// so all of them are resolved together in a single sweep (see sigscan.h).
+// This runs inside the Dock's constructor before the socket is listening.
+//
+static inline bool symbol_cache_in_window(const struct sig_target *target, int64_t offset)
+{
+    return offset >= 0 && (uint64_t) offset >= target->offset && (uint64_t) offset < target->offset + target->window;
+}
+
+static void resolve_dock_symbols(NSOperatingSystemVersion os_version, uint64_t baseaddr, uint64_t *addrs)
+{
+#ifdef __x86_64__
+    const struct dock_signature *table = dock_signatures_x86_64;
+    int table_count = sizeof(dock_signatures_x86_64) / sizeof(*dock_signatures_x86_64);
+#elif __arm64__
+    const struct dock_signature *table = dock_signatures_arm64;
+    int table_count = sizeof(dock_signatures_arm64) / sizeof(*dock_signatures_arm64);
 #endif
 
+    struct sig_target targets[DOCK_SYMBOL_COUNT];
+    memset(targets, 0, sizeof(targets));
+
+    for (int i = 0; i < DOCK_SYMBOL_COUNT; ++i) {
+        const struct dock_signature *signature = dock_signature_lookup(table, table_count, i, os_version.majorVersion, os_version.minorVersion);
+        targets[i].name = dock_symbol_name[i];
+
+        if (signature) {
+            targets[i].offset = signature->offset;
+            targets[i].window = 0x1286a0;
+            targets[i].sig = signature->pattern;
+        } else {
+            NSLog(@"[mss] no signature for %s on this macOS version", targets[i].name);
+        }
+    }
+
+    struct symbol_cache cache;
+    bool cached = symbol_cache_key(&cache, os_version) && symbol_cache_load(&cache);
+
+    //
+    // NOTE: The cache file is user-writable, so a cached site is trusted only
+    // if it lies inside the symbol's search window, which the scan guarantees
+    // is mapped, and the bytes there still match the signature. Anything that
+    // fails the check is re-scanned, and the cache is rewritten whenever a
+    // scan was needed.
+    //
+
+    struct sig_target stale[DOCK_SYMBOL_COUNT];
+    int stale_symbol[DOCK_SYMBOL_COUNT];
+    int stale_count = 0;
+
+    for (int i = 0; i < DOCK_SYMBOL_COUNT; ++i) {
+        if (cached && cache.offsets[i] == -1) {
+            targets[i].hit = -1;
+        } else if (cached && symbol_cache_in_window(&targets[i], cache.offsets[i]) && sig_match(&targets[i].sig, (const uint8_t *) baseaddr + cache.offsets[i])) {
+            targets[i].hit = cache.offsets[i];
+        } else {
+            stale_symbol[stale_count] = i;
+            stale[stale_count++] = targets[i];
+        }
+    }
+
+    if (stale_count) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t swept = sig_scan_all(stale, stale_count, (const uint8_t *) baseaddr);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double elapsed = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+        NSLog(@"[mss] swept 0x%llx bytes of address range for %d signatures in %.2fms", swept, stale_count, elapsed);
+
+        for (int i = 0; i < stale_count; ++i) {
+            targets[stale_symbol[i]].hit = stale[i].hit;
+        }
+
+        //
+        // NOTE: A site that was cached but no longer matches is most likely one
+        // this Dock process already patched (payload injected twice), so keep
+        // the old offset rather than recording a miss for the next launch.
+        //
+
+        for (int i = 0; i < DOCK_SYMBOL_COUNT; ++i) {
+            if (!cached || targets[i].hit != -1) cache.offsets[i] = targets[i].hit;
+        }
+
+        if (cache.magic) symbol_cache_save(&cache);
+    } else {
+        NSLog(@"[mss] symbol cache validated all %d signature sites", DOCK_SYMBOL_COUNT);
+    }
+
+    for (int i = 0; i < DOCK_SYMBOL_COUNT; ++i) {
+        if (targets[i].hit == -1) {
+            addrs[i] = 0;
+        } else {
+            addrs[i] = baseaddr + targets[i].hit;
+            NSLog(@"[mss] %s signature hit at +0x%llx (window +0x%llx)", targets[i].name, targets[i].hit, targets[i].offset);
+        }
+    }
+}
+
 static bool verify_os_version(NSOperatingSystemVersion os_version)
 {
     NSLog(@"[mss] checking for macOS %ld.%ld.%ld compatibility!", os_version.majorVersion, os_version.minorVersion, os_version.patchVersion);
@@ -275,7 +436,10 @@ static void init_instances()
 
     uint64_t baseaddr = static_base_address() + image_slide();
 
-    uint64_t dock_spaces_addr = hex_find_seq(baseaddr + get_dock_spaces_offset(os_version), get_dock_spaces_pattern(os_version));
+    uint64_t addrs[DOCK_SYMBOL_COUNT];
+    resolve_dock_symbols(os_version, baseaddr, addrs);
+
+    uint64_t dock_spaces_addr = addrs[DOCK_SYMBOL_SPACES];
     if (dock_spaces_addr == 0) {
         dock_spaces = nil;
         NSLog(@"[mss] could not locate pointer to dock.spaces! spaces functionality will not work!");
@@ -291,7 +455,7 @@ static void init_instances()
 #endif
     }
 
-    uint64_t dppm_addr = hex_find_seq(baseaddr + get_dppm_offset(os_version), get_dppm_pattern(os_version));
+    uint64_t dppm_addr = addrs[DOCK_SYMBOL_DPPM];
     if (dppm_addr == 0) {
         dp_desktop_picture_manager = nil;
         NSLog(@"[mss] could not locate pointer to dppm! moving spaces will not work!");
@@ -327,7 +491,7 @@ static void init_instances()
 #endif
     }
 
-    uint64_t add_space_addr = hex_find_seq(baseaddr + get_add_space_offset(os_version), get_add_space_pattern(os_version));
+    uint64_t add_space_addr = addrs[DOCK_SYMBOL_ADD_SPACE];
     if (add_space_addr == 0x0) {
         NSLog(@"[mss] failed to get pointer to addSpace function..");
         add_space_fp = 0;
@@ -340,7 +504,7 @@ static void init_instances()
 #endif
     }
 
-    uint64_t remove_space_addr = hex_find_seq(baseaddr + get_remove_space_offset(os_version), get_remove_space_pattern(os_version));
+    uint64_t remove_space_addr = addrs[DOCK_SYMBOL_REMOVE_SPACE];
     if (remove_space_addr == 0x0) {
         NSLog(@"[mss] failed to get pointer to removeSpace function..");
         remove_space_fp = 0;
@@ -353,7 +517,7 @@ static void init_instances()
 #endif
     }
 
-    uint64_t move_space_addr = hex_find_seq(baseaddr + get_move_space_offset(os_version), get_move_space_pattern(os_version));
+    uint64_t move_space_addr = addrs[DOCK_SYMBOL_MOVE_SPACE];
     if (move_space_addr == 0x0) {
         NSLog(@"[mss] failed to get pointer to moveSpace function..");
         move_space_fp = 0;
@@ -366,7 +530,7 @@ static void init_instances()
 #endif
     }
 
-    uint64_t set_front_window_addr = hex_find_seq(baseaddr + get_set_front_window_offset(os_version), get_set_front_window_pattern(os_version));
+    uint64_t set_front_window_addr = addrs[DOCK_SYMBOL_SET_FRONT_WINDOW];
     if (set_front_window_addr == 0x0) {
         NSLog(@"[mss] failed to get pointer to setFrontWindow function..");
         set_front_window_fp = 0;
@@ -379,7 +543,7 @@ static void init_instances()
 #endif
     }
 
-    animation_time_addr = hex_find_seq(baseaddr + get_fix_animation_offset(os_version), get_fix_animation_pattern(os_version));
+    animation_time_addr = addrs[DOCK_SYMBOL_FIX_ANIMATION];
     if (animation_time_addr == 0x0) {
         NSLog(@"[mss] failed to get pointer to animation-time..");
     } else {
@@ -414,193 +578,211 @@ static inline uint64_t get_space_id(id space)
     return ((uint64_t (*)(id, SEL)) objc_msgSend)(space, @selector(spid));
 }
 
-static inline id space_for_display_with_id(CFStringRef display_uuid, uint64_t space_id)
+//
+// NOTE: Space operations look spaces up by id many times per call, so the
+// payload keeps an index from space id to the Dock's space object, the UUID
+// of its display and that display's DisplaySpace, instead of walking
+// spacesForDisplay: and _displaySpaces each time. It is rebuilt from those
+// on the first lookup after it goes stale: when the payload creates or
+// destroys a space and when SkyLight reports spaces created, destroyed or
+// displays reconfigured. Moving a space updates its entry in place. A
+// lookup whose display does not match what SkyLight reports rebuilds once
+// before giving up, so a change nobody reported costs one rebuild.
+//
+// The index retains what it holds, and is only read and rebuilt by space
+// operations, which the daemon serialises on dock_lock; the stale flag is
+// the one thing other threads touch.
+//
+
+struct space_entry
 {
-    NSArray *spaces_for_display = ((NSArray *(*)(id, SEL, CFStringRef)) objc_msgSend)(dock_spaces, @selector(spacesForDisplay:), display_uuid);
-    for (id space in spaces_for_display) {
-        if (space_id == get_space_id(space)) {
-            return space;
-        }
-    }
-    return nil;
+    uint64_t sid;               // 0 while the slot is free
+    id space;
+    id display_space;
+    CFStringRef display_uuid;
+};
+
+static struct space_entry *space_index;
+static uint32_t space_index_capacity;  // A power of two
+static uint32_t space_index_count;
+static bool space_index_stale = true;
+
+static inline void space_index_invalidate(void)
+{
+    __atomic_store_n(&space_index_stale, true, __ATOMIC_RELEASE);
 }
 
-static inline id display_space_for_display_uuid(CFStringRef display_uuid)
+static inline struct space_entry *space_index_slot(uint64_t sid)
 {
-    id result = nil;
+    uint32_t mask = space_index_capacity - 1;
+    uint32_t pos = (uint32_t)((sid * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (space_index[pos].sid && space_index[pos].sid != sid) pos = (pos + 1) & mask;
+    return &space_index[pos];
+}
 
-    NSArray *display_spaces = get_ivar_value(dock_spaces, "_displaySpaces");
-    if (display_spaces != nil) {
-        for (id display_space in display_spaces) {
-            id display_source_space = get_ivar_value(display_space, "_currentSpace");
-            uint64_t sid = get_space_id(display_source_space);
-            CFStringRef uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), sid);
-            bool match = CFEqual(uuid, display_uuid);
-            CFRelease(uuid);
-            if (match) {
-                result = display_space;
-                break;
-            }
+static void space_index_insert(uint64_t sid, id space, id display_space, CFStringRef display_uuid)
+{
+    if (2 * (space_index_count + 1) > space_index_capacity) {
+        struct space_entry *old = space_index;
+        uint32_t old_capacity = space_index_capacity;
+
+        space_index_capacity = old_capacity ? 2 * old_capacity : 64;
+        space_index = calloc(space_index_capacity, sizeof(struct space_entry));
+        for (uint32_t i = 0; i < old_capacity; ++i) {
+            if (old[i].sid) *space_index_slot(old[i].sid) = old[i];
         }
+        free(old);
     }
 
-    return result;
+    struct space_entry *entry = space_index_slot(sid);
+    if (entry->sid) return;
+
+    *entry = (struct space_entry) {
+        .sid = sid,
+        .space = [space retain],
+        .display_space = [display_space retain],
+        .display_uuid = CFRetain(display_uuid),
+    };
+    ++space_index_count;
 }
 
-static inline id display_space_for_space_with_id(uint64_t space_id)
+static void space_index_build(void)
 {
+    __atomic_store_n(&space_index_stale, false, __ATOMIC_RELAXED);
+
+    for (uint32_t i = 0; i < space_index_capacity; ++i) {
+        struct space_entry *entry = &space_index[i];
+        if (!entry->sid) continue;
+        [entry->space release];
+        [entry->display_space release];
+        CFRelease(entry->display_uuid);
+        *entry = (struct space_entry) {};
+    }
+    space_index_count = 0;
+
     NSArray *display_spaces = get_ivar_value(dock_spaces, "_displaySpaces");
-    if (display_spaces != nil) {
-        for (id display_space in display_spaces) {
-            id display_source_space = get_ivar_value(display_space, "_currentSpace");
-            if (get_space_id(display_source_space) == space_id) {
-                return display_space;
-            }
+    for (id display_space in display_spaces) {
+        id current_space = get_ivar_value(display_space, "_currentSpace");
+        CFStringRef uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), get_space_id(current_space));
+        if (!uuid) continue;
+
+        NSArray *spaces = ((NSArray *(*)(id, SEL, CFStringRef)) objc_msgSend)(dock_spaces, @selector(spacesForDisplay:), uuid);
+        for (id space in spaces) {
+            space_index_insert(get_space_id(space), space, display_space, uuid);
         }
+        CFRelease(uuid);
     }
-    return nil;
 }
 
-static void do_space_move(char *message)
+// Returns the entry of a space on the display with display_uuid, or NULL
+static struct space_entry *space_index_find(CFStringRef display_uuid, uint64_t space_id)
 {
-    if (dock_spaces == nil || dp_desktop_picture_manager == nil || move_space_fp == 0) return;
+    if (dock_spaces == nil || !display_uuid || !space_id) return NULL;
 
-    uint64_t source_space_id, dest_space_id, source_prev_space_id;
-    unpack(source_space_id);
-    unpack(dest_space_id);
-    unpack(source_prev_space_id);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (attempt || __atomic_load_n(&space_index_stale, __ATOMIC_ACQUIRE) || !space_index) space_index_build();
+        if (!space_index) return NULL;
 
-    bool focus_dest_space;
-    unpack(focus_dest_space);
-
-    CFStringRef source_display_uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), source_space_id);
-    id source_space = space_for_display_with_id(source_display_uuid, source_space_id);
-    id source_display_space = display_space_for_display_uuid(source_display_uuid);
-
-    CFStringRef dest_display_uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), dest_space_id);
-    id dest_space = space_for_display_with_id(dest_display_uuid, dest_space_id);
-    unsigned dest_display_id = ((unsigned (*)(id, SEL, id)) objc_msgSend)(dock_spaces, @selector(displayIDForSpace:), dest_space);
-    id dest_display_space = display_space_for_display_uuid(dest_display_uuid);
-
-    if (source_prev_space_id) {
-        NSArray *ns_source_space = @[ @(source_space_id) ];
-        NSArray *ns_dest_space = @[ @(source_prev_space_id) ];
-        id new_source_space = space_for_display_with_id(source_display_uuid, source_prev_space_id);
-        SLSShowSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_dest_space);
-        SLSHideSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_source_space);
-        SLSManagedDisplaySetCurrentSpace(SLSMainConnectionID(), source_display_uuid, source_prev_space_id);
-        set_ivar_value(source_display_space, "_currentSpace", [new_source_space retain]);
-        [ns_dest_space release];
-        [ns_source_space release];
+        struct space_entry *entry = space_index_slot(space_id);
+        if (entry->sid == space_id && CFEqual(entry->display_uuid, display_uuid)) return entry;
     }
 
-    asm__call_move_space(source_space, dest_space, dest_display_uuid, dock_spaces, move_space_fp);
+    return NULL;
+}
 
-    dispatch_sync(dispatch_get_main_queue(), ^{
-        ((void (*)(id, SEL, id, unsigned, CFStringRef)) objc_msgSend)(dp_desktop_picture_manager, @selector(moveSpace:toDisplay:displayUUID:), source_space, dest_display_id, dest_display_uuid);
-    });
+// Records that a space now belongs to another display
+static void space_index_move(uint64_t space_id, id display_space, CFStringRef display_uuid)
+{
+    if (!space_index) return;
 
-    if (focus_dest_space) {
-        uint64_t new_source_space_id = SLSManagedDisplayGetCurrentSpace(SLSMainConnectionID(), source_display_uuid);
-        id new_source_space = space_for_display_with_id(source_display_uuid, new_source_space_id);
-        set_ivar_value(source_display_space, "_currentSpace", [new_source_space retain]);
+    struct space_entry *entry = space_index_slot(space_id);
+    if (entry->sid != space_id) return;
 
-        NSArray *ns_dest_monitor_space = @[ @(dest_space_id) ];
-        SLSHideSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_dest_monitor_space);
-        SLSManagedDisplaySetCurrentSpace(SLSMainConnectionID(), dest_display_uuid, source_space_id);
-        set_ivar_value(dest_display_space, "_currentSpace", [source_space retain]);
-        [ns_dest_monitor_space release];
-    }
+    [display_space retain];
+    [entry->display_space release];
+    entry->display_space = display_space;
 
-    CFRelease(source_display_uuid);
-    CFRelease(dest_display_uuid);
+    CFRetain(display_uuid);
+    CFRelease(entry->display_uuid);
+    entry->display_uuid = display_uuid;
 }
 
-typedef void (*remove_space_call)(id space, id display_space, id dock_spaces, uint64_t space_id1, uint64_t space_id2);
-static void do_space_destroy(char *message)
+static inline id space_for_display_with_id(CFStringRef display_uuid, uint64_t space_id)
 {
-    if (dock_spaces == nil || remove_space_fp == 0) return;
+    struct space_entry *entry = space_index_find(display_uuid, space_id);
+    return entry ? entry->space : nil;
+}
 
-    uint64_t space_id;
-    unpack(space_id);
+// The DisplaySpace of the display showing space_id, which is on display_uuid
+static inline id display_space_for_space(CFStringRef display_uuid, uint64_t space_id)
+{
+    struct space_entry *entry = space_index_find(display_uuid, space_id);
+    return entry ? entry->display_space : nil;
+}
 
-    CFStringRef display_uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), space_id);
-    uint64_t active_space_id = SLSManagedDisplayGetCurrentSpace(SLSMainConnectionID(), display_uuid);
+// ============================================================================
+// SkyLight backend
+// ============================================================================
 
-    id space = space_for_display_with_id(display_uuid, space_id);
-    id display_space = display_space_for_display_uuid(display_uuid);
+static inline CFArrayRef cfarray_of_cfnumbers(const void *values, size_t size, int count, CFNumberType type)
+{
+    CFNumberRef temp[count];
 
-    dispatch_sync(dispatch_get_main_queue(), ^{
-        ((remove_space_call) remove_space_fp)(space, display_space, dock_spaces, space_id, space_id);
-    });
+    for (int i = 0; i < count; ++i) {
+        temp[i] = CFNumberCreate(NULL, type, ((const char *)values) + (size * i));
+    }
 
-    if (active_space_id == space_id) {
-        uint64_t dest_space_id = SLSManagedDisplayGetCurrentSpace(SLSMainConnectionID(), display_uuid);
-        id dest_space = space_for_display_with_id(display_uuid, dest_space_id);
-        set_ivar_value(display_space, "_currentSpace", [dest_space retain]);
+    CFArrayRef result = CFArrayCreate(NULL, (const void **)temp, count, &kCFTypeArrayCallBacks);
+
+    for (int i = 0; i < count; ++i) {
+        CFRelease(temp[i]);
     }
 
-    CFRelease(display_uuid);
+    return result;
 }
 
-static void do_space_create(char *message)
+static uint32_t skylight_capabilities(void)
 {
-    if (dock_spaces == nil || add_space_fp == 0) return;
+    uint32_t attrib = 0;
 
-    uint64_t space_id;
-    unpack(space_id);
+    if (dock_spaces != nil)                attrib |= OSAX_ATTRIB_DOCK_SPACES;
+    if (dp_desktop_picture_manager != nil) attrib |= OSAX_ATTRIB_DPPM;
+    if (add_space_fp)                      attrib |= OSAX_ATTRIB_ADD_SPACE;
+    if (remove_space_fp)                   attrib |= OSAX_ATTRIB_REM_SPACE;
+    if (move_space_fp)                     attrib |= OSAX_ATTRIB_MOV_SPACE;
+    if (set_front_window_fp)               attrib |= OSAX_ATTRIB_SET_WINDOW;
+    if (animation_time_addr)               attrib |= OSAX_ATTRIB_ANIM_TIME;
 
-    CFStringRef __block display_uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), space_id);
-    dispatch_sync(dispatch_get_main_queue(), ^{
-        id new_space = macOSSequoia
-                     ? [[objc_getClass("ManagedSpace") alloc] init]
-                     : [[objc_getClass("Dock.ManagedSpace") alloc] init];
-        id display_space = display_space_for_display_uuid(display_uuid);
-        asm__call_add_space(new_space, display_space, add_space_fp);
-        CFRelease(display_uuid);
-    });
+    return attrib;
 }
 
-static void do_space_focus(char *message)
+static void skylight_window_get_bounds(uint32_t wid, struct backend_rect *frame)
 {
-    if (dock_spaces == nil) return;
+    CGRect bounds = {};
+    SLSGetWindowBounds(SLSMainConnectionID(), wid, &bounds);
 
-    uint64_t dest_space_id;
-    unpack(dest_space_id);
-
-    if (dest_space_id) {
-        CFStringRef dest_display = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), dest_space_id);
-        id source_space = macOSSequoia
-                        ? ((id (*)(id, SEL, CFStringRef)) objc_msgSend)(dock_spaces, @selector(currentSpaceForDisplayUUID:), dest_display)
-                        : ((id (*)(id, SEL, CFStringRef)) objc_msgSend)(dock_spaces, @selector(currentSpaceforDisplayUUID:), dest_display);
-        uint64_t source_space_id = get_space_id(source_space);
-
-        if (source_space_id != dest_space_id) {
-            id dest_space = space_for_display_with_id(dest_display, dest_space_id);
-            if (dest_space != nil) {
-                id display_space = display_space_for_space_with_id(source_space_id);
-                if (display_space != nil) {
-                    NSArray *ns_source_space = @[ @(source_space_id) ];
-                    NSArray *ns_dest_space = @[ @(dest_space_id) ];
-                    SLSShowSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_dest_space);
-                    SLSHideSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_source_space);
-                    SLSManagedDisplaySetCurrentSpace(SLSMainConnectionID(), dest_display, dest_space_id);
-                    set_ivar_value(display_space, "_currentSpace", [dest_space retain]);
-                    [ns_dest_space release];
-                    [ns_source_space release];
-                }
-            }
-        }
+    frame->x = bounds.origin.x;
+    frame->y = bounds.origin.y;
+    frame->width = bounds.size.width;
+    frame->height = bounds.size.height;
+}
 
-        CFRelease(dest_display);
-    }
+static void skylight_window_move(uint32_t wid, int x, int y)
+{
+    CGPoint point = CGPointMake(x, y);
+    SLSMoveWindowWithGroup(SLSMainConnectionID(), wid, &point);
 }
 
-static void do_window_scale(char *message)
+static void skylight_window_reassociate(const uint32_t *wids, int count)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
+    CFArrayRef window_list_ref = cfarray_of_cfnumbers(wids, sizeof(uint32_t), count, kCFNumberSInt32Type);
+    SLSReassociateWindowsSpacesByGeometry(SLSMainConnectionID(), window_list_ref);
+    CFRelease(window_list_ref);
+}
+
+static void skylight_window_scale(uint32_t wid, float dx, float dy, float dw, float dh)
+{
+    (void) dh;
 
     CGRect frame = {};
     SLSGetWindowBounds(SLSMainConnectionID(), wid, &frame);
@@ -610,12 +792,6 @@ static void do_window_scale(char *message)
     SLSGetWindowTransform(SLSMainConnectionID(), wid, &current_transform);
 
     if (CGAffineTransformEqualToTransform(current_transform, original_transform)) {
-        float dx, dy, dw, dh;
-        unpack(dx);
-        unpack(dy);
-        unpack(dw);
-        unpack(dh);
-
         int target_width  = dw / 4;
         int target_height = target_width / (frame.size.width/frame.size.height);
 
@@ -633,681 +809,513 @@ static void do_window_scale(char *message)
     }
 }
 
-static void do_window_move(char *message)
+static void skylight_window_get_alpha(uint32_t wid, float *alpha)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
-
-    int x, y;
-    unpack(x);
-    unpack(y);
-
-    CGPoint point = CGPointMake(x, y);
-    SLSMoveWindowWithGroup(SLSMainConnectionID(), wid, &point);
-
-    NSArray *window_list = @[ @(wid) ];
-    SLSReassociateWindowsSpacesByGeometry(SLSMainConnectionID(), (__bridge CFArrayRef) window_list);
-    [window_list release];
+    SLSGetWindowAlpha(SLSMainConnectionID(), wid, alpha);
 }
 
-static void do_window_opacity(char *message)
+static void skylight_window_set_alpha(uint32_t wid, float alpha)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
-
-    float alpha;
-    unpack(alpha);
-
-    pthread_mutex_lock(&window_fade_lock);
-    struct window_fade_context *context = table_find(&window_fade_table, &wid);
-
-    if (context) {
-        context->alpha = alpha;
-        context->duration = 0.0f;
-        __asm__ __volatile__ ("" ::: "memory");
-
-        context->skip = true;
-        pthread_mutex_unlock(&window_fade_lock);
-    } else {
-        SLSSetWindowAlpha(SLSMainConnectionID(), wid, alpha);
-        pthread_mutex_unlock(&window_fade_lock);
-    }
+    SLSSetWindowAlpha(SLSMainConnectionID(), wid, alpha);
 }
 
-static void *window_fade_thread_proc(void *data)
+static void skylight_window_set_layer(uint32_t wid, int layer)
 {
-entry:;
-    struct window_fade_context *context = (struct window_fade_context *) data;
-    context->skip  = false;
-
-    float start_alpha;
-    float end_alpha = context->alpha;
-    SLSGetWindowAlpha(SLSMainConnectionID(), context->wid, &start_alpha);
-
-    int frame_duration = 8;
-    int total_duration = (int)(context->duration * 1000.0f);
-    int frame_count = (int)(((float) total_duration / (float) frame_duration) + 1.0f);
-
-    for (int frame_index = 1; frame_index <= frame_count; ++frame_index) {
-        if (context->skip) goto entry;
-
-        float t = (float) frame_index / (float) frame_count;
-        if (t < 0.0f) t = 0.0f;
-        if (t > 1.0f) t = 1.0f;
-
-        float alpha = lerp(start_alpha, t, end_alpha);
-        SLSSetWindowAlpha(SLSMainConnectionID(), context->wid, alpha);
-
-        usleep(frame_duration*1000);
-    }
-
-    pthread_mutex_lock(&window_fade_lock);
-    if (!context->skip) {
-        table_remove(&window_fade_table, &context->wid);
-        pthread_mutex_unlock(&window_fade_lock);
-        free(context);
-        return NULL;
-    }
-    pthread_mutex_unlock(&window_fade_lock);
-
-    goto entry;
+    SLSSetWindowSubLevel(SLSMainConnectionID(), wid, CGWindowLevelForKey(layer));
 }
 
-static void do_window_opacity_fade(char *message)
+static void skylight_window_get_level(uint32_t wid, int *level)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
-
-    float alpha, duration;
-    unpack(alpha);
-    unpack(duration);
-
-    pthread_mutex_lock(&window_fade_lock);
-    struct window_fade_context *context = table_find(&window_fade_table, &wid);
-
-    if (context) {
-        context->alpha = alpha;
-        context->duration = duration;
-        __asm__ __volatile__ ("" ::: "memory");
-
-        context->skip = true;
-        pthread_mutex_unlock(&window_fade_lock);
-    } else {
-        context = malloc(sizeof(struct window_fade_context));
-        context->wid = wid;
-        context->alpha = alpha;
-        context->duration = duration;
-        context->skip = false;
-        __asm__ __volatile__ ("" ::: "memory");
-
-        table_add(&window_fade_table, &wid, context);
-        pthread_mutex_unlock(&window_fade_lock);
-        pthread_create(&context->thread, NULL, &window_fade_thread_proc, context);
-        pthread_detach(context->thread);
-    }
+    SLSGetWindowLevel(SLSMainConnectionID(), wid, level);
 }
 
-static void do_window_layer(char *message)
+static void skylight_window_set_tags(uint32_t wid, uint64_t tags)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
-
-    int layer;
-    unpack(layer);
+    SLSSetWindowTags(SLSMainConnectionID(), wid, &tags, 64);
+}
 
-    SLSSetWindowSubLevel(SLSMainConnectionID(), wid, CGWindowLevelForKey(layer));
+static void skylight_window_clear_tags(uint32_t wid, uint64_t tags)
+{
+    SLSClearWindowTags(SLSMainConnectionID(), wid, &tags, 64);
 }
 
-static void do_window_sticky(char *message)
+static uint64_t skylight_window_get_tags(uint32_t wid)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
+    uint64_t tags = 0;
+    SLSGetWindowTags(SLSMainConnectionID(), wid, &tags, 1);
+    return tags;
+}
 
-    bool value;
-    unpack(value);
+static void skylight_window_order(uint32_t wid, int order, uint32_t rel_wid)
+{
+    SLSOrderWindow(SLSMainConnectionID(), wid, order, rel_wid);
+}
 
-    uint64_t tags = (1 << 11);
-    if (value == 1) {
-        SLSSetWindowTags(SLSMainConnectionID(), wid, &tags, 64);
-    } else {
-        SLSClearWindowTags(SLSMainConnectionID(), wid, &tags, 64);
-    }
+static bool skylight_window_is_ordered_in(uint32_t wid)
+{
+    bool ordered_in = true;
+    SLSWindowIsOrderedIn(SLSMainConnectionID(), wid, &ordered_in);
+    return ordered_in;
 }
 
 typedef void (*focus_window_call)(ProcessSerialNumber psn, uint32_t wid);
-static void do_window_focus(char *message)
+static void skylight_window_focus(uint32_t wid)
 {
     if (set_front_window_fp == 0) return;
 
     int window_connection;
     ProcessSerialNumber window_psn;
 
-    uint32_t wid;
-    unpack(wid);
-
     SLSGetWindowOwner(SLSMainConnectionID(), wid, &window_connection);
     SLSGetConnectionPSN(SLSMainConnectionID(), &window_psn);
 
     ((focus_window_call) set_front_window_fp)(window_psn, wid);
 }
 
-static void do_window_shadow(char *message)
+static void skylight_window_move_to_space(const uint32_t *wids, int count, uint64_t sid)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
-
-    bool value;
-    unpack(value);
-
-    uint64_t tags = (1 << 3);
-    if (value == 1) {
-        SLSClearWindowTags(SLSMainConnectionID(), wid, &tags, 64);
-    } else {
-        SLSSetWindowTags(SLSMainConnectionID(), wid, &tags, 64);
-    }
+    CFArrayRef window_list_ref = cfarray_of_cfnumbers(wids, sizeof(uint32_t), count, kCFNumberSInt32Type);
+    SLSMoveWindowsToManagedSpace(SLSMainConnectionID(), window_list_ref, sid);
+    CFRelease(window_list_ref);
 }
 
-static void do_window_swap_proxy_in(char *message)
+static void skylight_window_snapshot(const uint32_t *wids, int count, struct sa_window_record *records)
 {
-    int count = 0;
-    unpack(count);
-    if (!count) return;
+    int cid = SLSMainConnectionID();
 
-    CFTypeRef transaction = SLSTransactionCreate(SLSMainConnectionID());
     for (int i = 0; i < count; ++i) {
-        uint32_t wid;
-        unpack(wid);
-        if (!wid) continue;
-
-        uint32_t proxy_wid;
-        unpack(proxy_wid);
-
-        SLSTransactionOrderWindowGroup(transaction, proxy_wid, 1, wid);
-        SLSTransactionSetWindowSystemAlpha(transaction, wid, 0);
+        uint32_t wid = wids[i];
+        struct sa_window_record *record = &records[i];
+        memset(record, 0, sizeof(struct sa_window_record));
+
+        CGRect frame = {};
+        if (!wid || SLSGetWindowBounds(cid, wid, &frame) != kCGErrorSuccess) continue;
+
+        float alpha = 1.0f;
+        int level = 0;
+        bool ordered_in = true;
+        uint64_t tags = 0;
+
+        SLSGetWindowAlpha(cid, wid, &alpha);
+        SLSGetWindowLevel(cid, wid, &level);
+        SLSWindowIsOrderedIn(cid, wid, &ordered_in);
+        SLSGetWindowTags(cid, wid, &tags, 1);
+
+        record->wid = wid;
+        record->x = (int32_t) frame.origin.x;
+        record->y = (int32_t) frame.origin.y;
+        record->width = (int32_t) frame.size.width;
+        record->height = (int32_t) frame.size.height;
+        record->alpha = alpha;
+        record->level = level;
+        record->ordered_in = ordered_in;
+        record->tags = tags;
     }
-    SLSTransactionCommit(transaction, 0);
-    CFRelease(transaction);
 }
 
-static void do_window_swap_proxy_out(char *message)
-{
-    int count = 0;
-    unpack(count);
-    if (!count) return;
+//
+// NOTE: The transactional move/order/level calls are weakly imported; where
+// a SkyLight build lacks one, that change falls back to the immediate call.
+//
 
-    CFTypeRef transaction = SLSTransactionCreate(SLSMainConnectionID());
-    for (int i = 0; i < count; ++i) {
-        uint32_t wid;
-        unpack(wid);
-        if (!wid) continue;
-
-        uint32_t proxy_wid;
-        unpack(proxy_wid);
+static void *skylight_transaction_create(void)
+{
+    return (void *) SLSTransactionCreate(SLSMainConnectionID());
+}
 
-        SLSTransactionSetWindowSystemAlpha(transaction, wid, 1.0f);
-        SLSTransactionOrderWindowGroup(transaction, proxy_wid, 0, wid);
+static void skylight_transaction_move(void *transaction, uint32_t wid, int x, int y)
+{
+    CGPoint point = CGPointMake(x, y);
+    if (SLSTransactionMoveWindowWithGroup) {
+        SLSTransactionMoveWindowWithGroup(transaction, wid, point);
+    } else {
+        SLSMoveWindowWithGroup(SLSMainConnectionID(), wid, &point);
     }
-    SLSTransactionCommit(transaction, 0);
-    CFRelease(transaction);
 }
 
-static void do_window_order(char *message)
+static void skylight_transaction_set_alpha(void *transaction, uint32_t wid, float alpha)
 {
-    uint32_t a_wid;
-    unpack(a_wid);
-    if (!a_wid) return;
-
-    int order;
-    unpack(order);
-
-    uint32_t b_wid;
-    unpack(b_wid);
-
-    SLSOrderWindow(SLSMainConnectionID(), a_wid, order, b_wid);
+    SLSTransactionSetWindowSystemAlpha(transaction, wid, alpha);
 }
 
-static void do_window_order_in(char *message)
+static void skylight_transaction_set_layer(void *transaction, uint32_t wid, int layer)
 {
-    int count = 0;
-    unpack(count);
-    if (!count) return;
-
-    CFTypeRef transaction = SLSTransactionCreate(SLSMainConnectionID());
-    for (int i = 0; i < count; ++i) {
-        uint32_t wid;
-        unpack(wid);
-        if (!wid) continue;
-
-        SLSTransactionOrderWindowGroup(transaction, wid, 1, 0);
+    if (SLSTransactionSetWindowSubLevel) {
+        SLSTransactionSetWindowSubLevel(transaction, wid, CGWindowLevelForKey(layer));
+    } else {
+        SLSSetWindowSubLevel(SLSMainConnectionID(), wid, CGWindowLevelForKey(layer));
     }
-    SLSTransactionCommit(transaction, 0);
-    CFRelease(transaction);
 }
 
-static inline CFArrayRef cfarray_of_cfnumbers(void *values, size_t size, int count, CFNumberType type)
+static void skylight_transaction_order(void *transaction, uint32_t wid, int order, uint32_t rel_wid)
 {
-    CFNumberRef temp[count];
-
-    for (int i = 0; i < count; ++i) {
-        temp[i] = CFNumberCreate(NULL, type, ((char *)values) + (size * i));
-    }
-
-    CFArrayRef result = CFArrayCreate(NULL, (const void **)temp, count, &kCFTypeArrayCallBacks);
-
-    for (int i = 0; i < count; ++i) {
-        CFRelease(temp[i]);
+    if (SLSTransactionOrderWindow) {
+        SLSTransactionOrderWindow(transaction, wid, order, rel_wid);
+    } else {
+        SLSOrderWindow(SLSMainConnectionID(), wid, order, rel_wid);
     }
-
-    return result;
 }
 
-static void do_window_list_move_to_space(char *message)
+static void skylight_transaction_order_group(void *transaction, uint32_t wid, int order, uint32_t rel_wid)
 {
-    uint64_t sid;
-    unpack(sid);
-
-    int count = 0;
-    unpack(count);
-
-    CFArrayRef window_list_ref = cfarray_of_cfnumbers((uint32_t*)message, sizeof(uint32_t), count, kCFNumberSInt32Type);
-    SLSMoveWindowsToManagedSpace(SLSMainConnectionID(), window_list_ref, sid);
-    CFRelease(window_list_ref);
+    SLSTransactionOrderWindowGroup(transaction, wid, order, rel_wid);
 }
 
-static void do_window_move_to_space(char *message)
+static void skylight_transaction_commit(void *transaction)
 {
-    uint64_t sid;
-    unpack(sid);
-
-    uint32_t wid;
-    unpack(wid);
-
-    CFArrayRef window_list_ref = cfarray_of_cfnumbers(&wid, sizeof(uint32_t), 1, kCFNumberSInt32Type);
-    SLSMoveWindowsToManagedSpace(SLSMainConnectionID(), window_list_ref, sid);
-    CFRelease(window_list_ref);
+    SLSTransactionCommit(transaction, 0);
+    CFRelease(transaction);
 }
 
-// ============================================================================
-// New Feature Handlers
-// ============================================================================
-
-static void do_window_resize(char *message)
+static void skylight_space_move(uint64_t source_space_id, uint64_t dest_space_id, uint64_t source_prev_space_id, bool focus_dest_space)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
-
-    int width, height;
-    unpack(width);
-    unpack(height);
-
-    // Get current window bounds to preserve position
-    CGRect bounds;
-    SLSGetWindowBounds(SLSMainConnectionID(), wid, &bounds);
+    if (dock_spaces == nil || dp_desktop_picture_manager == nil || move_space_fp == 0) return;
 
-    // Set new size while keeping origin
-    bounds.size.width = width;
-    bounds.size.height = height;
+    CFStringRef source_display_uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), source_space_id);
+    id source_space = space_for_display_with_id(source_display_uuid, source_space_id);
+    id source_display_space = display_space_for_space(source_display_uuid, source_space_id);
 
-    CGPoint origin = bounds.origin;
-    SLSMoveWindowWithGroup(SLSMainConnectionID(), wid, &origin);
+    CFStringRef dest_display_uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), dest_space_id);
+    id dest_space = space_for_display_with_id(dest_display_uuid, dest_space_id);
+    unsigned dest_display_id = ((unsigned (*)(id, SEL, id)) objc_msgSend)(dock_spaces, @selector(displayIDForSpace:), dest_space);
+    id dest_display_space = display_space_for_space(dest_display_uuid, dest_space_id);
 
-    // Note: Full bounds setting may require additional SkyLight functions
-    // that need pattern matching. This is a simplified implementation.
-}
+    if (source_prev_space_id) {
+        NSArray *ns_source_space = @[ @(source_space_id) ];
+        NSArray *ns_dest_space = @[ @(source_prev_space_id) ];
+        id new_source_space = space_for_display_with_id(source_display_uuid, source_prev_space_id);
+        SLSShowSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_dest_space);
+        SLSHideSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_source_space);
+        SLSManagedDisplaySetCurrentSpace(SLSMainConnectionID(), source_display_uuid, source_prev_space_id);
+        set_ivar_value(source_display_space, "_currentSpace", [new_source_space retain]);
+        [ns_dest_space release];
+        [ns_source_space release];
+    }
 
-static void do_window_set_frame(char *message)
-{
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
+    asm__call_move_space(source_space, dest_space, dest_display_uuid, dock_spaces, move_space_fp);
+    space_index_move(source_space_id, dest_display_space, dest_display_uuid);
 
-    int x, y, width, height;
-    unpack(x);
-    unpack(y);
-    unpack(width);
-    unpack(height);
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        ((void (*)(id, SEL, id, unsigned, CFStringRef)) objc_msgSend)(dp_desktop_picture_manager, @selector(moveSpace:toDisplay:displayUUID:), source_space, dest_display_id, dest_display_uuid);
+    });
 
-    CGPoint point = CGPointMake(x, y);
-    SLSMoveWindowWithGroup(SLSMainConnectionID(), wid, &point);
+    if (focus_dest_space) {
+        uint64_t new_source_space_id = SLSManagedDisplayGetCurrentSpace(SLSMainConnectionID(), source_display_uuid);
+        id new_source_space = space_for_display_with_id(source_display_uuid, new_source_space_id);
+        set_ivar_value(source_display_space, "_currentSpace", [new_source_space retain]);
 
-    // Note: Resize portion needs SLSSetWindowBounds or similar
-    // This implementation handles position; size change needs additional work
+        NSArray *ns_dest_monitor_space = @[ @(dest_space_id) ];
+        SLSHideSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_dest_monitor_space);
+        SLSManagedDisplaySetCurrentSpace(SLSMainConnectionID(), dest_display_uuid, source_space_id);
+        set_ivar_value(dest_display_space, "_currentSpace", [source_space retain]);
+        [ns_dest_monitor_space release];
+    }
 
-    NSArray *window_list = @[ @(wid) ];
-    SLSReassociateWindowsSpacesByGeometry(SLSMainConnectionID(), (__bridge CFArrayRef) window_list);
-    [window_list release];
+    CFRelease(source_display_uuid);
+    CFRelease(dest_display_uuid);
 }
 
-static void do_window_minimize(char *message)
+typedef void (*remove_space_call)(id space, id display_space, id dock_spaces, uint64_t space_id1, uint64_t space_id2);
+static void skylight_space_destroy(uint64_t space_id)
 {
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
+    if (dock_spaces == nil || remove_space_fp == 0) return;
 
-    // Minimize by ordering window out
-    // kCGSOrderOut = 0
-    SLSOrderWindow(SLSMainConnectionID(), wid, 0, 0);
-}
+    CFStringRef display_uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), space_id);
+    uint64_t active_space_id = SLSManagedDisplayGetCurrentSpace(SLSMainConnectionID(), display_uuid);
 
-static void do_window_unminimize(char *message)
-{
-    uint32_t wid;
-    unpack(wid);
-    if (!wid) return;
+    id space = space_for_display_with_id(display_uuid, space_id);
+    id display_space = display_space_for_space(display_uuid, space_id);
 
-    // Restore window by ordering it back in
-    // kCGSOrderAbove = 1
-    SLSOrderWindow(SLSMainConnectionID(), wid, 1, 0);
-}
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        ((remove_space_call) remove_space_fp)(space, display_space, dock_spaces, space_id, space_id);
+    });
+    space_index_invalidate();
 
-// Response protocol helper
-static void send_response(int sockfd, const void *data, int length)
-{
-    send(sockfd, data, length, 0);
+    if (active_space_id == space_id) {
+        uint64_t dest_space_id = SLSManagedDisplayGetCurrentSpace(SLSMainConnectionID(), display_uuid);
+        id dest_space = space_for_display_with_id(display_uuid, dest_space_id);
+        set_ivar_value(display_space, "_currentSpace", [dest_space retain]);
+    }
+
+    CFRelease(display_uuid);
 }
 
-// Query operation handlers
-static void do_window_get_opacity_query(int sockfd, char *message)
+static void skylight_space_create(uint64_t space_id)
 {
-    uint32_t wid;
-    unpack(wid);
+    if (dock_spaces == nil || add_space_fp == 0) return;
 
-    float opacity = 1.0f;
-    SLSGetWindowAlpha(SLSMainConnectionID(), wid, &opacity);
-    send_response(sockfd, &opacity, sizeof(opacity));
+    CFStringRef __block display_uuid = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), space_id);
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        id new_space = macOSSequoia
+                     ? [[objc_getClass("ManagedSpace") alloc] init]
+                     : [[objc_getClass("Dock.ManagedSpace") alloc] init];
+        id display_space = display_space_for_space(display_uuid, space_id);
+        asm__call_add_space(new_space, display_space, add_space_fp);
+        CFRelease(display_uuid);
+    });
+    space_index_invalidate();
 }
 
-static void do_window_get_frame_query(int sockfd, char *message)
+static void skylight_space_focus(uint64_t dest_space_id)
 {
-    uint32_t wid;
-    unpack(wid);
-
-    CGRect frame = {};
-    SLSGetWindowBounds(SLSMainConnectionID(), wid, &frame);
-
-    // Pack response: x, y, width, height as ints
-    int x = (int)frame.origin.x;
-    int y = (int)frame.origin.y;
-    int width = (int)frame.size.width;
-    int height = (int)frame.size.height;
+    if (dock_spaces == nil) return;
 
-    char response[sizeof(int) * 4];
-    memcpy(response, &x, sizeof(int));
-    memcpy(response + sizeof(int), &y, sizeof(int));
-    memcpy(response + sizeof(int) * 2, &width, sizeof(int));
-    memcpy(response + sizeof(int) * 3, &height, sizeof(int));
+    CFStringRef dest_display = SLSCopyManagedDisplayForSpace(SLSMainConnectionID(), dest_space_id);
+    id source_space = macOSSequoia
+                    ? ((id (*)(id, SEL, CFStringRef)) objc_msgSend)(dock_spaces, @selector(currentSpaceForDisplayUUID:), dest_display)
+                    : ((id (*)(id, SEL, CFStringRef)) objc_msgSend)(dock_spaces, @selector(currentSpaceforDisplayUUID:), dest_display);
+    uint64_t source_space_id = get_space_id(source_space);
+
+    if (source_space_id != dest_space_id) {
+        id dest_space = space_for_display_with_id(dest_display, dest_space_id);
+        if (dest_space != nil) {
+            id display_space = display_space_for_space(dest_display, source_space_id);
+            if (display_space != nil) {
+                NSArray *ns_source_space = @[ @(source_space_id) ];
+                NSArray *ns_dest_space = @[ @(dest_space_id) ];
+                SLSShowSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_dest_space);
+                SLSHideSpaces(SLSMainConnectionID(), (__bridge CFArrayRef) ns_source_space);
+                SLSManagedDisplaySetCurrentSpace(SLSMainConnectionID(), dest_display, dest_space_id);
+                set_ivar_value(display_space, "_currentSpace", [dest_space retain]);
+                [ns_dest_space release];
+                [ns_source_space release];
+            }
+        }
+    }
 
-    send_response(sockfd, response, sizeof(response));
+    CFRelease(dest_display);
 }
 
-static void do_window_is_sticky_query(int sockfd, char *message)
+static uint32_t skylight_display_list(uint32_t *ids, uint32_t max)
 {
-    uint32_t wid;
-    unpack(wid);
-
-    uint64_t tags = 0;
-    SLSGetWindowTags(SLSMainConnectionID(), wid, &tags, 1);
-
-    // Tag 0x800 indicates sticky window
-    uint8_t is_sticky = (tags & 0x800) ? 1 : 0;
-    send_response(sockfd, &is_sticky, sizeof(is_sticky));
+    uint32_t count = 0;
+    CGGetActiveDisplayList(ids ? max : 0, ids, &count);
+    return count;
 }
 
-static void do_window_get_layer_query(int sockfd, char *message)
+static uint64_t skylight_display_space(uint32_t did)
 {
-    uint32_t wid;
-    unpack(wid);
-
-    int level = 0;
-    SLSGetWindowLevel(SLSMainConnectionID(), wid, &level);
-    send_response(sockfd, &level, sizeof(level));
+    CFUUIDRef uuid = CGDisplayCreateUUIDFromDisplayID(did);
+    if (!uuid) return 0;
+
+    CFStringRef uuid_string = CFUUIDCreateString(NULL, uuid);
+    uint64_t sid = SLSManagedDisplayGetCurrentSpace(SLSMainConnectionID(), uuid_string);
+    CFRelease(uuid_string);
+    CFRelease(uuid);
+    return sid;
 }
 
-static void do_window_is_minimized_query(int sockfd, char *message)
+//
+// NOTE: SkyLight reports window changes only for windows the connection has
+// asked about, so every window a subscriber names or the daemon caches is
+// added to one watch list. The list is re-sent whenever it grows, and a
+// window that closes is taken off it. The event numbers are not public; they
+// are the ones the window server posts for a window closing (804), moving
+// (806), resizing (807) and being reordered or shown and hidden (808, 815,
+// 816), and for a space being created or destroyed (1327, 1328). Space
+// switches come from NSWorkspace and display changes from CoreGraphics.
+// Reports arrive on Dock's main thread.
+//
+
+#define SKYLIGHT_EVENT_WINDOW_CLOSED    804
+#define SKYLIGHT_EVENT_WINDOW_MOVED     806
+#define SKYLIGHT_EVENT_WINDOW_RESIZED   807
+#define SKYLIGHT_EVENT_WINDOW_REORDERED 808
+#define SKYLIGHT_EVENT_WINDOW_SHOWN     815
+#define SKYLIGHT_EVENT_WINDOW_HIDDEN    816
+#define SKYLIGHT_EVENT_SPACE_CREATED    1327
+#define SKYLIGHT_EVENT_SPACE_DESTROYED  1328
+
+static backend_notify_fn skylight_notify;
+static pthread_mutex_t skylight_watch_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct wid_table skylight_watched;
+static uint32_t *skylight_watch_list;
+static int skylight_watch_count;
+static int skylight_watch_capacity;
+static uint32_t skylight_shown_displays[SA_STATE_DISPLAY_MAX];
+static uint64_t skylight_shown_spaces[SA_STATE_DISPLAY_MAX];
+static uint32_t skylight_shown_count;
+
+// Takes a closed window off the watch list. The window server posts nothing
+// more for it, so the shorter list is only sent with the next addition.
+static void skylight_unwatch_window(uint32_t wid)
 {
-    uint32_t wid;
-    unpack(wid);
-
-    bool ordered_in = true;
-    SLSWindowIsOrderedIn(SLSMainConnectionID(), wid, &ordered_in);
+    pthread_mutex_lock(&skylight_watch_lock);
+
+    int *index = wid_table_find(&skylight_watched, wid);
+    if (index) {
+        uint32_t last = skylight_watch_list[--skylight_watch_count];
+        if (*index != skylight_watch_count) {
+            skylight_watch_list[*index] = last;
+            *(int *) wid_table_find(&skylight_watched, last) = *index;
+        }
+        wid_table_remove(&skylight_watched, wid);
+    }
 
-    // Window is minimized if it's NOT ordered in
-    uint8_t is_minimized = ordered_in ? 0 : 1;
-    send_response(sockfd, &is_minimized, sizeof(is_minimized));
+    pthread_mutex_unlock(&skylight_watch_lock);
 }
 
-static void do_display_get_count_query(int sockfd, char *message)
+static void skylight_window_changed(uint32_t event, void *data, size_t data_length, void *context)
 {
-    (void)message; // unused
-    uint32_t count = 0;
-    CGGetActiveDisplayList(0, NULL, &count); // Get count
-    send_response(sockfd, &count, sizeof(count));
+    (void) context;
+    if (!skylight_notify || !data || data_length < sizeof(uint32_t)) return;
+
+    uint32_t wid;
+    memcpy(&wid, data, sizeof(wid));
+
+    switch (event) {
+    case SKYLIGHT_EVENT_WINDOW_MOVED:   skylight_notify(SA_EVENT_WINDOW_MOVED, wid, 0); break;
+    case SKYLIGHT_EVENT_WINDOW_RESIZED: skylight_notify(SA_EVENT_WINDOW_RESIZED, wid, 0); break;
+    case SKYLIGHT_EVENT_WINDOW_CLOSED:
+        skylight_unwatch_window(wid);
+        skylight_notify(SA_EVENT_WINDOW_ORDERED | BACKEND_WINDOW_CLOSED, wid, 0);
+        break;
+    default:                            skylight_notify(SA_EVENT_WINDOW_ORDERED, wid, 0); break;
+    }
 }
 
-static void do_display_get_list_query(int sockfd, char *message)
+// Reports every display whose current space differs from the last one seen
+static void skylight_spaces_changed(void)
 {
-    uint32_t max_count;
-    unpack(max_count);
+    uint32_t ids[SA_STATE_DISPLAY_MAX];
+    uint32_t count = skylight_display_list(ids, SA_STATE_DISPLAY_MAX);
+    if (count > SA_STATE_DISPLAY_MAX) count = SA_STATE_DISPLAY_MAX;
 
-    CGDirectDisplayID displays[32] = {};
-    uint32_t count = 0;
-
-    if (max_count > 32) max_count = 32;
+    uint64_t spaces[SA_STATE_DISPLAY_MAX];
+    for (uint32_t i = 0; i < count; ++i) {
+        spaces[i] = skylight_display_space(ids[i]);
 
-    CGGetActiveDisplayList(max_count, displays, &count);
+        uint64_t shown = 0;
+        for (uint32_t j = 0; j < skylight_shown_count; ++j) {
+            if (skylight_shown_displays[j] == ids[i]) shown = skylight_shown_spaces[j];
+        }
 
-    // Send count followed by display IDs
-    char response[sizeof(uint32_t) * 33]; // count + up to 32 displays
-    memcpy(response, &count, sizeof(uint32_t));
-    memcpy(response + sizeof(uint32_t), displays, sizeof(uint32_t) * count);
+        if (spaces[i] != shown && skylight_notify) skylight_notify(SA_EVENT_SPACE_CHANGED, ids[i], spaces[i]);
+    }
 
-    send_response(sockfd, response, sizeof(uint32_t) * (1 + count));
+    memcpy(skylight_shown_displays, ids, sizeof(uint32_t) * count);
+    memcpy(skylight_shown_spaces, spaces, sizeof(uint64_t) * count);
+    skylight_shown_count = count;
 }
 
-static void do_handshake(int sockfd)
+static void skylight_spaces_rearranged(uint32_t event, void *data, size_t data_length, void *context)
 {
-    uint32_t attrib = 0;
+    (void) event; (void) data; (void) data_length; (void) context;
+    space_index_invalidate();
 
-    if (dock_spaces != nil)                attrib |= OSAX_ATTRIB_DOCK_SPACES;
-    if (dp_desktop_picture_manager != nil) attrib |= OSAX_ATTRIB_DPPM;
-    if (add_space_fp)                      attrib |= OSAX_ATTRIB_ADD_SPACE;
-    if (remove_space_fp)                   attrib |= OSAX_ATTRIB_REM_SPACE;
-    if (move_space_fp)                     attrib |= OSAX_ATTRIB_MOV_SPACE;
-    if (set_front_window_fp)               attrib |= OSAX_ATTRIB_SET_WINDOW;
-    if (animation_time_addr)               attrib |= OSAX_ATTRIB_ANIM_TIME;
-
-    char bytes[BUFSIZ] = {};
-    int version_length = strlen(OSAX_VERSION);
-    int attrib_length = sizeof(uint32_t);
-    int bytes_length = version_length + 1 + attrib_length;
-
-    memcpy(bytes, OSAX_VERSION, version_length);
-    memcpy(bytes + version_length + 1, &attrib, attrib_length);
-    bytes[version_length] = '\0';
-    bytes[bytes_length] = '\n';
-
-    send_response(sockfd, bytes, bytes_length+1);
-}
-
-static void handle_message(int sockfd, char *message)
-{
-    enum sa_opcode op = *message++;
-    switch (op) {
-    case SA_OPCODE_HANDSHAKE: {
-        do_handshake(sockfd);
-    } break;
-    case SA_OPCODE_SPACE_FOCUS: {
-        do_space_focus(message);
-    } break;
-    case SA_OPCODE_SPACE_CREATE: {
-        do_space_create(message);
-    } break;
-    case SA_OPCODE_SPACE_DESTROY: {
-        do_space_destroy(message);
-    } break;
-    case SA_OPCODE_SPACE_MOVE: {
-        do_space_move(message);
-    } break;
-    case SA_OPCODE_WINDOW_MOVE: {
-        do_window_move(message);
-    } break;
-    case SA_OPCODE_WINDOW_OPACITY: {
-        do_window_opacity(message);
-    } break;
-    case SA_OPCODE_WINDOW_OPACITY_FADE: {
-        do_window_opacity_fade(message);
-    } break;
-    case SA_OPCODE_WINDOW_LAYER: {
-        do_window_layer(message);
-    } break;
-    case SA_OPCODE_WINDOW_STICKY: {
-        do_window_sticky(message);
-    } break;
-    case SA_OPCODE_WINDOW_SHADOW: {
-        do_window_shadow(message);
-    } break;
-    case SA_OPCODE_WINDOW_FOCUS: {
-        do_window_focus(message);
-    } break;
-    case SA_OPCODE_WINDOW_SCALE: {
-        do_window_scale(message);
-    } break;
-    case SA_OPCODE_WINDOW_SWAP_PROXY_IN: {
-        do_window_swap_proxy_in(message);
-    } break;
-    case SA_OPCODE_WINDOW_SWAP_PROXY_OUT: {
-        do_window_swap_proxy_out(message);
-    } break;
-    case SA_OPCODE_WINDOW_ORDER: {
-        do_window_order(message);
-    } break;
-    case SA_OPCODE_WINDOW_ORDER_IN: {
-        do_window_order_in(message);
-    } break;
-    case SA_OPCODE_WINDOW_LIST_TO_SPACE: {
-        do_window_list_move_to_space(message);
-    } break;
-    case SA_OPCODE_WINDOW_TO_SPACE: {
-        do_window_move_to_space(message);
-    } break;
-    // New feature opcodes
-    case SA_OPCODE_WINDOW_RESIZE: {
-        do_window_resize(message);
-    } break;
-    case SA_OPCODE_WINDOW_SET_FRAME: {
-        do_window_set_frame(message);
-    } break;
-    case SA_OPCODE_WINDOW_MINIMIZE: {
-        do_window_minimize(message);
-    } break;
-    case SA_OPCODE_WINDOW_UNMINIMIZE: {
-        do_window_unminimize(message);
-    } break;
-    // Query operations
-    case SA_OPCODE_WINDOW_GET_OPACITY: {
-        do_window_get_opacity_query(sockfd, message);
-    } break;
-    case SA_OPCODE_WINDOW_GET_FRAME: {
-        do_window_get_frame_query(sockfd, message);
-    } break;
-    case SA_OPCODE_WINDOW_IS_STICKY: {
-        do_window_is_sticky_query(sockfd, message);
-    } break;
-    case SA_OPCODE_WINDOW_GET_LAYER: {
-        do_window_get_layer_query(sockfd, message);
-    } break;
-    case SA_OPCODE_WINDOW_IS_MINIMIZED: {
-        do_window_is_minimized_query(sockfd, message);
-    } break;
-    case SA_OPCODE_DISPLAY_GET_COUNT: {
-        do_display_get_count_query(sockfd, message);
-    } break;
-    case SA_OPCODE_DISPLAY_GET_LIST: {
-        do_display_get_list_query(sockfd, message);
-    } break;
+    uint32_t ids[SA_STATE_DISPLAY_MAX];
+    uint32_t count = skylight_display_list(ids, SA_STATE_DISPLAY_MAX);
+    for (uint32_t i = 0; i < count && i < SA_STATE_DISPLAY_MAX; ++i) {
+        skylight_notify(SA_EVENT_DISPLAY_CHANGED, ids[i], 0);
     }
+    skylight_spaces_changed();
 }
 
-static inline bool read_message(int sockfd, char *message)
+static void skylight_display_reconfigured(CGDirectDisplayID did, CGDisplayChangeSummaryFlags flags, void *context)
 {
-    int bytes_read    = 0;
-    int bytes_to_read = 0;
-
-    if (read(sockfd, &bytes_to_read, sizeof(int16_t)) == sizeof(int16_t)) {
-        do {
-            int cur_read = read(sockfd, message+bytes_read, bytes_to_read-bytes_read);
-            if (cur_read <= 0) break;
+    (void) context;
+    if (flags & kCGDisplayBeginConfigurationFlag) return;
 
-            bytes_read += cur_read;
-        } while (bytes_read < bytes_to_read);
-        return bytes_read == bytes_to_read;
-    }
+    space_index_invalidate();
+    skylight_notify(SA_EVENT_DISPLAY_CHANGED, did, 0);
+    skylight_spaces_changed();
+}
 
-    return false;
+static void skylight_watch(backend_notify_fn notify)
+{
+    skylight_notify = notify;
+    wid_table_init(&skylight_watched, 64, sizeof(int));    // wid -> index in skylight_watch_list
+
+    int cid = SLSMainConnectionID();
+    SLSRegisterConnectionNotifyProc(cid, skylight_window_changed, SKYLIGHT_EVENT_WINDOW_CLOSED, NULL);
+    SLSRegisterConnectionNotifyProc(cid, skylight_window_changed, SKYLIGHT_EVENT_WINDOW_MOVED, NULL);
+    SLSRegisterConnectionNotifyProc(cid, skylight_window_changed, SKYLIGHT_EVENT_WINDOW_RESIZED, NULL);
+    SLSRegisterConnectionNotifyProc(cid, skylight_window_changed, SKYLIGHT_EVENT_WINDOW_REORDERED, NULL);
+    SLSRegisterConnectionNotifyProc(cid, skylight_window_changed, SKYLIGHT_EVENT_WINDOW_SHOWN, NULL);
+    SLSRegisterConnectionNotifyProc(cid, skylight_window_changed, SKYLIGHT_EVENT_WINDOW_HIDDEN, NULL);
+    SLSRegisterConnectionNotifyProc(cid, skylight_spaces_rearranged, SKYLIGHT_EVENT_SPACE_CREATED, NULL);
+    SLSRegisterConnectionNotifyProc(cid, skylight_spaces_rearranged, SKYLIGHT_EVENT_SPACE_DESTROYED, NULL);
+    CGDisplayRegisterReconfigurationCallback(skylight_display_reconfigured, NULL);
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        skylight_spaces_changed();
+        [[[NSWorkspace sharedWorkspace] notificationCenter] addObserverForName:NSWorkspaceActiveSpaceDidChangeNotification
+                                                                        object:nil
+                                                                         queue:nil
+                                                                    usingBlock:^(NSNotification *note) {
+            (void) note;
+            skylight_spaces_changed();
+        }];
+    });
 }
 
-static void *handle_connection(void *unused)
+static void skylight_watch_windows(const uint32_t *wids, int count)
 {
-    for (;;) {
-        int sockfd = accept(daemon_sockfd, NULL, 0);
-        if (sockfd == -1) continue;
+    pthread_mutex_lock(&skylight_watch_lock);
+
+    int added = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!wids[i] || wid_table_find(&skylight_watched, wids[i])) continue;
 
-        char message[0x1000];
-        if (read_message(sockfd, message)) {
-            handle_message(sockfd, message);
+        if (skylight_watch_count == skylight_watch_capacity) {
+            skylight_watch_capacity = skylight_watch_capacity ? 2 * skylight_watch_capacity : 64;
+            skylight_watch_list = realloc(skylight_watch_list, sizeof(uint32_t) * skylight_watch_capacity);
         }
 
-        shutdown(sockfd, SHUT_RDWR);
-        close(sockfd);
+        wid_table_add(&skylight_watched, wids[i], &skylight_watch_count);
+        skylight_watch_list[skylight_watch_count++] = wids[i];
+        ++added;
     }
 
-    return NULL;
-}
+    if (added) SLSRequestNotificationsForWindows(SLSMainConnectionID(), skylight_watch_list, skylight_watch_count);
 
-static TABLE_HASH_FUNC(hash_wid)
-{
-    return *(uint32_t *) key;
+    pthread_mutex_unlock(&skylight_watch_lock);
 }
 
-static TABLE_COMPARE_FUNC(compare_wid)
-{
-    return *(uint32_t *) key_a == *(uint32_t *) key_b;
-}
+static const struct backend skylight_backend = {
+    .name                        = "skylight",
+    .capabilities                = skylight_capabilities,
+    .window_get_bounds           = skylight_window_get_bounds,
+    .window_move                 = skylight_window_move,
+    .window_reassociate          = skylight_window_reassociate,
+    .window_scale                = skylight_window_scale,
+    .window_get_alpha            = skylight_window_get_alpha,
+    .window_set_alpha            = skylight_window_set_alpha,
+    .window_set_layer            = skylight_window_set_layer,
+    .window_get_level            = skylight_window_get_level,
+    .window_set_tags             = skylight_window_set_tags,
+    .window_clear_tags           = skylight_window_clear_tags,
+    .window_get_tags             = skylight_window_get_tags,
+    .window_order                = skylight_window_order,
+    .window_is_ordered_in        = skylight_window_is_ordered_in,
+    .window_focus                = skylight_window_focus,
+    .window_move_to_space        = skylight_window_move_to_space,
+    .window_snapshot             = skylight_window_snapshot,
+    .transaction_create          = skylight_transaction_create,
+    .transaction_move            = skylight_transaction_move,
+    .transaction_set_alpha       = skylight_transaction_set_alpha,
+    .transaction_set_layer       = skylight_transaction_set_layer,
+    .transaction_order           = skylight_transaction_order,
+    .transaction_order_group     = skylight_transaction_order_group,
+    .transaction_commit          = skylight_transaction_commit,
+    .space_focus                 = skylight_space_focus,
+    .space_create                = skylight_space_create,
+    .space_destroy               = skylight_space_destroy,
+    .space_move                  = skylight_space_move,
+    .display_list                = skylight_display_list,
+    .display_space               = skylight_display_space,
+    .watch                       = skylight_watch,
+    .watch_windows               = skylight_watch_windows,
+};
 
 static bool start_daemon(char *socket_path)
 {
-    struct sockaddr_un socket_address;
-    socket_address.sun_family = AF_UNIX;
-    snprintf(socket_address.sun_path, sizeof(socket_address.sun_path), "%s", socket_path);
-    unlink(socket_path);
-
-    if ((daemon_sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
-        return false;
-    }
-
-    if (bind(daemon_sockfd, (struct sockaddr *) &socket_address, sizeof(socket_address)) == -1) {
-        return false;
-    }
-
-    if (chmod(socket_path, 0600) != 0) {
-        return false;
-    }
-
-    if (listen(daemon_sockfd, SOMAXCONN) == -1) {
+    if (!daemon_listen(socket_path)) {
         return false;
     }
 
     init_instances();
-    pthread_mutex_init(&window_fade_lock, NULL);
-    table_init(&window_fade_table, 150, hash_wid, compare_wid);
-    pthread_create(&daemon_thread, NULL, &handle_connection, NULL);
+    daemon_start(&skylight_backend, true);
 
     return true;
 }
@@ -1324,7 +1332,7 @@ void load_payload(void)
     }
 
     char socket_file[255];
-    snprintf(socket_file, sizeof(socket_file), SOCKET_PATH_FMT, user);
+    snprintf(socket_file, sizeof(socket_file), SA_SOCKET_PATH_FMT, user);
 
     if (start_daemon(socket_file)) {
         NSLog(@"[mss] now listening..");
@@ -0,0 +1,539 @@
+#ifndef SIGSCAN_H
+#define SIGSCAN_H
+
+//
+// Wildcard byte-signature scanner.
+//
+// Patterns are written as space separated hex bytes with "??" for a
+// wildcard, e.g. "48 8B ?? ?? E8". sig_parse() turns one into a byte/mask
+// pair and picks two anchor bytes: the fixed bytes least likely to occur in
+// machine code. On arm64 sig_scan() tests both anchors for 16 candidate
+// offsets at a time with NEON and only runs the full masked compare where
+// both anchors hit. Elsewhere the first anchor is located with memchr():
+// libc's memchr is already vectorised, and on x86_64 hand-written SSE2 and
+// AVX2 versions of the two-anchor loop measured 10-70% slower than it (see
+// make bench-scan).
+//
+// Portable C; the payload and the host-side tools/benchmarks share it.
+//
+
+#define SIG_PATTERN_MAX 256
+
+struct sig_pattern
+{
+    int length;
+    int anchor;
+    int anchor2;
+    uint8_t bytes[SIG_PATTERN_MAX];
+    uint8_t mask[SIG_PATTERN_MAX];
+};
+
+//
+// One signature of a set resolved together by sig_scan_all(). Candidate
+// offsets are [offset, offset + window) relative to the image base; hit is
+// the first matching offset, or -1.
+//
+struct sig_target
+{
+    const char *name;
+    uint64_t offset;
+    uint64_t window;
+    struct sig_pattern sig;
+    int64_t hit;
+};
+
+#define SIG_BLOCK_SIZE 0x4000
+#define SIG_SET_MAX    32       // Targets sig_scan_all() sweeps for at once; larger sets take one sweep per group
+
+bool sig_parse(struct sig_pattern *sig, const char *pattern);
+bool sig_match(const struct sig_pattern *sig, const uint8_t *data);
+const uint8_t *sig_scan(const struct sig_pattern *sig, const uint8_t *data, size_t size);
+uint64_t sig_scan_all(struct sig_target *targets, int count, const uint8_t *base);
+
+#endif
+
+#ifdef SIGSCAN_IMPLEMENTATION
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__arm64__)
+#include <arm_neon.h>
+#endif
+
+static inline int sig_hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+//
+// NOTE: Lower is more common. Opcode, prefix, register and immediate bytes
+// that show up constantly in x86_64 and arm64 code make poor anchors.
+//
+static inline int sig_byte_rarity(uint8_t byte)
+{
+    static const uint8_t common[] = {
+        0x00, 0xFF, 0x48, 0x89, 0x8B, 0x0F, 0xE8, 0x4C, 0x01, 0x24,
+        0x44, 0x85, 0xC0, 0x08, 0x10, 0x20, 0xF9, 0x91, 0xAA, 0x94,
+        0x03, 0x02, 0xE0, 0xE1, 0x40, 0x49, 0x41, 0xB9, 0xA9, 0xFD,
+        0x7B, 0x8D, 0x83, 0x74, 0x75, 0xC3, 0x5D, 0x55, 0x97, 0xD6,
+    };
+
+    for (int i = 0; i < (int)(sizeof(common) / sizeof(*common)); ++i) {
+        if (common[i] == byte) return i;
+    }
+
+    return 0xFF;
+}
+
+bool sig_parse(struct sig_pattern *sig, const char *pattern)
+{
+    memset(sig, 0, sizeof(struct sig_pattern));
+    sig->anchor = -1;
+    sig->anchor2 = -1;
+
+    const char *cursor = pattern;
+    while (*cursor) {
+        if (*cursor == ' ') {
+            ++cursor;
+            continue;
+        }
+
+        if (sig->length == SIG_PATTERN_MAX || !cursor[1]) return false;
+
+        if (cursor[0] == '?') {
+            sig->bytes[sig->length] = 0;
+            sig->mask[sig->length] = 0;
+        } else {
+            int hi = sig_hex_digit(cursor[0]);
+            int lo = sig_hex_digit(cursor[1]);
+            if (hi == -1 || lo == -1) return false;
+
+            sig->bytes[sig->length] = (uint8_t)((hi << 4) | lo);
+            sig->mask[sig->length] = 0xFF;
+        }
+
+        ++sig->length;
+        cursor += 2;
+        if (*cursor && *cursor != ' ') return false;
+    }
+
+    if (!sig->length) return false;
+
+    for (int i = 0; i < sig->length; ++i) {
+        if (!sig->mask[i]) continue;
+
+        int rarity = sig_byte_rarity(sig->bytes[i]);
+        if (sig->anchor == -1 || rarity > sig_byte_rarity(sig->bytes[sig->anchor])) {
+            sig->anchor2 = sig->anchor;
+            sig->anchor = i;
+        } else if (sig->anchor2 == -1 || rarity > sig_byte_rarity(sig->bytes[sig->anchor2])) {
+            sig->anchor2 = i;
+        }
+    }
+
+    if (sig->anchor2 == -1) sig->anchor2 = sig->anchor;
+    return true;
+}
+
+static inline bool sig_match_at(const struct sig_pattern *sig, const uint8_t *data)
+{
+    for (int i = 0; i < sig->length; ++i) {
+        if ((data[i] & sig->mask[i]) != sig->bytes[i]) return false;
+    }
+
+    return true;
+}
+
+bool sig_match(const struct sig_pattern *sig, const uint8_t *data)
+{
+    return sig->length && sig_match_at(sig, data);
+}
+
+static const uint8_t *sig_scan_scalar(const struct sig_pattern *sig, const uint8_t *data, size_t start, size_t count)
+{
+    uint8_t first = sig->bytes[sig->anchor];
+
+    while (start < count) {
+        const uint8_t *hit = memchr(data + start + sig->anchor, first, count - start);
+        if (!hit) return NULL;
+
+        size_t offset = (size_t)(hit - data) - sig->anchor;
+        if (sig_match_at(sig, data + offset)) return data + offset;
+        start = offset + 1;
+    }
+
+    return NULL;
+}
+
+#if defined(__aarch64__) || defined(__arm64__)
+static const uint8_t *sig_scan_neon(const struct sig_pattern *sig, const uint8_t *data, size_t count)
+{
+    const uint8x16_t first = vdupq_n_u8(sig->bytes[sig->anchor]);
+    const uint8x16_t second = vdupq_n_u8(sig->bytes[sig->anchor2]);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t a = vld1q_u8(data + i + sig->anchor);
+        uint8x16_t b = vld1q_u8(data + i + sig->anchor2);
+        uint8x16_t eq = vandq_u8(vceqq_u8(a, first), vceqq_u8(b, second));
+
+        // Narrow each 0x00/0xFF lane to a nibble, giving a 64-bit mask
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+
+        while (bits) {
+            int bit = __builtin_ctzll(bits) >> 2;
+            if (sig_match_at(sig, data + i + bit)) return data + i + bit;
+            bits &= ~(0xFULL << (bit << 2));
+        }
+    }
+
+    return sig_scan_scalar(sig, data, i, count);
+}
+#endif
+
+//
+// Returns the first offset in data at which the whole pattern matches and
+// fits inside size bytes, or NULL.
+//
+const uint8_t *sig_scan(const struct sig_pattern *sig, const uint8_t *data, size_t size)
+{
+    if (!sig->length || size < (size_t) sig->length) return NULL;
+    if (sig->anchor == -1) return data;
+
+    size_t count = size - sig->length + 1;
+
+#if defined(__aarch64__) || defined(__arm64__)
+    return sig_scan_neon(sig, data, count);
+#else
+    return sig_scan_scalar(sig, data, 0, count);
+#endif
+}
+
+//
+// NOTE: sig_scan_all() reads the union of the windows once, however many
+// signatures overlap there. Each target is keyed by its rarest pair of
+// adjacent bytes whose first byte is fixed, and gets one of eight bucket
+// bits. Four 16-entry nibble tables give, for a byte pair at a position, the
+// buckets of every target keyed by that pair. The merged range is walked in
+// SIG_BLOCK_SIZE blocks, with the tables built from the unresolved targets
+// whose window reaches the block; AVX2 looks up 32 positions at a time, and
+// SSSE3 or NEON 16. Other targets scan one signature at a time, as a scalar
+// sweep measured 5x slower than memchr() per signature. Only the targets in a hit bucket get the full masked compare there,
+// and only if the position falls in their window. Positions are visited in
+// address order, so each target still resolves to its first match. A target
+// drops out once it hits, and blocks no unresolved window reaches are
+// skipped. With more than eight targets in a block, buckets are shared and
+// the compare sorts them out. On the five Dock signatures in make bench-scan
+// this is 2.3x faster than scanning them one at a time.
+//
+
+#if defined(__x86_64__) || defined(__aarch64__) || defined(__arm64__)
+struct sig_sweep
+{
+    struct sig_target *targets;
+    int count;
+    int key[SIG_SET_MAX];           // Offset of each target's key pair in its pattern
+    int16_t bucket[8];              // First target in each bucket, or -1
+    int16_t next[SIG_SET_MAX];
+    uint8_t lo0[16], hi0[16];       // Buckets by nibble of the pair's first byte
+    uint8_t lo1[16], hi1[16];       // and of its second
+};
+
+// Candidate key positions of target i: [offset + key, offset + window + key)
+static inline uint64_t sig_key_start(const struct sig_sweep *sweep, int i)
+{
+    return sweep->targets[i].offset + sweep->key[i];
+}
+
+static inline uint64_t sig_key_end(const struct sig_sweep *sweep, int i)
+{
+    return sweep->targets[i].offset + sweep->targets[i].window + sweep->key[i];
+}
+
+static inline bool sig_pending(const struct sig_target *target)
+{
+    return target->hit == -1 && target->sig.length && target->window;
+}
+
+static int sig_key(const struct sig_pattern *sig)
+{
+    int best = sig->anchor;
+    int best_score = -1;
+
+    for (int i = 0; i + 1 < sig->length; ++i) {
+        if (!sig->mask[i]) continue;
+
+        int score = sig_byte_rarity(sig->bytes[i]) + (sig->mask[i + 1] ? sig_byte_rarity(sig->bytes[i + 1]) : 0);
+        if (score > best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+
+    return best;
+}
+
+// Tries every target in the buckets hit at position; returns how many hit
+static inline int sig_sweep_candidate(struct sig_sweep *sweep, const uint8_t *base, uint64_t position, uint8_t buckets)
+{
+    int resolved = 0;
+    while (buckets) {
+        int bucket = __builtin_ctz(buckets);
+        buckets &= buckets - 1;
+
+        for (int t = sweep->bucket[bucket]; t != -1; t = sweep->next[t]) {
+            struct sig_target *target = &sweep->targets[t];
+            if (target->hit != -1 || position < sig_key_start(sweep, t) || position >= sig_key_end(sweep, t)) continue;
+
+            uint64_t start = position - sweep->key[t];
+            if (sig_match_at(&target->sig, base + start)) {
+                target->hit = (int64_t) start;
+                ++resolved;
+            }
+        }
+    }
+    return resolved;
+}
+
+// Positions from here on only test the first byte of each pair, so the
+// byte after end is never read
+static int sig_sweep_tail(struct sig_sweep *sweep, const uint8_t *base, uint64_t position, uint64_t end)
+{
+    int resolved = 0;
+    for (; position < end; ++position) {
+        uint8_t byte = base[position];
+        uint8_t buckets = sweep->lo0[byte & 0xF] & sweep->hi0[byte >> 4];
+        if (buckets) resolved += sig_sweep_candidate(sweep, base, position, buckets);
+    }
+    return resolved;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static int sig_sweep_avx2(struct sig_sweep *sweep, const uint8_t *base, uint64_t position, uint64_t end)
+{
+    const __m256i lo0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) sweep->lo0));
+    const __m256i hi0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) sweep->hi0));
+    const __m256i lo1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) sweep->lo1));
+    const __m256i hi1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) sweep->hi1));
+    const __m256i nibble = _mm256_set1_epi8(0xF);
+    int resolved = 0;
+
+    // The second byte of the last position's pair must stay before end
+    for (; position + 32 < end; position += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(base + position));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(base + position + 1));
+        __m256i hits = _mm256_and_si256(
+            _mm256_and_si256(_mm256_shuffle_epi8(lo0, _mm256_and_si256(a, nibble)),
+                             _mm256_shuffle_epi8(hi0, _mm256_and_si256(_mm256_srli_epi16(a, 4), nibble))),
+            _mm256_and_si256(_mm256_shuffle_epi8(lo1, _mm256_and_si256(b, nibble)),
+                             _mm256_shuffle_epi8(hi1, _mm256_and_si256(_mm256_srli_epi16(b, 4), nibble))));
+        if (_mm256_testz_si256(hits, hits)) continue;
+
+        uint8_t buckets[32];
+        _mm256_storeu_si256((__m256i *) buckets, hits);
+        uint32_t bits = ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hits, _mm256_setzero_si256()));
+        while (bits) {
+            int lane = __builtin_ctz(bits);
+            resolved += sig_sweep_candidate(sweep, base, position + lane, buckets[lane]);
+            bits &= bits - 1;
+        }
+    }
+
+    return resolved + sig_sweep_tail(sweep, base, position, end);
+}
+
+__attribute__((target("ssse3")))
+static int sig_sweep_ssse3(struct sig_sweep *sweep, const uint8_t *base, uint64_t position, uint64_t end)
+{
+    const __m128i lo0 = _mm_loadu_si128((const __m128i *) sweep->lo0);
+    const __m128i hi0 = _mm_loadu_si128((const __m128i *) sweep->hi0);
+    const __m128i lo1 = _mm_loadu_si128((const __m128i *) sweep->lo1);
+    const __m128i hi1 = _mm_loadu_si128((const __m128i *) sweep->hi1);
+    const __m128i nibble = _mm_set1_epi8(0xF);
+    int resolved = 0;
+
+    for (; position + 16 < end; position += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(base + position));
+        __m128i b = _mm_loadu_si128((const __m128i *)(base + position + 1));
+        __m128i hits = _mm_and_si128(
+            _mm_and_si128(_mm_shuffle_epi8(lo0, _mm_and_si128(a, nibble)),
+                          _mm_shuffle_epi8(hi0, _mm_and_si128(_mm_srli_epi16(a, 4), nibble))),
+            _mm_and_si128(_mm_shuffle_epi8(lo1, _mm_and_si128(b, nibble)),
+                          _mm_shuffle_epi8(hi1, _mm_and_si128(_mm_srli_epi16(b, 4), nibble))));
+
+        uint32_t bits = (uint32_t)(~_mm_movemask_epi8(_mm_cmpeq_epi8(hits, _mm_setzero_si128())) & 0xFFFF);
+        if (!bits) continue;
+
+        uint8_t buckets[16];
+        _mm_storeu_si128((__m128i *) buckets, hits);
+        while (bits) {
+            int lane = __builtin_ctz(bits);
+            resolved += sig_sweep_candidate(sweep, base, position + lane, buckets[lane]);
+            bits &= bits - 1;
+        }
+    }
+
+    return resolved + sig_sweep_tail(sweep, base, position, end);
+}
+#elif defined(__aarch64__) || defined(__arm64__)
+static int sig_sweep_neon(struct sig_sweep *sweep, const uint8_t *base, uint64_t position, uint64_t end)
+{
+    const uint8x16_t lo0 = vld1q_u8(sweep->lo0);
+    const uint8x16_t hi0 = vld1q_u8(sweep->hi0);
+    const uint8x16_t lo1 = vld1q_u8(sweep->lo1);
+    const uint8x16_t hi1 = vld1q_u8(sweep->hi1);
+    const uint8x16_t nibble = vdupq_n_u8(0xF);
+    int resolved = 0;
+
+    // The second byte of the last position's pair must stay before end
+    for (; position + 16 < end; position += 16) {
+        uint8x16_t a = vld1q_u8(base + position);
+        uint8x16_t b = vld1q_u8(base + position + 1);
+        uint8x16_t hits = vandq_u8(vandq_u8(vqtbl1q_u8(lo0, vandq_u8(a, nibble)), vqtbl1q_u8(hi0, vshrq_n_u8(a, 4))),
+                                   vandq_u8(vqtbl1q_u8(lo1, vandq_u8(b, nibble)), vqtbl1q_u8(hi1, vshrq_n_u8(b, 4))));
+        if (!vmaxvq_u8(hits)) continue;
+
+        uint8_t buckets[16];
+        vst1q_u8(buckets, hits);
+        for (int lane = 0; lane < 16; ++lane) {
+            if (buckets[lane]) resolved += sig_sweep_candidate(sweep, base, position + lane, buckets[lane]);
+        }
+    }
+
+    return resolved + sig_sweep_tail(sweep, base, position, end);
+}
+#endif
+
+// Builds the bucket chains and nibble tables for the targets reaching
+// [start, end); returns the end of the part of the block they reach
+static uint64_t sig_sweep_block(struct sig_sweep *sweep, uint64_t start, uint64_t end)
+{
+    uint64_t reach = start;
+
+    memset(sweep->bucket, 0xFF, sizeof(sweep->bucket));
+    memset(sweep->lo0, 0, sizeof(sweep->lo0));
+    memset(sweep->hi0, 0, sizeof(sweep->hi0));
+    memset(sweep->lo1, 0, sizeof(sweep->lo1));
+    memset(sweep->hi1, 0, sizeof(sweep->hi1));
+
+    int active = 0;
+    for (int i = 0; i < sweep->count; ++i) {
+        const struct sig_target *target = &sweep->targets[i];
+        if (!sig_pending(target) || sig_key_start(sweep, i) >= end || sig_key_end(sweep, i) <= start) continue;
+
+        int bucket = active++ & 7;
+        uint8_t bit = (uint8_t)(1 << bucket);
+        sweep->next[i] = sweep->bucket[bucket];
+        sweep->bucket[bucket] = (int16_t) i;
+
+        int key = sweep->key[i];
+        uint8_t first = target->sig.bytes[key];
+        sweep->lo0[first & 0xF] |= bit;
+        sweep->hi0[first >> 4] |= bit;
+
+        if (key + 1 < target->sig.length && target->sig.mask[key + 1]) {
+            uint8_t second = target->sig.bytes[key + 1];
+            sweep->lo1[second & 0xF] |= bit;
+            sweep->hi1[second >> 4] |= bit;
+        } else {
+            for (int n = 0; n < 16; ++n) {
+                sweep->lo1[n] |= bit;
+                sweep->hi1[n] |= bit;
+            }
+        }
+
+        uint64_t target_end = sig_key_end(sweep, i) < end ? sig_key_end(sweep, i) : end;
+        if (target_end > reach) reach = target_end;
+    }
+
+    return reach;
+}
+
+// Resolves up to SIG_SET_MAX targets in one sweep; returns the bytes read
+static uint64_t sig_scan_set(struct sig_target *targets, int count, const uint8_t *base)
+{
+    struct sig_sweep sweep = { .targets = targets, .count = count };
+    int pending = 0;
+
+    for (int i = 0; i < count; ++i) {
+        if (!sig_pending(&targets[i])) continue;
+
+        // An all-wildcard pattern matches at once
+        if (targets[i].sig.anchor == -1) {
+            targets[i].hit = (int64_t) targets[i].offset;
+        } else {
+            sweep.key[i] = sig_key(&targets[i].sig);
+            ++pending;
+        }
+    }
+
+    uint64_t swept = 0;
+    uint64_t cursor = 0;
+
+    while (pending) {
+        // The next block starts at the lowest unresolved key position at or after the cursor
+        uint64_t start = UINT64_MAX;
+        for (int i = 0; i < count; ++i) {
+            if (!sig_pending(&targets[i]) || sig_key_end(&sweep, i) <= cursor) continue;
+
+            uint64_t key_start = sig_key_start(&sweep, i) > cursor ? sig_key_start(&sweep, i) : cursor;
+            if (key_start < start) start = key_start;
+        }
+
+        if (start == UINT64_MAX) break;
+
+        uint64_t end = sig_sweep_block(&sweep, start, start + SIG_BLOCK_SIZE);
+
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) {
+            pending -= sig_sweep_avx2(&sweep, base, start, end);
+        } else {
+            pending -= sig_sweep_ssse3(&sweep, base, start, end);
+        }
+#else
+        pending -= sig_sweep_neon(&sweep, base, start, end);
+#endif
+
+        swept += end - start;
+        cursor = end;
+    }
+
+    return swept;
+}
+#endif
+
+//
+// Resolves every target, each to its first match in its window or -1, and
+// returns the size of the address range swept: positions tested against the
+// set, each counted once, and stopping where the last target resolves. Bytes
+// a candidate compare reads past a position are not counted. The caller
+// guarantees [offset, offset + window + length - 1) is readable for every
+// target.
+//
+uint64_t sig_scan_all(struct sig_target *targets, int count, const uint8_t *base)
+{
+    uint64_t swept = 0;
+    for (int i = 0; i < count; ++i) targets[i].hit = -1;
+
+#if defined(__x86_64__) || defined(__aarch64__) || defined(__arm64__)
+    for (int i = 0; i < count; i += SIG_SET_MAX) {
+        swept += sig_scan_set(targets + i, count - i < SIG_SET_MAX ? count - i : SIG_SET_MAX, base);
+    }
+#else
+    // Without a byte shuffle the sweep loses to memchr per signature
+    for (int i = 0; i < count; ++i) {
+        if (!targets[i].sig.length || !targets[i].window) continue;
+
+        size_t size = targets[i].window + targets[i].sig.length - 1;
+        const uint8_t *match = sig_scan(&targets[i].sig, base + targets[i].offset, size);
+        if (match) targets[i].hit = match - base;
+        swept += size;
+    }
+#endif
+
+    return swept;
+}
+#endif
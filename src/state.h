@@ -0,0 +1,152 @@
+#ifndef SA_STATE_H
+#define SA_STATE_H
+
+//
+// Shared state page published by the payload.
+//
+// The payload maps a file next to its socket (<socket path>.state) and
+// writes what it learns about windows and displays into it as it executes
+// requests. Clients map the same file read-only and answer queries from it
+// without a round trip, as long as the value is younger than the bound they
+// asked for.
+//
+// Requires common.h (for struct sa_window_record).
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#define SA_STATE_PATH_FMT           "%s.state"
+#define SA_STATE_MAGIC              0x5353534D  // "MSSS"
+#define SA_STATE_VERSION            3
+
+// Window slots; a power of two
+#define SA_STATE_WINDOW_SHIFT       13
+#define SA_STATE_WINDOW_MAX         (1u << SA_STATE_WINDOW_SHIFT)
+#define SA_STATE_PROBE_MAX          64      // Slots probed from a wid's home before giving up
+#define SA_STATE_TOMBSTONE          0xFFFFFFFFu // wid of a slot given back by a closed window
+#define SA_STATE_DISPLAY_MAX        32
+
+// Parts of a window entry's record that are known; bit i is timed by updated[i]
+#define SA_STATE_ORIGIN             0x01    // x, y
+#define SA_STATE_SIZE               0x02    // width, height
+#define SA_STATE_ALPHA              0x04
+#define SA_STATE_LEVEL              0x08
+#define SA_STATE_TAGS               0x10
+#define SA_STATE_ORDERED            0x20
+#define SA_STATE_FRAME              (SA_STATE_ORIGIN | SA_STATE_SIZE)
+#define SA_STATE_ALL                0x3F
+#define SA_STATE_FIELD_COUNT        6
+
+// Window entry flags
+#define SA_STATE_WATCHED            0x01    // The payload hears when the window moves, resizes or is ordered
+
+//
+// NOTE: Every window entry and the display section carry their own seqlock
+// sequence. A writer makes it odd, changes the entry and makes it even again;
+// a reader copies the entry and retries if the sequence was odd or changed
+// meanwhile. Readers never block writers, and the payload's threads never
+// write the same entry at once because they take the odd sequence with a
+// compare-and-swap. A window is given a slot once the payload knows it
+// exists. The slot is claimed by setting wid and is found by linear probing
+// from the wid's hash, at most SA_STATE_PROBE_MAX slots away. When the window closes its slot becomes a tombstone, which lookups
+// step over and later claims reuse, and a run of tombstones ending at a free
+// slot is freed outright. If every slot within reach of its home is taken,
+// the window gets none: nothing about it is published and every query
+// about it goes to the window server, but other windows are unaffected.
+// Readers compare the copied wid with the one they looked for, since a slot
+// can change hands between the lookup and the read.
+//
+// updated holds, per field, the CLOCK_MONOTONIC time at which the payload
+// last learned it, so readers can bound how stale an answer may be. Changes
+// made behind the payload's back are not seen until it learns of them; for
+// a watched window, the payload drops frame and ordering fields as soon as
+// the window server reports a change to them.
+//
+
+struct sa_state_window
+{
+    uint32_t wid;                   // 0 while the slot is free, SA_STATE_TOMBSTONE once given back
+    uint32_t sequence;
+    uint32_t fields;                // SA_STATE_* field bits
+    uint32_t flags;                 // SA_STATE_WATCHED
+    uint64_t updated[SA_STATE_FIELD_COUNT];
+    struct sa_window_record record;
+};
+
+struct sa_state_displays
+{
+    uint32_t sequence;
+    uint32_t count;
+    uint64_t updated;
+    uint32_t ids[SA_STATE_DISPLAY_MAX];
+    uint64_t spaces[SA_STATE_DISPLAY_MAX];  // Current space of each display
+};
+
+// The payload writes magic last, once the rest is initialised
+struct sa_state
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t window_capacity;
+    uint32_t reserved;
+    struct sa_state_displays displays;
+    struct sa_state_window windows[SA_STATE_WINDOW_MAX];
+};
+
+static inline uint64_t sa_state_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+static inline uint32_t sa_state_home(uint32_t wid)
+{
+    return (uint32_t)(wid * 0x9E3779B9u) >> (32 - SA_STATE_WINDOW_SHIFT);
+}
+
+// Returns the slot holding wid, or NULL if it has none
+static inline struct sa_state_window *sa_state_window_find(struct sa_state *state, uint32_t wid)
+{
+    if (!wid || wid == SA_STATE_TOMBSTONE) return NULL;
+
+    uint32_t home = sa_state_home(wid);
+    for (uint32_t i = 0; i < SA_STATE_PROBE_MAX; ++i) {
+        struct sa_state_window *entry = &state->windows[(home + i) & (SA_STATE_WINDOW_MAX - 1)];
+        uint32_t key = __atomic_load_n(&entry->wid, __ATOMIC_ACQUIRE);
+        if (key == wid) return entry;
+        if (key == 0) return NULL;
+    }
+    return NULL;
+}
+
+// Oldest time at which any of fields was learned
+static inline uint64_t sa_state_window_learned(const struct sa_state_window *entry, uint32_t fields)
+{
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < SA_STATE_FIELD_COUNT; ++i) {
+        if ((fields & (1u << i)) && entry->updated[i] < oldest) oldest = entry->updated[i];
+    }
+    return oldest;
+}
+
+// Copies a consistent snapshot of size bytes at data, guarded by sequence;
+// gives up and returns false if a writer keeps it busy
+static inline bool sa_state_read(const uint32_t *sequence, const void *data, void *out, size_t size)
+{
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        uint32_t begin = __atomic_load_n(sequence, __ATOMIC_ACQUIRE);
+        if (begin & 1) continue;
+
+        memcpy(out, data, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(sequence, __ATOMIC_RELAXED) == begin) return true;
+    }
+    return false;
+}
+
+#endif
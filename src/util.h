@@ -20,7 +20,10 @@ static inline bool socket_connect(int sockfd, char *socket_path)
     struct sockaddr_un socket_address;
     socket_address.sun_family = AF_UNIX;
 
-    snprintf(socket_address.sun_path, sizeof(socket_address.sun_path), "%s", socket_path);
+    size_t length = strlen(socket_path);
+    if (length >= sizeof(socket_address.sun_path)) return false;
+
+    memcpy(socket_address.sun_path, socket_path, length + 1);
     return connect(sockfd, (struct sockaddr *) &socket_address, sizeof(socket_address)) != -1;
 }
 
@@ -30,6 +33,43 @@ static inline void socket_close(int sockfd)
     close(sockfd);
 }
 
+// A dead peer must surface as an error, not as SIGPIPE in the host process
+static inline void socket_set_nosigpipe(int sockfd)
+{
+#ifdef SO_NOSIGPIPE
+    int value = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+#else
+    (void) sockfd;
+#endif
+}
+
+static inline bool socket_send_all(int sockfd, const void *bytes, size_t length)
+{
+    size_t sent = 0;
+    while (sent < length) {
+#ifdef MSG_NOSIGNAL
+        ssize_t result = send(sockfd, (const char *) bytes + sent, length - sent, MSG_NOSIGNAL);
+#else
+        ssize_t result = send(sockfd, (const char *) bytes + sent, length - sent, 0);
+#endif
+        if (result <= 0) return false;
+        sent += result;
+    }
+    return true;
+}
+
+static inline bool socket_recv_all(int sockfd, void *bytes, size_t length)
+{
+    size_t received = 0;
+    while (received < length) {
+        ssize_t result = recv(sockfd, (char *) bytes + received, length - received, 0);
+        if (result <= 0) return false;
+        received += result;
+    }
+    return true;
+}
+
 // System utilities
 static inline bool is_root(void)
 {
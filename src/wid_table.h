@@ -0,0 +1,199 @@
+#ifndef WID_TABLE_H
+#define WID_TABLE_H
+
+//
+// Flat open-addressing hash table keyed by uint32_t window id.
+//
+// Slots live in one power-of-two array and hold the key, its probe distance
+// and the value inline, so lookups walk contiguous memory and inserts never
+// allocate except when the whole array grows. Collisions are resolved with
+// Robin Hood hashing and removals use backward-shift deletion, which keeps
+// probe sequences short without tombstones.
+//
+// Unlike hashtable.h, keys are taken by value and values are stored by copy
+// (value_size bytes), so nothing has to outlive the call. Pointers returned by
+// wid_table_find() and wid_table_add() are only valid until the next
+// add or remove, since both may move slots.
+//
+
+struct wid_table
+{
+    int count;
+    int capacity;
+    int value_size;
+    int slot_size;
+    int shift;
+    char *slots;
+};
+
+void wid_table_init(struct wid_table *table, int capacity, int value_size);
+void wid_table_free(struct wid_table *table);
+void wid_table_clear(struct wid_table *table);
+
+void *wid_table_add(struct wid_table *table, uint32_t wid, const void *value);
+void wid_table_remove(struct wid_table *table, uint32_t wid);
+void *wid_table_find(struct wid_table *table, uint32_t wid);
+
+struct wid_slot
+{
+    uint32_t wid;
+    uint32_t dist;
+};
+
+#define wid_slot_at(table, i) ((struct wid_slot *)((table).slots + (size_t)(i) * (table).slot_size))
+#define wid_slot_value(slot) ((void *)((char *)(slot) + sizeof(struct wid_slot)))
+
+// Runs the statement that follows for every occupied slot, named by slot:
+//
+//     wid_table_for(slot, table) use(slot->wid, wid_slot_value(slot));
+//
+#define wid_table_for(slot, table) \
+    for (struct wid_slot *slot = wid_slot_at(table, 0), *slot##_end = wid_slot_at(table, (table).capacity); \
+         slot != slot##_end; slot = (struct wid_slot *)((char *) slot + (table).slot_size)) \
+        if (slot->dist)
+
+#endif
+
+#ifdef WID_TABLE_IMPLEMENTATION
+static inline uint32_t wid_table_home(struct wid_table *table, uint32_t wid)
+{
+    return (uint32_t)(wid * 0x9E3779B9u) >> table->shift;
+}
+
+static void wid_table_alloc(struct wid_table *table, int capacity)
+{
+    int shift = 32;
+    while ((1 << (32 - shift)) < capacity) --shift;
+
+    table->count = 0;
+    table->capacity = 1 << (32 - shift);
+    table->shift = shift;
+    table->slots = calloc(table->capacity, table->slot_size);
+}
+
+void wid_table_init(struct wid_table *table, int capacity, int value_size)
+{
+    table->value_size = value_size;
+    table->slot_size = (int)((sizeof(struct wid_slot) + value_size + 7) & ~7);
+    wid_table_alloc(table, capacity < 8 ? 8 : capacity);
+}
+
+void wid_table_free(struct wid_table *table)
+{
+    if (table->slots) {
+        free(table->slots);
+        table->slots = NULL;
+    }
+}
+
+void wid_table_clear(struct wid_table *table)
+{
+    memset(table->slots, 0, (size_t) table->capacity * table->slot_size);
+    table->count = 0;
+}
+
+static void *wid_table_insert(struct wid_table *table, void *incoming)
+{
+    uint64_t swap[table->slot_size / sizeof(uint64_t)];
+    uint32_t mask = table->capacity - 1;
+    uint32_t pos = wid_table_home(table, ((struct wid_slot *) incoming)->wid);
+    void *result = NULL;
+
+    for (;;) {
+        struct wid_slot *slot = wid_slot_at(*table, pos);
+
+        if (!slot->dist) {
+            memcpy(slot, incoming, table->slot_size);
+            ++table->count;
+            return result ? result : wid_slot_value(slot);
+        }
+
+        if (slot->dist < ((struct wid_slot *) incoming)->dist) {
+            memcpy(swap, slot, table->slot_size);
+            memcpy(slot, incoming, table->slot_size);
+            memcpy(incoming, swap, table->slot_size);
+            if (!result) result = wid_slot_value(slot);
+        }
+
+        pos = (pos + 1) & mask;
+        ++((struct wid_slot *) incoming)->dist;
+    }
+}
+
+static void wid_table_grow(struct wid_table *table)
+{
+    char *old_slots = table->slots;
+    int old_capacity = table->capacity;
+
+    wid_table_alloc(table, 2 * old_capacity);
+
+    for (int i = 0; i < old_capacity; ++i) {
+        struct wid_slot *slot = (struct wid_slot *)(old_slots + (size_t) i * table->slot_size);
+        if (!slot->dist) continue;
+
+        slot->dist = 1;
+        wid_table_insert(table, slot);
+    }
+
+    free(old_slots);
+}
+
+static int wid_table_find_pos(struct wid_table *table, uint32_t wid)
+{
+    uint32_t mask = table->capacity - 1;
+    uint32_t pos = wid_table_home(table, wid);
+
+    for (uint32_t dist = 1;; ++dist) {
+        struct wid_slot *slot = wid_slot_at(*table, pos);
+        if (slot->dist < dist) return -1;
+        if (slot->wid == wid) return (int) pos;
+        pos = (pos + 1) & mask;
+    }
+}
+
+void *wid_table_add(struct wid_table *table, uint32_t wid, const void *value)
+{
+    int pos = wid_table_find_pos(table, wid);
+    if (pos != -1) return wid_slot_value(wid_slot_at(*table, pos));
+
+    if (8 * (table->count + 1) > 7 * table->capacity) {
+        wid_table_grow(table);
+    }
+
+    uint64_t incoming[table->slot_size / sizeof(uint64_t)];
+    struct wid_slot header = { .wid = wid, .dist = 1 };
+    memset(incoming, 0, table->slot_size);
+    memcpy(incoming, &header, sizeof(header));
+    if (value) memcpy(wid_slot_value(incoming), value, table->value_size);
+
+    return wid_table_insert(table, incoming);
+}
+
+void wid_table_remove(struct wid_table *table, uint32_t wid)
+{
+    int pos = wid_table_find_pos(table, wid);
+    if (pos == -1) return;
+
+    uint32_t mask = table->capacity - 1;
+    uint32_t hole = pos;
+
+    for (;;) {
+        uint32_t next = (hole + 1) & mask;
+        struct wid_slot *slot = wid_slot_at(*table, next);
+        if (slot->dist <= 1) break;
+
+        memcpy(wid_slot_at(*table, hole), slot, table->slot_size);
+        --wid_slot_at(*table, hole)->dist;
+        hole = next;
+    }
+
+    memset(wid_slot_at(*table, hole), 0, table->slot_size);
+    --table->count;
+}
+
+void *wid_table_find(struct wid_table *table, uint32_t wid)
+{
+    int pos = wid_table_find_pos(table, wid);
+    return pos == -1 ? NULL : wid_slot_value(wid_slot_at(*table, pos));
+}
+#endif
@@ -0,0 +1,401 @@
+/**
+ * dockscan - run the Dock signature table against a Mach-O file offline
+ *
+ * Maps a Dock binary (thin or fat), picks the x86_64 or arm64 slice, finds
+ * __TEXT from the load commands and resolves signatures with the same
+ * scanner, table and ADRP/ADD decoding the payload uses. Runs on Linux, so
+ * signatures can be validated and benchmarked without a Mac.
+ *
+ * Build:
+ *   make dockscan
+ *
+ * Usage:
+ *   dockscan [-a x86_64|arm64] [-m <macos>] [-p <offset> <pattern>] <binary>
+ *
+ *   -a   slice to use (default: arm64 if present, else x86_64)
+ *   -m   resolve the row for one macOS version, e.g. 15.4, as the payload
+ *        would; without it every row for the slice is tried
+ *   -p   scan a single ad-hoc pattern instead of the table
+ *
+ * The closing line reports the address range swept, as sig_scan_all()
+ * counts it: with -m or -p once for the whole set, otherwise summed over
+ * the rows, since each row is a sweep of its own.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SIGSCAN_IMPLEMENTATION
+#include "sigscan.h"
+#undef SIGSCAN_IMPLEMENTATION
+
+#define DOCK_SIGNATURE_IMPLEMENTATION
+#include "dock_signature.h"
+#undef DOCK_SIGNATURE_IMPLEMENTATION
+#include "dock_signatures.h"
+
+#define WINDOW 0x1286a0
+
+// Minimal Mach-O definitions so this builds without the macOS SDK
+#define MACHO_MAGIC_64      0xfeedfacf
+#define MACHO_FAT_MAGIC     0xcafebabe
+#define MACHO_FAT_MAGIC_64  0xcafebabf
+#define MACHO_LC_SEGMENT_64 0x19
+#define MACHO_LC_UUID       0x1b
+#define MACHO_CPU_X86_64    0x01000007
+#define MACHO_CPU_ARM64     0x0100000c
+
+struct macho_header
+{
+    uint32_t magic;
+    int32_t cputype;
+    int32_t cpusubtype;
+    uint32_t filetype;
+    uint32_t ncmds;
+    uint32_t sizeofcmds;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+struct macho_load_command
+{
+    uint32_t cmd;
+    uint32_t cmdsize;
+};
+
+struct macho_segment
+{
+    uint32_t cmd;
+    uint32_t cmdsize;
+    char segname[16];
+    uint64_t vmaddr;
+    uint64_t vmsize;
+    uint64_t fileoff;
+    uint64_t filesize;
+};
+
+struct slice
+{
+    const char *arch;
+    const uint8_t *bytes;
+    uint64_t size;
+    const uint8_t *uuid;
+    uint64_t text_vmaddr;
+    uint64_t text_fileoff;
+    uint64_t text_filesize;
+};
+
+static uint32_t read_be32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static uint64_t read_be64(const uint8_t *p)
+{
+    return ((uint64_t) read_be32(p) << 32) | read_be32(p + 4);
+}
+
+static const char *cpu_arch(int32_t cputype)
+{
+    if (cputype == MACHO_CPU_X86_64) return "x86_64";
+    if (cputype == MACHO_CPU_ARM64) return "arm64";
+    return NULL;
+}
+
+static bool parse_slice(struct slice *slice, const uint8_t *bytes, uint64_t size)
+{
+    struct macho_header header;
+    if (size < sizeof(header)) return false;
+
+    memcpy(&header, bytes, sizeof(header));
+    if (header.magic != MACHO_MAGIC_64 || sizeof(header) + header.sizeofcmds > size) return false;
+
+    memset(slice, 0, sizeof(struct slice));
+    slice->arch = cpu_arch(header.cputype);
+    slice->bytes = bytes;
+    slice->size = size;
+
+    const uint8_t *cursor = bytes + sizeof(header);
+    const uint8_t *end = cursor + header.sizeofcmds;
+    bool found_text = false;
+
+    for (uint32_t i = 0; i < header.ncmds && cursor + sizeof(struct macho_load_command) <= end; ++i) {
+        struct macho_load_command command;
+        memcpy(&command, cursor, sizeof(command));
+        if (command.cmdsize < sizeof(command) || cursor + command.cmdsize > end) break;
+
+        if (command.cmd == MACHO_LC_SEGMENT_64 && command.cmdsize >= sizeof(struct macho_segment)) {
+            struct macho_segment segment;
+            memcpy(&segment, cursor, sizeof(segment));
+            if (strncmp(segment.segname, "__TEXT", sizeof(segment.segname)) == 0) {
+                slice->text_vmaddr = segment.vmaddr;
+                slice->text_fileoff = segment.fileoff;
+                slice->text_filesize = segment.filesize;
+                found_text = true;
+            }
+        } else if (command.cmd == MACHO_LC_UUID && command.cmdsize >= sizeof(command) + 16) {
+            slice->uuid = cursor + sizeof(command);
+        }
+
+        cursor += command.cmdsize;
+    }
+
+    return found_text && slice->arch && slice->text_fileoff < size;
+}
+
+static bool find_slice(struct slice *slice, const uint8_t *bytes, uint64_t size, const char *arch)
+{
+    if (size < 8) return false;
+
+    uint32_t magic = read_be32(bytes);
+    if (magic != MACHO_FAT_MAGIC && magic != MACHO_FAT_MAGIC_64) {
+        return parse_slice(slice, bytes, size) && (!arch || strcmp(slice->arch, arch) == 0);
+    }
+
+    bool wide = magic == MACHO_FAT_MAGIC_64;
+    uint32_t count = read_be32(bytes + 4);
+    uint64_t entry_size = wide ? 32 : 20;
+    bool found = false;
+
+    for (uint32_t i = 0; i < count && 8 + (i + 1) * entry_size <= size; ++i) {
+        const uint8_t *entry = bytes + 8 + i * entry_size;
+        const char *entry_arch = cpu_arch((int32_t) read_be32(entry));
+        if (!entry_arch) continue;
+
+        uint64_t offset = wide ? read_be64(entry + 8) : read_be32(entry + 8);
+        uint64_t length = wide ? read_be64(entry + 16) : read_be32(entry + 12);
+        if (offset > size || length > size - offset) continue;
+
+        if (arch && strcmp(entry_arch, arch) != 0) continue;
+
+        // Without -a prefer arm64, but fall back to whatever slice parses
+        struct slice candidate;
+        if (!parse_slice(&candidate, bytes + offset, length)) continue;
+        if (!found || strcmp(candidate.arch, "arm64") == 0) {
+            *slice = candidate;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+//
+// NOTE: Offsets are relative to the __TEXT vmaddr, exactly like the payload's
+// offsets from the slid image base. The payload may read past __TEXT into
+// the following segments, so windows are only clamped to the end of the
+// slice.
+//
+static uint64_t clamp_window(struct slice *slice, struct sig_target *target)
+{
+    uint64_t available = slice->size - slice->text_fileoff;
+    uint64_t length = target->sig.length;
+
+    if (target->offset + length > available) {
+        target->window = 0;
+    } else if (target->offset + target->window + length - 1 > available) {
+        target->window = available - target->offset - length + 1;
+    }
+
+    return target->window;
+}
+
+static void print_hit(struct slice *slice, struct sig_target *target, int symbol)
+{
+    if (target->hit == -1) {
+        printf("  %-16s +0x%-9llx %-12s\n", target->name, (unsigned long long) target->offset, "-");
+        return;
+    }
+
+    const uint8_t *text = slice->bytes + slice->text_fileoff;
+    printf("  %-16s +0x%-9llx +0x%-10llx", target->name, (unsigned long long) target->offset, (unsigned long long) target->hit);
+
+    if (symbol == DOCK_SYMBOL_SPACES || symbol == DOCK_SYMBOL_DPPM) {
+        uint64_t hit = (uint64_t) target->hit;
+        if (strcmp(slice->arch, "arm64") == 0 && hit + 8 <= slice->size - slice->text_fileoff) {
+            uint64_t resolved = decode_adrp_add((uint64_t)(uintptr_t)(text + hit), hit);
+            printf(" -> +0x%llx", (unsigned long long) resolved);
+        } else if (strcmp(slice->arch, "x86_64") == 0 && hit + 4 <= slice->size - slice->text_fileoff) {
+            int32_t displacement;
+            memcpy(&displacement, text + hit, sizeof(displacement));
+            printf(" -> +0x%llx", (unsigned long long)(hit + 4 + displacement));
+        }
+    }
+
+    printf("\n");
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-a x86_64|arm64] [-m <macos>] [-p <offset> <pattern>] <binary>\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *arch = NULL;
+    const char *macos = NULL;
+    const char *adhoc_offset = NULL;
+    const char *adhoc_pattern = NULL;
+    const char *file = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            arch = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            macos = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0 && i + 2 < argc) {
+            adhoc_offset = argv[++i];
+            adhoc_pattern = argv[++i];
+        } else if (argv[i][0] != '-' && !file) {
+            file = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!file) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int fd = open(file, O_RDONLY);
+    if (fd == -1) {
+        perror(file);
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        fprintf(stderr, "%s: empty or unreadable\n", file);
+        close(fd);
+        return 1;
+    }
+
+    const uint8_t *bytes = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (bytes == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    struct slice slice;
+    if (!find_slice(&slice, bytes, st.st_size, arch)) {
+        fprintf(stderr, "%s: no 64-bit %s Mach-O slice with a __TEXT segment\n", file, arch ? arch : "x86_64/arm64");
+        return 1;
+    }
+
+    printf("%s: %s slice, %llu bytes\n", file, slice.arch, (unsigned long long) slice.size);
+    if (slice.uuid) {
+        printf("  uuid   ");
+        for (int i = 0; i < 16; ++i) printf("%02X%s", slice.uuid[i], (i == 3 || i == 5 || i == 7 || i == 9) ? "-" : "");
+        printf("\n");
+    }
+    printf("  __TEXT vmaddr 0x%llx fileoff 0x%llx filesize 0x%llx\n\n",
+           (unsigned long long) slice.text_vmaddr, (unsigned long long) slice.text_fileoff, (unsigned long long) slice.text_filesize);
+
+    const struct dock_signature *table = dock_signatures_arm64;
+    int table_count = sizeof(dock_signatures_arm64) / sizeof(*dock_signatures_arm64);
+    if (strcmp(slice.arch, "x86_64") == 0) {
+        table = dock_signatures_x86_64;
+        table_count = sizeof(dock_signatures_x86_64) / sizeof(*dock_signatures_x86_64);
+    }
+
+    const uint8_t *text = slice.bytes + slice.text_fileoff;
+    struct sig_target targets[DOCK_SYMBOL_COUNT];
+    int symbols[DOCK_SYMBOL_COUNT];
+    int count = 0;
+    uint64_t swept = 0;
+    double start, elapsed;
+
+    if (adhoc_pattern) {
+        memset(targets, 0, sizeof(targets));
+        targets[0].name = "pattern";
+        targets[0].offset = strtoull(adhoc_offset, NULL, 0);
+        targets[0].window = WINDOW;
+        if (!sig_parse(&targets[0].sig, adhoc_pattern)) {
+            fprintf(stderr, "malformed pattern: %s\n", adhoc_pattern);
+            return 1;
+        }
+
+        symbols[0] = -1;
+        count = clamp_window(&slice, &targets[0]) ? 1 : 0;
+    } else if (macos) {
+        char *end;
+        long major = strtol(macos, &end, 10);
+        long minor = *end == '.' ? strtol(end + 1, NULL, 10) : 0;
+
+        memset(targets, 0, sizeof(targets));
+        for (int i = 0; i < DOCK_SYMBOL_COUNT; ++i) {
+            const struct dock_signature *signature = dock_signature_lookup(table, table_count, i, major, minor);
+            if (!signature) {
+                printf("  %-16s no signature for macOS %ld.%ld\n", dock_symbol_name[i], major, minor);
+                continue;
+            }
+
+            targets[count].name = dock_symbol_name[i];
+            targets[count].offset = signature->offset;
+            targets[count].window = WINDOW;
+            targets[count].sig = signature->pattern;
+            symbols[count] = i;
+            if (clamp_window(&slice, &targets[count])) ++count;
+        }
+    }
+
+    if (adhoc_pattern || macos) {
+        start = now_ms();
+        swept = sig_scan_all(targets, count, text);
+        elapsed = now_ms() - start;
+
+        printf("  %-16s %-11s %-12s\n", "symbol", "window", "hit");
+        for (int i = 0; i < count; ++i) {
+            print_hit(&slice, &targets[i], symbols[i]);
+        }
+    } else {
+        //
+        // NOTE: Without a version every row is scanned on its own, which shows
+        // which macOS releases' signatures this binary satisfies.
+        //
+        printf("  %-6s %-16s %-11s %-12s\n", "macos", "symbol", "window", "hit");
+        start = now_ms();
+        for (int i = 0; i < table_count; ++i) {
+            const struct dock_signature *signature = &table[i];
+            struct sig_target target = {
+                .name = dock_symbol_name[signature->symbol],
+                .offset = signature->offset,
+                .window = WINDOW,
+                .sig = signature->pattern,
+            };
+
+            if (!clamp_window(&slice, &target)) continue;
+            swept += sig_scan_all(&target, 1, text);
+
+            char version[16];
+            snprintf(version, sizeof(version), signature->match == DOCK_VERSION_ANY ? "%d" :
+                                               signature->match == DOCK_VERSION_EXACT ? "%d.%d" : "%d.%d+",
+                     signature->major, signature->minor);
+            printf("  %-6s", version);
+            print_hit(&slice, &target, signature->symbol);
+        }
+        elapsed = now_ms() - start;
+    }
+
+    printf("\nswept 0x%llx bytes of address range in %.3f ms\n", (unsigned long long) swept, elapsed);
+    munmap((void *) bytes, st.st_size);
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * mssd - stand-in payload daemon backed by the in-memory compositor
+ *
+ * Serves the payload's wire protocol on the same socket the payload uses
+ * (/tmp/mss_<user>.socket), with the payload's own listener, dispatch,
+ * batching, transaction and fade code from src/daemon.c. Window, space and
+ * display state comes from src/fake_backend.c, so every query is answered
+ * with the real byte layout. Lets the client library be exercised and
+ * benchmarked end to end without SIP changes, on macOS or Linux.
+ *
+ * Build:
+ *   make mssd
+ *
+ * Usage:
+ *   mssd [-s <socket>] [-w <windows>] [-d <displays>] [-n <spaces per display>] [-u <rate>]
+ *
+ *   -s   socket path (default: /tmp/mss_$USER.socket)
+ *   -w   number of windows, with ids 1..n (default: 256)
+ *   -d   number of displays (default: 1)
+ *   -n   spaces per display (default: 4)
+ *   -u   simulate a user dragging and resizing windows, rate changes a
+ *        second (default: 0), to exercise subscriptions
+ */
+
+#include <signal.h>
+
+#include "daemon.c"
+#include "fake_backend.c"
+
+static int user_windows;
+static int user_rate;
+
+// Nudges a random window every tick; every eighth change also resizes it
+static void *user_thread_proc(void *unused)
+{
+    (void) unused;
+
+    for (unsigned tick = 0;; ++tick) {
+        uint32_t wid = 1 + (uint32_t) rand() % user_windows;
+
+        struct fake_window window;
+        if (fake_window_state(wid, &window)) {
+            struct backend_rect frame = window.frame;
+            frame.x += rand() % 21 - 10;
+            frame.y += rand() % 21 - 10;
+            if (tick % 8 == 0) frame.width += rand() % 21 - 10;
+            fake_user_set_frame(wid, frame);
+        }
+
+        usleep(1000000 / user_rate);
+    }
+
+    return NULL;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-s <socket>] [-w <windows>] [-d <displays>] [-n <spaces per display>] [-u <rate>]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *socket_path = NULL;
+    int windows = 256;
+    int displays = 1;
+    int spaces = 4;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            windows = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            displays = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            spaces = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            user_rate = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    char socket_file[255];
+    if (!socket_path) {
+        const char *user = getenv("USER");
+        if (!user) {
+            fprintf(stderr, "could not get 'env USER'! abort..\n");
+            return 1;
+        }
+
+        snprintf(socket_file, sizeof(socket_file), SA_SOCKET_PATH_FMT, user);
+        socket_path = socket_file;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    fake_backend_init(windows, displays, spaces);
+    if (!daemon_listen(socket_path)) {
+        perror(socket_path);
+        return 1;
+    }
+
+    daemon_start(&fake_backend, true);
+    printf("mssd: %d windows, %d display(s), %d spaces each, listening on %s\n", windows, displays, spaces, socket_path);
+    fflush(stdout);
+
+    if (user_rate > 0 && windows > 0) {
+        user_windows = windows;
+        pthread_t user_thread;
+        pthread_create(&user_thread, NULL, &user_thread_proc, NULL);
+    }
+
+    pthread_join(daemon_thread, NULL);
+    return 0;
+}
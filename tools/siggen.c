@@ -0,0 +1,262 @@
+/**
+ * siggen - compile src/signatures.txt into pre-parsed signature tables
+ *
+ * Every pattern is parsed with the same sig_parse() the scanner uses and
+ * emitted as a struct dock_signature initializer with its bytes, mask and
+ * anchors filled in. Any malformed row is reported as file:line and fails
+ * the build.
+ *
+ * Build:
+ *   make (runs automatically as part of the payload build)
+ *
+ * Usage:
+ *   siggen <signatures.txt> <dock_signatures.h>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#define SIGSCAN_IMPLEMENTATION
+#include "sigscan.h"
+#undef SIGSCAN_IMPLEMENTATION
+
+static const char *archs[] = { "x86_64", "arm64" };
+
+struct row
+{
+    int line;
+    int arch;
+    char symbol[64];
+    int major;
+    int minor;
+    const char *match;
+    uint64_t offset;
+    struct sig_pattern sig;
+};
+
+static const char *path;
+static int errors;
+
+static void error(int line, const char *message, const char *detail)
+{
+    fprintf(stderr, "%s:%d: error: %s%s%s\n", path, line, message, detail ? ": " : "", detail ? detail : "");
+    ++errors;
+}
+
+static char *next_field(char **cursor)
+{
+    while (**cursor == ' ' || **cursor == '\t') ++*cursor;
+    if (!**cursor) return NULL;
+
+    char *field = *cursor;
+    while (**cursor && **cursor != ' ' && **cursor != '\t') ++*cursor;
+    if (**cursor) *(*cursor)++ = '\0';
+    return field;
+}
+
+static bool parse_version(struct row *row, const char *text)
+{
+    char *end;
+    row->major = (int) strtol(text, &end, 10);
+    if (end == text || row->major <= 0) return false;
+
+    if (*end == '\0') {
+        row->minor = 0;
+        row->match = "DOCK_VERSION_ANY";
+        return true;
+    }
+
+    if (*end != '.') return false;
+
+    const char *minor = end + 1;
+    row->minor = (int) strtol(minor, &end, 10);
+    if (end == minor || row->minor < 0) return false;
+
+    if (*end == '\0') {
+        row->match = "DOCK_VERSION_EXACT";
+    } else if (end[0] == '+' && end[1] == '\0') {
+        row->match = "DOCK_VERSION_AT_LEAST";
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+static bool parse_row(struct row *row, char *text, int line)
+{
+    char *cursor = text;
+    char *arch = next_field(&cursor);
+    char *symbol = next_field(&cursor);
+    char *version = next_field(&cursor);
+    char *offset = next_field(&cursor);
+
+    while (*cursor == ' ' || *cursor == '\t') ++cursor;
+    char *pattern = cursor;
+
+    if (!arch || !symbol || !version || !offset || !*pattern) {
+        error(line, "expected: arch symbol macos offset pattern", NULL);
+        return false;
+    }
+
+    memset(row, 0, sizeof(struct row));
+    row->line = line;
+    row->arch = -1;
+
+    for (int i = 0; i < (int)(sizeof(archs) / sizeof(*archs)); ++i) {
+        if (strcmp(arch, archs[i]) == 0) row->arch = i;
+    }
+
+    if (row->arch == -1) {
+        error(line, "unknown arch", arch);
+        return false;
+    }
+
+    if (strlen(symbol) >= sizeof(row->symbol)) {
+        error(line, "symbol name too long", symbol);
+        return false;
+    }
+
+    for (char *c = symbol; *c; ++c) {
+        if (!islower((unsigned char) *c) && *c != '_') {
+            error(line, "symbol must be lower_snake_case", symbol);
+            return false;
+        }
+        row->symbol[c - symbol] = (char) toupper((unsigned char) *c);
+    }
+
+    if (!parse_version(row, version)) {
+        error(line, "malformed macOS version (expected 15, 15.4 or 15.4+)", version);
+        return false;
+    }
+
+    char *end;
+    row->offset = strtoull(offset, &end, 0);
+    if (end == offset || *end) {
+        error(line, "malformed offset", offset);
+        return false;
+    }
+
+    size_t length = strlen(pattern);
+    while (length && isspace((unsigned char) pattern[length - 1])) pattern[--length] = '\0';
+
+    if (!sig_parse(&row->sig, pattern)) {
+        error(line, "malformed pattern", pattern);
+        return false;
+    }
+
+    if (row->sig.anchor == -1) {
+        error(line, "pattern has no fixed bytes", pattern);
+        return false;
+    }
+
+    return true;
+}
+
+static void emit_bytes(FILE *out, const uint8_t *bytes, int length)
+{
+    fprintf(out, "{");
+    for (int i = 0; i < length; ++i) {
+        fprintf(out, "%s0x%02x", i ? "," : " ", bytes[i]);
+    }
+    fprintf(out, " }");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <signatures.txt> <dock_signatures.h>\n", argv[0]);
+        return 1;
+    }
+
+    path = argv[1];
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    struct row *rows = NULL;
+    int count = 0, capacity = 0, line = 0;
+    char buffer[4096];
+
+    while (fgets(buffer, sizeof(buffer), in)) {
+        ++line;
+
+        char *text = buffer;
+        while (isspace((unsigned char) *text)) ++text;
+        if (!*text || *text == '#') continue;
+
+        if (!strchr(buffer, '\n') && !feof(in)) {
+            error(line, "line too long", NULL);
+            break;
+        }
+
+        if (count == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            rows = realloc(rows, sizeof(struct row) * capacity);
+        }
+
+        if (!parse_row(&rows[count], text, line)) continue;
+
+        for (int i = 0; i < count; ++i) {
+            if (rows[i].arch == rows[count].arch &&
+                rows[i].major == rows[count].major &&
+                rows[i].minor == rows[count].minor &&
+                rows[i].match == rows[count].match &&
+                strcmp(rows[i].symbol, rows[count].symbol) == 0) {
+                char detail[32];
+                snprintf(detail, sizeof(detail), "first defined on line %d", rows[i].line);
+                error(line, "duplicate row", detail);
+            }
+        }
+
+        ++count;
+    }
+
+    fclose(in);
+
+    if (errors) {
+        fprintf(stderr, "%s: %d error(s)\n", path, errors);
+        return 1;
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "// Generated by tools/siggen from %s. Do not edit.\n", path);
+
+    for (int a = 0; a < (int)(sizeof(archs) / sizeof(*archs)); ++a) {
+        fprintf(out, "\nstatic const struct dock_signature dock_signatures_%s[] = {\n", archs[a]);
+
+        for (int i = 0; i < count; ++i) {
+            struct row *row = &rows[i];
+            if (row->arch != a) continue;
+
+            fprintf(out, "    { DOCK_SYMBOL_%s, %d, %d, %s, 0x%llx,\n", row->symbol, row->major, row->minor, row->match, (unsigned long long) row->offset);
+            fprintf(out, "      { %d, %d, %d,\n        ", row->sig.length, row->sig.anchor, row->sig.anchor2);
+            emit_bytes(out, row->sig.bytes, row->sig.length);
+            fprintf(out, ",\n        ");
+            emit_bytes(out, row->sig.mask, row->sig.length);
+            fprintf(out, " } },\n");
+        }
+
+        fprintf(out, "};\n");
+    }
+
+    if (fclose(out) != 0) {
+        perror(argv[2]);
+        remove(argv[2]);
+        return 1;
+    }
+
+    free(rows);
+    return 0;
+}